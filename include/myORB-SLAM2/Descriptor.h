@@ -0,0 +1,21 @@
+#ifndef DESCRIPTOR_H
+#define DESCRIPTOR_H
+
+#include <array>
+
+/*
+The number of bytes in a (256-bit) descriptor
+Notes: 'constexpr' ensures that this variable is known at compile time.*/
+constexpr int NBPD = 32;
+
+// Binary descriptor of NBITS bits, one bit per pattern pair.
+template<int NBITS>
+using DescriptorT = std::array<unsigned char, NBITS / 8>;
+
+// Define the 32-byte Descriptor data type.
+typedef DescriptorT<256> Descriptor;
+
+// 64-byte descriptor, e.g. for relocalization.
+typedef DescriptorT<512> Descriptor512;
+
+#endif
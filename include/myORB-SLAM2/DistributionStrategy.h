@@ -0,0 +1,104 @@
+#ifndef DISTRIBUTIONSTRATEGY_H
+#define DISTRIBUTIONSTRATEGY_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <opencv2/features2d.hpp>
+
+#include "myORB-SLAM2/RegionalQuadTree.h"
+
+using namespace cv;
+using namespace std;
+
+namespace my_ORB_SLAM2 {
+
+// 關鍵點均勻化策略的介面：從一層影像的關鍵點中挑出最多 nFeatures 個分布均勻的關鍵點
+class DistributionStrategy {
+    public:
+        virtual ~DistributionStrategy() {};
+
+        /*
+        @brief 均勻化一層影像的關鍵點，所有暫存空間都屬於策略本身，跨影格重複使用
+        
+        @param[in, out] vDistributedKeyPoints 均勻化後的關鍵點，會先被清空
+        @param[in] vKeyPoints 該層影像的關鍵點，策略可以保存指向它們的指標，但不會修改內容
+        @param[in] nFeatures 該層影像要提取的關鍵點數量
+        @param[in] area 該層影像中關鍵點所在的範圍，沒有遮罩時為整張影像，有遮罩時為遮罩中可以使用的 pixel 的外框，
+                        策略只在這個範圍內劃分空間，被遮住的部分不會佔用節點或格子
+        @param[in] nUsablePixels 範圍內可以使用的 pixel 數量，沒有遮罩時為範圍的面積，
+                                 依面積決定格子大小的策略以此為準，外框內被遮住的部分不會稀釋格子 */
+        virtual void distribute(
+            vector<KeyPoint> &vDistributedKeyPoints,
+            vector<KeyPoint> &vKeyPoints,
+            int nFeatures, const Rect &area, int nUsablePixels
+        ) = 0;
+};
+
+// 區域四叉樹：不斷分裂關鍵點最多的節點，直到節點數量達標，每個節點保留分數最高的關鍵點
+class QuadTreeDistribution : public DistributionStrategy {
+    public:
+        QuadTreeDistribution() {};
+        ~QuadTreeDistribution() {};
+
+        void distribute(
+            vector<KeyPoint> &vDistributedKeyPoints,
+            vector<KeyPoint> &vKeyPoints,
+            int nFeatures, const Rect &area, int nUsablePixels
+        ) override;
+    
+    private:
+        RegionalQuadTree mQuadTree; // 每一層影像共用的四叉樹，節點與關鍵點指標的記憶體跨影格重複使用
+        vector<int> mvnSplitHeap; // 等待分裂的節點索引，以節點內的關鍵點數量排列成 max-heap
+};
+
+// 網格分桶：把影像切成約 nFeatures 個格子，每個格子保留分數最高的 K 個關鍵點，只需要線性時間
+class GridBucketDistribution : public DistributionStrategy {
+    public:
+        GridBucketDistribution() {};
+        ~GridBucketDistribution() {};
+
+        void distribute(
+            vector<KeyPoint> &vDistributedKeyPoints,
+            vector<KeyPoint> &vKeyPoints,
+            int nFeatures, const Rect &area, int nUsablePixels
+        ) override;
+    
+    private:
+        vector<int> mvnCellOfKeyPoint; // 每個關鍵點所屬的格子
+        vector<int> mvnCellStarts; // 每個格子在 mvnBucketed 中的起點 (counting sort 的前綴和)
+        vector<int> mvnBucketed; // 依格子排列的關鍵點索引
+        vector<int> mvnSelected; // 每個格子的前 K 名
+        vector<int> mvnRemaining; // 沒有進入前 K 名的關鍵點，數量不足時從中補齊
+};
+
+/*
+Suppression via Square Covering (Bailo et al., 2018) 的自適應非極大值抑制：
+依分數由高到低保留關鍵點，並把它周圍邊長 2w 的正方形標記為已覆蓋，
+再以二分搜尋找出讓保留數量最接近 nFeatures 的 w */
+class SSCDistribution : public DistributionStrategy {
+    public:
+        /*
+        @brief SSC 自適應非極大值抑制
+        
+        @param[in] fTolerance 保留數量與 nFeatures 的相對誤差在此範圍內就停止搜尋 */
+        SSCDistribution(float fTolerance = 0.1f): mfTolerance(fTolerance) {};
+        ~SSCDistribution() {};
+
+        void distribute(
+            vector<KeyPoint> &vDistributedKeyPoints,
+            vector<KeyPoint> &vKeyPoints,
+            int nFeatures, const Rect &area, int nUsablePixels
+        ) override;
+
+        float mfTolerance; // 保留數量可接受的相對誤差
+    
+    private:
+        vector<int> mvnSorted; // 依分數由高到低排列的關鍵點索引
+        vector<int> mvnKept, mvnBestKept; // 目前與最後採用的 w 所保留的關鍵點索引
+        vector<uchar> mvbCovered; // 以 w/2 為邊長的覆蓋網格
+};
+
+}
+
+#endif
@@ -1,22 +1,50 @@
 #ifndef DISTRIBUTOR_H
 #define DISTRIBUTOR_H
 
-#include "myORB-SLAM2/RegionalQuadTree.h"
+#include "myORB-SLAM2/DistributionStrategy.h"
 
 namespace my_ORB_SLAM2 {
 
 class Distributor {
     public:
+        // 關鍵點均勻化策略
+        enum Strategy {
+            QUADTREE = 0,    // 區域四叉樹，每次分裂關鍵點最多的節點
+            GRID_BUCKET = 1, // 網格分桶，每個格子保留前 K 名，只需要線性時間
+            SSC = 2          // Suppression via Square Covering 自適應非極大值抑制
+        };
+
         /*
-        @brief 影像金字塔概念的關鍵點均勻器  */
+        @brief 影像金字塔概念的關鍵點均勻器，預設每一層都使用區域四叉樹  */
         Distributor() {};
         ~Distributor() {};
 
+        /*
+        @brief 設定所有層級使用的均勻化策略
+        
+        @param[in] eStrategy 均勻化策略 */
+        void setStrategy(Strategy eStrategy);
+
+        /*
+        @brief 設定某一層影像使用的均勻化策略
+        
+        @param[in] iLevel 影像金字塔的層級
+        @param[in] eStrategy 均勻化策略 */
+        void setStrategy(int iLevel, Strategy eStrategy);
+
+        /*
+        @brief 設定每一層影像的靜態遮罩 (例如 ImagePyramid::mvMasks)，之後每一層只在遮罩中可以使用的 pixel 的外框內劃分空間，
+        被遮住的部分 (例如引擎蓋、時間戳記) 不會佔用四叉樹的分裂或網格的格子，外框以外的關鍵點會在均勻化時被移除。
+        傳入空的 vector 代表不使用遮罩
+        
+        @param[in] vMasks 每一層影像的遮罩，非 0 代表可以使用，大小與該層影像不同時該層不使用遮罩 */
+        void setMasks(const vector<Mat> &vMasks);
+
         /*
         @brief 用於均勻化，對應於影像金字塔中每一層的關鍵點
         
         @param[in, out] vvDistributedKeyPointsPerLevel 用於取得均勻化的關鍵點容器
-        @param[in] vvKeyPointsPerLevel 對應於影像金字塔中每一層的關鍵點
+        @param[in, out] vvKeyPointsPerLevel 對應於影像金字塔中每一層的關鍵點，有遮罩時會移除遮罩外框以外的關鍵點
         @param[in] vnFeaturesPerLevel 對應於影像金字塔中每一層的待提取關鍵點數
         @param[in] vImagePerLevel 影像金字塔中每一層的影像 */
         void distribute(
@@ -25,6 +53,24 @@ class Distributor {
             vector<int> &vnFeaturesPerLevel,
             vector<Mat> &vImagePerLevel
         );
+    
+    private:
+        /*
+        @brief 取得某一層影像使用的均勻化策略
+        
+        @param[in] iLevel 影像金字塔的層級 */
+        DistributionStrategy* getStrategy(int iLevel);
+
+        // 每種策略各一個實例，各自保留跨影格重複使用的暫存空間
+        QuadTreeDistribution mQuadTreeDistribution;
+        GridBucketDistribution mGridBucketDistribution;
+        SSCDistribution mSSCDistribution;
+
+        Strategy meDefaultStrategy = QUADTREE; // 沒有個別設定的層級使用的策略
+        vector<Strategy> mveStrategiesPerLevel; // 每一層影像個別設定的策略
+        vector<Rect> mvMaskAreas; // 每一層影像遮罩中可以使用的 pixel 的外框，沒有遮罩時為空
+        vector<Size> mvMaskSizes; // 每一層影像遮罩的大小，與該層影像不同時不使用遮罩
+        vector<int> mvnMaskPixels; // 每一層影像遮罩中可以使用的 pixel 數量
 };
 
 }
@@ -0,0 +1,82 @@
+#ifndef FASTDETECTOR_H
+#define FASTDETECTOR_H
+
+#include <vector>
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace my_ORB_SLAM2 {
+
+class FASTDetector {
+    public:
+        // Instruction sets the segment test kernel can run on.
+        enum Instruction {
+            SCALAR = 0,
+            SSE2 = 1,
+            AVX2 = 2,
+            AVX512BW = 3
+        };
+
+        /*
+        @brief FAST-9 (16-pixel circle) detector using the best kernel the CPU supports. */
+        FASTDetector();
+
+        /*
+        @brief FAST-9 detector forced onto a specific kernel. 
+        
+        @param[in] eInstruction: Instruction set to use; it must be supported by this CPU. */
+        FASTDetector(Instruction eInstruction);
+        ~FASTDetector() {};
+
+        // Instruction set used by this detector.
+        Instruction meInstruction;
+
+        /*
+        @brief Query CPUID once and return the widest supported instruction set. */
+        static Instruction detectInstruction();
+
+        /*
+        @brief Check whether this CPU can run a given kernel.
+
+        @param[in] eInstruction: Instruction set to check. */
+        static bool isSupported(Instruction eInstruction);
+
+        /*
+        @brief Write the FAST-9 score of every pixel in a region into a score map.
+        Pixels that are not corners at iThreshold get 0, so a corner at any threshold t >= iThreshold
+        is exactly a pixel whose score is >= t. Scores are identical to those reported by cv::FAST.
+
+        @param[in] image: 8-bit single-channel image.
+        @param[in, out] scoreMap: 8-bit map with the same size as image. Only pixels inside roi are written.
+        @param[in] roi: Region to score. It must stay at least 3 pixels away from the image border.
+        @param[in] iThreshold: Segment test threshold, clamped to [1, 255]. */
+        void computeScores(const Mat &image, Mat &scoreMap, const Rect &roi, int iThreshold);
+
+        /*
+        @brief Detect FAST-9 corners. The output matches cv::FAST(image, vKeyPoints, iThreshold, bNonmaxSuppression).
+
+        @param[in] image: 8-bit single-channel image.
+        @param[in, out] vKeyPoints: Detected corners, in row-major order.
+        @param[in] iThreshold: Segment test threshold, clamped to [1, 255].
+        @param[in] bNonmaxSuppression: Whether to keep only local maxima of the 3x3 neighbourhood. */
+        void detect(const Mat &image, vector<KeyPoint> &vKeyPoints, int iThreshold, bool bNonmaxSuppression = true);
+
+        /*
+        @brief Grow the score buffer of detect() in advance, so images up to this size never allocate.
+
+        @param[in] nRows: Largest image height passed to detect().
+        @param[in] nCols: Largest image width passed to detect(). */
+        void reserve(int nRows, int nCols);
+
+    private:
+        // Score buffer used by detect(); it only grows.
+        Mat mScoreBuffer;
+};
+
+} // my_ORB_SLAM2
+
+#endif
@@ -3,37 +3,106 @@
 
 #include <opencv2/features2d.hpp>
 #include <chrono>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "myORB-SLAM2/Descriptor.h"
 
 using namespace cv;
 using namespace std;
 
-// Define the 32-byte Descriptor data type.
-typedef array<unsigned char, 32> Descriptor;
-
 // Define the time point type.
 typedef chrono::steady_clock::time_point TimePoint;
 
+// The number of cells of the grid each frame is divided into.
+#define FRAME_GRID_COLS 64
+#define FRAME_GRID_ROWS 48
+
 namespace my_ORB_SLAM2 {
 
+class FramePool;
+
+/*
+The pool that pooled frames return to, shared by the pool and its frames. The pool clears mpPool under mMutex
+when it is destroyed, and a frame returns to the pool under mMutex, so a frame released at that moment either
+goes back to the pool before the pool goes away or finds mpPool cleared and deletes itself. */
+struct FramePoolLink {
+    mutex mMutex;
+    FramePool* mpPool;
+};
+
 class Frame {
     public:
         /*
-        @brief Constructor for a regular frame object.
-        
-        @param[in] vfScaleFactors: Scale factor of each level used to map coordinates back to level 0. 
-        @param[in] vvKeyPointsPerLevel: Keypoints in the pyramid. 
+        Keypoints and descriptors of one pyramid level, pointing into the arrays of the frame.
+        Coordinates are mapped to level 0. */
+        struct LevelView {
+            const float* pfX;
+            const float* pfY;
+            const float* pfAngle;
+            const float* pfResponse;
+            const Descriptor* pDescriptors;
+            int nKeyPoints;
+            int iLevel;
+            float fScaleFactor;
+
+            /*
+            @brief Rebuild the i-th keypoint of this level, e.g. for drawing.
+            The size is not stored: it is the diameter of the FAST circle (7 pixels) at this level, in level-0 pixels.
+
+            @param[in] i: The index of the keypoint in this level. */
+            KeyPoint getKeyPoint(int i) const {
+                return KeyPoint(pfX[i], pfY[i], 7.f * fScaleFactor, pfAngle[i], pfResponse[i], iLevel);
+            }
+        };
+
+        /*
+        @brief Constructor for a regular frame object. Keypoints and descriptors are copied into the frame's
+        arrays, so the caller keeps (and can reuse) its containers.
+
+        @param[in] imageSize: Size of the image at level 0, which the grid covers.
+        @param[in] vfScaleFactors: Scale factor of each level used to map coordinates back to level 0.
+        @param[in] vvKeyPointsPerLevel: Keypoints in the pyramid.
         @param[in] vvDescriptorsPerLevel: Descriptors in the pyramid. */
         Frame(
+            const Size& imageSize,
             const vector<float>& vfScaleFactors,
-            vector<vector<KeyPoint>>* pvvKeyPointsPerLevel,
-            vector<vector<Descriptor>>* pvvDescriptorsPerLevel
+            const vector<vector<KeyPoint>>& vvKeyPointsPerLevel,
+            const vector<vector<Descriptor>>& vvDescriptorsPerLevel
         );
+        ~Frame() {};
 
-        // Delete mvvKeyPointsPerLevel and mvvDescriptorsPerLevel because of dynamic allocation.
-        ~Frame() {
-            delete mpvvKeyPointsPerLevel;
-            delete mpvvDescriptorsPerLevel;
-        };
+        // The reference count lives in the frame, so frames are not copied.
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+
+        /*
+        @brief The keypoints and descriptors of one pyramid level.
+
+        @param[in] iLevel: The pyramid level. */
+        LevelView getLevel(int iLevel) const;
+
+        /*
+        @brief Rebuild a keypoint from the arrays, see LevelView::getKeyPoint.
+
+        @param[in] i: The index of the keypoint in the frame. */
+        KeyPoint getKeyPoint(int i) const;
+
+        /*
+        @brief Find the keypoints within a square window, using the grid.
+
+        @param[in, out] vnIndices: The indices of the keypoints whose level-0 coordinates are less than fRadius away
+                                   from (fX, fY) along both axes.
+        @param[in] fX, fY: The center of the window, in level-0 pixels.
+        @param[in] fRadius: The half size of the window.
+        @param[in] nMinLevel, nMaxLevel: The range of levels to keep; a negative value leaves that side open. */
+        void getFeaturesInArea(
+            vector<int>& vnIndices,
+            float fX, float fY, float fRadius,
+            int nMinLevel = -1, int nMaxLevel = -1
+        ) const;
 
         // ID for this frame and for the next frame to be created
         static unsigned long mNextID;
@@ -45,16 +114,99 @@ class Frame {
         // Frame time stamp
         TimePoint mTimePoint;
 
-        // Scale Factors, Keypoints and descriptors of this frame
+        // Scale Factors of the pyramid levels.
         vector<float> mvfScaleFactors;
-        vector<vector<KeyPoint>>* mpvvKeyPointsPerLevel;
-        vector<vector<Descriptor>>* mpvvDescriptorsPerLevel;
-        
-        // Divide this frame into 64 * 48 grids.
-        // Each grid contains the indices of the keypoints within its area.
-        vector<int> mGrid[64][48]; // (cols, rows)
+
+        // The number of keypoints in all levels. Level i holds the keypoints [mvnLevelOffsets[i], mvnLevelOffsets[i + 1]).
+        int mnKeyPoints;
+        vector<int> mvnLevelOffsets;
+
+        // Keypoints as structure of arrays (coordinates mapped to level 0), and their descriptors.
+        // Arrays are padded to a multiple of 8 keypoints, so each starts on a 32-byte boundary (the block on a 64-byte one).
+        float* mpfX;
+        float* mpfY;
+        float* mpfAngle;
+        float* mpfResponse;
+        uint8_t* mpnOctave;
+        Descriptor* mpDescriptors;
+
+        // Divide this frame into FRAME_GRID_COLS * FRAME_GRID_ROWS cells, stored row by row.
+        // The keypoints of cell c are mvnGridIndices[mvnGridOffsets[c]] to mvnGridIndices[mvnGridOffsets[c + 1] - 1].
+        vector<int> mvnGridOffsets;
+        vector<int> mvnGridIndices;
+        float mfGridCellWidthInv;
+        float mfGridCellHeightInv;
+
+        /*
+        @brief Take and drop references, see FramePtr. */
+        void addReference() { mnReferences.fetch_add(1, memory_order_relaxed); }
+        void releaseReference();
+
+    private:
+        friend class FramePool;
+
+        /*
+        @brief An empty frame of a pool, filled by assign(). The storage of pooled frames grows with headroom,
+        so that recycling them for frames with a few more keypoints does not reallocate.
+
+        @param[in] pPoolLink: The link to the pool the frame returns to. */
+        explicit Frame(const shared_ptr<FramePoolLink>& pPoolLink): mnReferences(0), mpPoolLink(pPoolLink) {}
+
+        /*
+        @brief Fill the frame with new data as a new frame, reusing the storage it already has.
+        The parameters are those of the constructor. */
+        void assign(
+            const Size& imageSize,
+            const vector<float>& vfScaleFactors,
+            const vector<vector<KeyPoint>>& vvKeyPointsPerLevel,
+            const vector<vector<Descriptor>>& vvDescriptorsPerLevel
+        );
+
+        /*
+        @brief Sort the keypoint indices by grid cell. */
+        void assignToGrid();
+
+        /*
+        @brief The grid cell of a keypoint.
+
+        @param[in] i: The index of the keypoint in the frame. */
+        int getCell(int i) const;
+
+        // The number of FramePtr to this frame, and the link to the pool it returns to when there is none left
+        // (nullptr: the frame is not pooled and is deleted).
+        atomic<int> mnReferences;
+        shared_ptr<FramePoolLink> mpPoolLink;
+
+        // The single block that holds all the arrays, kept when the frame is recycled.
+        Mat mBuffer;
+};
+
+/*
+Intrusive shared pointer to a frame allocated with new or taken from a FramePool.
+When the last FramePtr to a frame goes away, the frame goes back to its pool, or is deleted if it has none. */
+class FramePtr {
+    public:
+        FramePtr(): mpFrame(nullptr) {}
+        explicit FramePtr(Frame* pFrame): mpFrame(pFrame) { if(mpFrame) { mpFrame->addReference(); } }
+        FramePtr(const FramePtr& other): FramePtr(other.mpFrame) {}
+        FramePtr(FramePtr&& other) noexcept: mpFrame(other.mpFrame) { other.mpFrame = nullptr; }
+        ~FramePtr() { if(mpFrame) { mpFrame->releaseReference(); } }
+
+        FramePtr& operator=(FramePtr other) noexcept { std::swap(mpFrame, other.mpFrame); return *this; }
+
+        // Drop the reference.
+        void reset() { FramePtr().swap(*this); }
+        void swap(FramePtr& other) noexcept { std::swap(mpFrame, other.mpFrame); }
+
+        Frame* get() const { return mpFrame; }
+        Frame& operator*() const { return *mpFrame; }
+        Frame* operator->() const { return mpFrame; }
+        explicit operator bool() const { return mpFrame != nullptr; }
+
+    private:
+        Frame* mpFrame;
 };
 
 } // my_ORB_SLAM2
 
-#endif
\ No newline at end of file
+#endif
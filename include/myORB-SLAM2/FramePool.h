@@ -0,0 +1,82 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <vector>
+#include <mutex>
+#include <memory>
+
+#include "myORB-SLAM2/Frame.h"
+
+using namespace std;
+
+namespace my_ORB_SLAM2 {
+
+class FramePool {
+    public:
+        /*
+        @brief Frames whose storage (keypoint arrays, descriptor block and grid) is reused once they are no longer
+        referenced, so a long sequence does not allocate and free these blocks for every frame.
+        Frames still in use when the pool is destroyed are deleted by their last FramePtr instead.
+
+        @param[in] nMaxResidentFrames: The maximum number of frames alive at the same time, in use or free.
+                                       0 means no limit. */
+        FramePool(int nMaxResidentFrames = 0);
+        ~FramePool();
+
+        /*
+        @brief Take a free frame, or create one, and fill it as the constructor of Frame does.
+        Returns an empty FramePtr when mnMaxResidentFrames frames are already in use.
+
+        @param[in] imageSize: Size of the image at level 0, which the grid covers.
+        @param[in] vfScaleFactors: Scale factor of each level used to map coordinates back to level 0.
+        @param[in] vvKeyPointsPerLevel: Keypoints in the pyramid.
+        @param[in] vvDescriptorsPerLevel: Descriptors in the pyramid. */
+        FramePtr acquire(
+            const Size& imageSize,
+            const vector<float>& vfScaleFactors,
+            const vector<vector<KeyPoint>>& vvKeyPointsPerLevel,
+            const vector<vector<Descriptor>>& vvDescriptorsPerLevel
+        );
+
+        /*
+        @brief Change the maximum number of resident frames. Free frames above the limit are deleted at once,
+        frames in use when they are released.
+
+        @param[in] nMaxResidentFrames: The maximum number of frames alive at the same time, 0 means no limit. */
+        void setMaxResidentFrames(int nMaxResidentFrames);
+
+        /*
+        @brief Delete the free frames. */
+        void shrink();
+
+        // The number of frames alive (in use or free), and of free frames.
+        int getResidentFrames();
+        int getFreeFrames();
+
+    private:
+        friend class Frame;
+
+        /*
+        @brief Take back a frame whose last reference was dropped.
+
+        @param[in] pFrame: The frame. */
+        void recycle(Frame* pFrame);
+
+        /*
+        @brief Delete free frames until at most nResidentFrames frames are alive or no frame is free. Called under mMutex.
+
+        @param[in] nResidentFrames: The number of resident frames to go down to. */
+        void deleteFreeFrames(int nResidentFrames);
+
+        mutex mMutex;
+        vector<Frame*> mvpFreeFrames;
+        int mnResidentFrames = 0;
+        int mnMaxResidentFrames;
+
+        // Shared with every frame of the pool, cleared when the pool is destroyed so that frames still in use delete themselves.
+        shared_ptr<FramePoolLink> mpLink;
+};
+
+} // my_ORB_SLAM2
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef GAUSSIANFILTER_H
+#define GAUSSIANFILTER_H
+
+#include <vector>
+#include <cstring>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace my_ORB_SLAM2 {
+
+/*
+7x7 Gaussian filter (sigma = 2) with reflect-101 borders, used for descriptor computation.
+By default it is GaussianBlur(image, blurredImage, Size(7, 7), 2, 2), so descriptors are bit-identical to the ones
+computed on a GaussianBlur image. FIXED_POINT is an opt-in approximation with 8-bit fixed-point weights:
+a pixel may differ from OpenCV by one intensity level, which flips a few intensity comparisons
+(testGaussianFilter_00 pins both), but it allocates nothing once its buffers have grown.
+
+Rows can be pushed one at a time while the image is being produced (e.g. by the image pyramid).
+With FIXED_POINT each row is filtered horizontally into a ring of 8 rows, and a blurred row is written as soon as
+the 3 rows below it are available, so the filter never reads the whole image a second time.
+With OPENCV the rows are collected and the whole image is blurred in end(). */
+class GaussianFilter {
+    public:
+        // Implementations of the filter.
+        enum Implementation {
+            OPENCV = 0,     // GaussianBlur, bit-identical to OpenCV
+            FIXED_POINT = 1 // 8-bit fixed-point weights, at most one intensity level away from OpenCV
+        };
+
+        /*
+        @brief Gaussian filter that runs GaussianBlur. */
+        GaussianFilter() {};
+
+        /*
+        @brief Gaussian filter with a specific implementation.
+
+        @param[in] eImplementation: The implementation to use. */
+        GaussianFilter(Implementation eImplementation) : meImplementation(eImplementation) {};
+        ~GaussianFilter() {};
+
+        // Implementation used by this filter.
+        Implementation meImplementation = OPENCV;
+
+        /*
+        @brief Blur a whole image.
+
+        @param[in] image: The 8-bit image to be blurred.
+        @param[in, out] blurredImage: The blurred image, reallocated only when its size changes. */
+        void apply(const Mat& image, Mat& blurredImage);
+
+        /*
+        @brief Blur only a region of an image, with exactly the values apply would write there.
+
+        @param[in] image: The 8-bit image to be blurred.
+        @param[in, out] blurredImage: The blurred image, with the same size as image. Only the region is written.
+        @param[in] roi: The region to be blurred, inside the image. */
+        void applyRegion(const Mat& image, Mat& blurredImage, const Rect& roi);
+
+        /*
+        @brief Start blurring an image that will be pushed row by row.
+
+        @param[in] size: The size of the image.
+        @param[in, out] blurredImage: The blurred image, reallocated only when its size changes.
+        It must stay alive until end() is called. */
+        void begin(Size size, Mat& blurredImage);
+
+        /*
+        @brief Push the next row of the image, top to bottom.
+
+        @param[in] pRow: The pixels of the row. */
+        void pushRow(const uchar* pRow);
+
+        /*
+        @brief Write the last blurred rows once every row has been pushed. */
+        void end();
+
+    private:
+        /*
+        @brief Write one blurred row from the horizontally filtered rows in the ring.
+
+        @param[in] iY: The row to be written. */
+        void filterVertical(int iY);
+
+        // Gaussian kernel of size 7 and sigma 2, scaled so that the weights sum to 256.
+        const int mGaussianKernel[4] = {54, 49, 34, 18}; // (center, 1, 2, 3 pixels away)
+
+        // The 8 most recent horizontally filtered rows (16-bit, not rounded yet) and a padded source row.
+        // Both only grow, so nothing is allocated once the largest image has been filtered.
+        Mat mRingBuffer;
+        vector<uchar> mvPaddedRow;
+
+        // With OPENCV, the pushed rows (a header into a buffer that only grows) and a blurred region with its margin.
+        Mat mSourceBuffer, mSourceImage;
+        Mat mRegionBuffer;
+
+        // The image being blurred.
+        Mat* mpBlurredImage = nullptr;
+        int mnRows = 0, mnCols = 0;
+        int mnPushedRows = 0; // Rows pushed so far
+        int mnWrittenRows = 0; // Blurred rows written so far
+};
+
+} // my_ORB_SLAM2
+
+#endif
\ No newline at end of file
@@ -4,10 +4,16 @@
 #include <vector>
 #include <list>
 #include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include "myORB-SLAM2/GaussianFilter.h"
+
 using namespace cv;
 using namespace std;
 
@@ -16,27 +22,231 @@ namespace my_ORB_SLAM2 {
 class ImagePyramid {
     public :
         /*
-        @brief 影像金字塔
+        @brief 影像金字塔：所有層級 (以及模糊影像) 放在同一塊對齊的記憶體 (atlas) 中，
+        每一層影像四周都有複製邊緣 pixel 的邊界，mvImages 與 mvBlurredImages 是指向 atlas 的 cv::Mat header，
+        所以 image.step 會大於 image.cols，讀取鄰近 pixel 時要以 step 計算位移
         
-        @param[in] nLevels 影像金字塔的層數
+        @param[in] nLevels 影像金字塔的層數 (最多 64 層)
         @param[in] fScaleFactor 每層之間的縮放因子 (例如 1.2) 
-        @param[in] nFeatures 總共需要提取的特徵點數量 */
-        ImagePyramid (int nLevels, float fScaleFactor, int nFeatures);
+        @param[in] nFeatures 總共需要提取的特徵點數量
+        @param[in] nBorder 每一層影像四周邊界的寬度，需要涵蓋方向與描述子計算的取樣半徑，
+                           影像邊緣的關鍵點才不會讀到邊界外 */
+        ImagePyramid (int nLevels, float fScaleFactor, int nFeatures, int nBorder = 19);
         ~ImagePyramid () {};
 
+        // 縮小影像的方式
+        enum Interpolation {
+            NEAREST = 0, // 每一層影像由上一層影像以最近鄰插值縮小 (與 cv::resize 的 INTER_NEAREST 相同)，各層必須依序建立
+            AREA = 1     // 每一層影像直接由第 0 層影像以面積平均縮小 (定點數權重，與精確的面積平均最多差 1)，不會產生鋸齒，各層可以同時建立
+        };
+
         // 設定影像 : 將不同縮放倍率的影像依序放入影像金字塔中
         void setImage(const Mat &image);
 
+        /*
+        @brief 設定縮小影像的方式，預設為 NEAREST
+        
+        @param[in] eInterpolation 縮小影像的方式 */
+        void setInterpolation(Interpolation eInterpolation);
+
+        /*
+        @brief 分層建立影像金字塔的第一步：規劃 atlas 並把每一層影像標記為尚未完成，之後再以 buildLevel 建立每一層影像。
+        setImage 就是依序建立每一層影像；KeyPointExtractor 則可以把 buildLevel 與提取關鍵點交給同一組執行緒，
+        第 0 層影像完成後就開始提取，較高層的影像同時由其他執行緒建立
+        
+        @param[in] image 影像金字塔的影像，所有層級完成前都必須保持有效
+        @param[in] nThreads 會呼叫 buildLevel 的執行緒數量，每個執行緒各自擁有暫存記憶體與高斯濾波器 */
+        void beginImage(const Mat &image, int nThreads = 1);
+
+        /*
+        @brief 建立一層影像 (以及模糊影像與邊界)，完成後通知等待該層影像的執行緒。
+        NEAREST 模式下會先等待上一層影像完成，所以要依層級由小到大開始建立，避免所有執行緒都在等待
+        
+        @param[in] iLevel 影像金字塔的層級
+        @param[in] iThread 執行緒的編號 (0 ~ nThreads-1)，同時執行的執行緒編號不可相同 */
+        void buildLevel(int iLevel, int iThread = 0);
+
+        /*
+        @brief 開始以列為單位接收影像 (例如相機逐列以 DMA 傳入)，之後以 pushRows 依序傳入第 0 層影像的每一列。
+        每次傳入後，所有層級中輸入已經足夠的列就會立刻建立，不需要等待整張影像
+        
+        @param[in] size 第 0 層影像的大小 */
+        void beginStream(Size size);
+
+        /*
+        @brief 傳入第 0 層影像接下來的數列，並建立每一層影像中已經可以建立的列，整層完成時標記該層影像已經完成
+        
+        @param[in] rows 接下來的數列，寬度與影像相同，超過影像高度的列會被忽略 */
+        void pushRows(const Mat &rows);
+
+        /*
+        @brief 一層影像中已經建立好 (含左右邊界) 的列數，整層完成時等於影像高度，且上下邊界與模糊影像也已經完成
+        
+        @param[in] iLevel 影像金字塔的層級 */
+        int getAvailableRows(int iLevel) const { return mvnAvailableRows[iLevel]; }
+
+        /*
+        @brief 等待一層影像完成
+        
+        @param[in] iLevel 影像金字塔的層級 */
+        void waitLevel(int iLevel);
+
+        /*
+        @brief 一層影像是否已經完成
+        
+        @param[in] iLevel 影像金字塔的層級 */
+        bool isLevelReady(int iLevel) const {
+            return (mnReadyLevels.load(memory_order_acquire) >> iLevel) & 1;
+        }
+
+        /*
+        @brief 設定相機的靜態遮罩 (例如引擎蓋、時間戳記等永遠無法使用的區域)，並以最近鄰取樣建立每一層影像的遮罩 mvMasks：
+        某一層的 pixel 對應回第 0 層的位置 (座標乘上縮小倍數) 被遮住時，該 pixel 也被遮住。
+        同時依每一層可以使用的面積比例重新分配 mvnFeaturesPerLevel，總數仍然是 mnFeatures。
+        使用自適應閾值時，需要在設定遮罩之後再把新的 mvnFeaturesPerLevel 交給 KeyPointExtractor。
+        已經設定過影像時，遮罩的大小必須與影像相同；之後設定的影像大小不同時，KeyPointExtractor 與 Distributor 不會使用遮罩
+        
+        @param[in] mask 與第 0 層影像同大小的 8-bit 遮罩 (CV_8U)，非 0 代表可以使用；傳入空的 Mat 代表不使用遮罩 */
+        void setMask(const Mat &mask);
+
+        /*
+        @brief 設定是否同時建立模糊影像金字塔 (mvBlurredImages)，供 DescriptorComputer::computeBlurred 直接使用。
+        每一層影像在縮小的同時逐列交給 7x7 高斯濾波器，模糊結果與 DescriptorComputer::blur 相同
+        
+        @param[in] bEnable 是否建立模糊影像金字塔 */
+        void enableBlurredPyramid(bool bEnable = true);
+
+        /*
+        @brief 設定模糊影像金字塔是否使用 8-bit 定點數的高斯模糊 (GaussianFilter::FIXED_POINT)，預設使用 GaussianBlur。
+        定點數版本在縮小的同時逐列模糊，不需要再讀一次整張影像，也不會配置記憶體，但可能與 GaussianBlur 差一個灰階，
+        需要與 DescriptorComputer::setFixedPointBlur 設定相同，描述子才會與 DescriptorComputer::compute 相同
+        
+        @param[in] bEnable 是否使用定點數的高斯模糊 */
+        void setFixedPointBlur(bool bEnable);
+
         int mnLevels; // 影像金字塔的層數
+        int mnBorder; // 每一層影像四周邊界的寬度
         int mnFeatures; // 總共需要提取的特徵點數量
         float mfScaleFactor; // 每層之間的縮放係數
 
         vector<int> mvnFeaturesPerLevel; // 儲存每一層影像中應提取的「特徵點數」
         vector<float> mvfScaleFactors; // 儲存每一層影像相較於第一層影像的「縮小倍數」
         vector<float> mvfInvScaleFactors; // 儲存每一層影像恢復為第一層影像大小所需的「縮放倍數」
-        vector<Mat> mvImages; // 儲存每一層影像的矩陣
+        vector<Mat> mvImages; // 儲存每一層影像的矩陣 (指向 atlas 的 header，不含邊界)
+        vector<Mat> mvBlurredImages; // 儲存每一層影像經過高斯模糊的矩陣，只有啟用模糊影像金字塔時才會更新
+        vector<Mat> mvMasks; // 儲存每一層影像的遮罩 (非 0 代表可以使用)，沒有設定遮罩時為空
     
     private :
+        /*
+        @brief 計算每一層影像應提取的特徵點數量：每一層的權重為縮放因子的等比數列，再乘上該層可以使用的面積比例，
+        最後一層 (可以使用的) 影像取得剩下的數量，讓總數維持 mnFeatures
+        
+        @param[in] vfUsableRatios 每一層影像可以使用的面積比例，空的 vector 代表沒有遮罩 */
+        void computeFeaturesPerLevel(const vector<float> &vfUsableRatios);
+
+        /*
+        @brief 依第 0 層影像的大小規劃 atlas：每一層影像 (含邊界) 依序由左到右放入一列，放不下時換到下一列，
+        每一層影像第一個 pixel 的位址對齊 64 bytes，模糊影像金字塔放在原始影像的下方。
+        影像大小不變時沿用上一次的 atlas
+        
+        @param[in] size 第 0 層影像的大小 */
+        void allocateAtlas(Size size);
+
+        /*
+        @brief 讓每個高斯濾波器使用目前設定的實作 (setFixedPointBlur)，濾波器數量增加後呼叫 */
+        void setFilterImplementation();
+
+        /*
+        @brief 把影像最外圈的 pixel 複製到四周 mnBorder 寬的邊界中 (與 BORDER_REPLICATE 相同)。
+        只處理 [iRowBegin, iRowEnd) 的左右邊界，包含第一列時填入上邊界，包含最後一列時填入下邊界
+        
+        @param[in, out] image 指向 atlas 的影像 header，四周必須各有 mnBorder 的空間
+        @param[in] iRowBegin, iRowEnd 要處理的列 */
+        void replicateBorder(Mat &image, int iRowBegin, int iRowEnd);
+
+        /*
+        @brief 以最近鄰插值把上一層影像縮小為該層影像，取樣位置與 cv::resize 的 INTER_NEAREST 相同，
+        但是不會在內部配置暫存記憶體，直接寫入 atlas 中該層影像的位置
+        
+        @param[in] src 上一層影像
+        @param[in] iLevel 影像金字塔的層級
+        @param[in] iRowBegin, iRowEnd 要建立的列
+        @param[in] pGaussianFilter 逐列模糊該層影像的高斯濾波器，不建立模糊影像時為 nullptr */
+        void resizeNearest(const Mat &src, int iLevel, int iRowBegin, int iRowEnd, GaussianFilter *pGaussianFilter);
+
+        // 面積平均縮小在一個方向上的取樣方式：輸出的第 i 個 pixel 是輸入 [vnStarts[i], vnStarts[i] + nTaps) 的加權和，
+        // 權重為 vnWeights[i * nStride + k]，超過 nTaps 的部分是 0
+        struct AreaKernel {
+            int nSrc = 0, nDst = 0; // 輸入、輸出的 pixel 數量
+            int nTaps = 0; // 每個輸出 pixel 使用的輸入 pixel 數量
+            int nStride = 0; // 每個輸出 pixel 的權重數量 (nTaps 補齊到 nTapsAlignment 的倍數)
+            vector<int> vnStarts;
+            vector<int16_t> vnWeights;
+        };
+
+        /*
+        @brief 計算一個方向上的面積平均取樣方式，輸入、輸出的大小不變時沿用上一次的結果
+        
+        @param[in, out] kernel 取樣方式
+        @param[in] nSrc 輸入的 pixel 數量
+        @param[in] nDst 輸出的 pixel 數量
+        @param[in] nWeightSum 每個輸出 pixel 的權重總和
+        @param[in] nTapsAlignment 權重數量補齊的單位，SIMD 一次讀取 8 個權重時為 8 */
+        static void computeAreaKernel(AreaKernel &kernel, int nSrc, int nDst, int nWeightSum, int nTapsAlignment);
+
+        /*
+        @brief 以面積平均把第 0 層影像直接縮小為該層影像，寫入 atlas 中該層影像的位置。
+        每一列先在垂直方向合併輸入影像的數列 (權重總和 128，結果不超過 16-bit)，再在水平方向合併 (權重總和 256)，兩個方向都使用 SSE2
+        
+        @param[in] iLevel 影像金字塔的層級
+        @param[in] iThread 執行緒的編號，用來選擇暫存記憶體
+        @param[in] iRowBegin, iRowEnd 要建立的列
+        @param[in] pGaussianFilter 逐列模糊該層影像的高斯濾波器，不建立模糊影像時為 nullptr */
+        void resizeArea(int iLevel, int iThread, int iRowBegin, int iRowEnd, GaussianFilter *pGaussianFilter);
+
+        /*
+        @brief 建立一層影像的前 iRowEnd 列需要的來源影像列數 (NEAREST 為上一層影像，AREA 為第 0 層影像)
+        
+        @param[in] iLevel 影像金字塔的層級 (大於 0)
+        @param[in] iRowEnd 該層影像的列數 */
+        int getSourceRowEnd(int iLevel, int iRowEnd) const;
+
+        /*
+        @brief 逐列接收影像時，一層影像新建立了 [iRowBegin, iRowEnd) 列：填入左右邊界，整層完成時再完成模糊影像與上下邊界
+        
+        @param[in] iLevel 影像金字塔的層級
+        @param[in] iRowBegin, iRowEnd 新建立的列 */
+        void finishStreamRows(int iLevel, int iRowBegin, int iRowEnd);
+
+        /*
+        @brief 標記一層影像已經完成，並喚醒等待的執行緒
+        
+        @param[in] iLevel 影像金字塔的層級 */
+        void markLevelReady(int iLevel);
+
+        Mat mAtlas; // 所有層級影像與模糊影像共用的記憶體
+        vector<Rect> mvLevelRects; // 每一層影像 (不含邊界) 在 atlas 中的位置，模糊影像在其下方 mnAtlasRows 列
+        Size mAtlasImageSize; // 規劃 atlas 時第 0 層影像的大小
+        int mnAtlasRows = 0; // 原始影像部分在 atlas 中的列數
+        bool mbAtlasBlurred = false; // atlas 是否包含模糊影像金字塔
+
+        vector<vector<int>> mvvnXOffsets; // 每一層影像的每個 column 在上一層影像中的取樣位置，影像大小改變時才重新計算
+        vector<int> mvnSourceCols; // 計算 mvvnXOffsets 時上一層影像的寬度
+
+        Interpolation meInterpolation = NEAREST; // 縮小影像的方式
+        vector<AreaKernel> mvXKernels, mvYKernels; // 每一層影像在水平、垂直方向的面積平均取樣方式
+        vector<vector<int16_t>> mvvnRowBuffers; // 每個執行緒各自的暫存列 (垂直方向合併的結果)，跨影格重複使用
+
+        const Mat *mpSourceImage = nullptr; // 正在建立的影像金字塔的影像
+        vector<int> mvnAvailableRows; // 逐列接收影像時，每一層影像已經建立好的列數
+        atomic<uint64_t> mnReadyLevels{0}; // 已經完成的層級 (第 i 個 bit 代表第 i 層)
+        mutex mReadyMutex;
+        condition_variable mcvLevelReady;
+
+        bool mbBlurredPyramid = false; // 是否同時建立模糊影像金字塔
+        bool mbFixedPointBlur = false; // 模糊影像金字塔是否使用定點數的高斯模糊
+        vector<GaussianFilter> mvGaussianFilters; // 每個執行緒各自逐列模糊影像的高斯濾波器，跨影格重複使用暫存記憶體
+
         // 輸出影像金字塔相關資訊
         void info() {
             printf("Image Pyramid Information: \n");
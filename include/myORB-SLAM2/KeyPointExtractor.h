@@ -2,9 +2,16 @@
 #define KEYPOINTEXTRACTOR_H
 
 #include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
 
 #include <opencv2/features2d.hpp>
 
+#include "myORB-SLAM2/FASTDetector.h"
+#include "myORB-SLAM2/ThreadPool.h"
+#include "myORB-SLAM2/ImagePyramid.h"
+
 using namespace cv;
 using namespace std;
 
@@ -12,16 +19,34 @@ namespace my_ORB_SLAM2 {
 
 class KeyPointExtractor {
     public:
+        // 一層影像在一次提取中的統計
+        struct LevelStatistics {
+            long nCells = 0; // 實際處理的 Grid 數量
+            long nFallbackCells = 0; // 在 miMaxTh 下找不到角點，改用 miMinTh 的 Grid 數量
+            long nEmptyCells = 0; // 在 miMinTh 下仍然找不到角點的 Grid 數量
+            long nRawCorners = 0; // 交給 Distributor 之前的原始角點數量
+            long nThresholdSum = 0; // 每個 Grid 一開始使用的閾值總和，用來計算平均閾值
+            long nSuppressedCorners = 0; // 跨 Grid 非極大值抑制所移除的角點數量
+        };
+
+        // 關鍵點提取模式
+        enum Mode {
+            GRID_FAST = 0, // 每個 Grid 各自呼叫一次 FAST
+            SCORE_MAP = 1  // 每層影像只計算一次 FAST 分數並寫入分數圖，再依 Grid 分桶
+        };
+
         /*
         @brief 影像金字塔概念的關鍵點提取器
         
         @param[in] mnLevels 影像金字塔的層數
         @param[in] mfDefaultGridSize 預設每個小格子的尺寸
-        @param[in] mnPaddingPixels 邊緣向內部填充的 pixels 數量
+        @param[in] mnPaddingPixels 邊緣向內部填充的 pixels 數量，至少為 3 (FAST 的半徑)。
+                                   影像金字塔的邊界涵蓋方向與描述子的取樣半徑時，可以設為 3 以提取影像邊緣的關鍵點
         @param[in] mnKeyPoints 總共要提取的關鍵點數量
         @param[in] miMaxTh 一開始提取關鍵點時使用的閾值
-        @param[in] miMinTh 放寬標準後，提取關鍵點的閾值 */
-        KeyPointExtractor(int mnLevels, float mfDefaultGridSize, int mnPaddingPixels, int mnKeyPoints, int miMaxTh, int miMinTh);
+        @param[in] miMinTh 放寬標準後，提取關鍵點的閾值
+        @param[in] meMode 關鍵點提取模式 */
+        KeyPointExtractor(int mnLevels, float mfDefaultGridSize, int mnPaddingPixels, int mnKeyPoints, int miMaxTh, int miMinTh, Mode meMode = GRID_FAST);
         ~KeyPointExtractor() {};
 
         /*
@@ -33,11 +58,310 @@ class KeyPointExtractor {
             vector<vector<KeyPoint>> &vvKeyPointsPerLevel, 
             const vector<Mat> &vImagePerLevel
         );
+
+        /*
+        @brief 建立影像金字塔並提取關鍵點：影像金字塔的每一層影像由提取關鍵點的執行緒建立，
+        第 0 層影像完成後就開始提取，較高層的影像同時由其他執行緒建立，提取到某一層的 Tile 時才等待該層影像完成。
+        結果與先呼叫 imagePyramid.setImage(image) 再提取相同
+        
+        @param[in, out] vvKeyPointsPerLevel 儲存影像金字塔中，每層影像的關鍵點
+        @param[in, out] imagePyramid 影像金字塔，層數必須與提取器相同
+        @param[in] image 影像金字塔的影像 */
+        void extract(
+            vector<vector<KeyPoint>> &vvKeyPointsPerLevel,
+            ImagePyramid &imagePyramid,
+            const Mat &image
+        );
+
+        /*
+        @brief 開始逐列接收影像並提取關鍵點 (例如相機逐列以 DMA 傳入影像)：每次以 pushRows 傳入接下來的數列，
+        影像金字塔中可以建立的列會立刻建立，所需的列都已經建立好的 Tile 也會立刻平行提取，
+        最後一列傳入後只剩下最後幾個 Tile 與合併的工作。結果與先設定整張影像再提取相同
+        
+        @param[in, out] imagePyramid 影像金字塔，層數必須與提取器相同，提取結束前不可以再設定其他影像
+        @param[in] imageSize 第 0 層影像的大小 */
+        void beginStream(ImagePyramid &imagePyramid, Size imageSize);
+
+        /*
+        @brief 傳入第 0 層影像接下來的數列，並提取所需的列都已經建立好的 Tile
+        
+        @param[in] rows 接下來的數列，寬度與影像相同 */
+        void pushRows(const Mat &rows);
+
+        /*
+        @brief 所有列都傳入後，提取剩下的 Tile 並完成提取，還有列沒有傳入時會觸發 CV_Assert
+        
+        @param[in, out] vvKeyPointsPerLevel 儲存影像金字塔中，每層影像的關鍵點 */
+        void endStream(vector<vector<KeyPoint>> &vvKeyPointsPerLevel);
+
+        /*
+        @brief 啟用跨影格的自適應 Grid 閾值：每個 Grid 的閾值會逐張影像朝目標角點數量調整，
+        下一張影像直接從調整後的閾值開始，穩定後幾乎不需要再放寬標準重新提取
+        
+        @param[in] vnFeaturesPerLevel 每一層影像最後需要的關鍵點數量 (例如 ImagePyramid::mvnFeaturesPerLevel)
+        @param[in] fCornersPerFeature 每個需要的關鍵點，希望保留幾個候選角點給 Distributor */
+        void enableAdaptiveThresholds(const vector<int> &vnFeaturesPerLevel, float fCornersPerFeature = 1.5f);
+
+        // 停用自適應 Grid 閾值，回到固定的 miMaxTh / miMinTh
+        void disableAdaptiveThresholds();
+
+        /*
+        @brief 設定每一層影像的靜態遮罩 (例如 ImagePyramid::mvMasks)：完全被遮住的 Grid 不會計算 FAST 也不會計入統計，
+        部分被遮住的 Grid 只保留落在可以使用的 pixel 上的關鍵點。遮罩大小與該層影像不同時，該層視為沒有遮罩。
+        不可以在提取期間 (例如 beginStream 與 endStream 之間) 呼叫
+        
+        @param[in] vMasks 每一層影像的遮罩，非 0 代表可以使用；傳入空的 vector 代表不使用遮罩 */
+        void setMasks(const vector<Mat> &vMasks);
+
+        /*
+        @brief 設定提取時使用的執行緒數量，執行緒會一直保留到下一次設定或解構為止，
+        提取結果與執行緒數量無關
+        
+        @param[in] nThreads 執行緒數量 (包含呼叫 extract 的執行緒)，1 代表不使用額外的執行緒 */
+        void setThreads(int nThreads);
+
+        // 清除累計的提取統計
+        void resetStatistics();
+
+        // 輸出每一層影像平均每張影像的提取統計
+        void printStatistics() const;
+
+        vector<LevelStatistics> mvStatsPerLevel; // 最近一次提取時，每一層影像的統計
+        vector<LevelStatistics> mvTotalStatsPerLevel; // 累計的每一層影像統計
+        unsigned long mnFrames; // 累計統計所包含的影像數量
     
     private:
+        // 一層影像的 Grid 劃分方式
+        struct GridLayout {
+            int iMinBorderX, iMinBorderY, iMaxBorderX, iMaxBorderY; // 可提取關鍵點的邊界
+            int nCols, nRows; // Grid 的行、列數
+            int iGridWidth, iGridHeight; // 每個 Grid 的寬、高
+        };
+
+        // Grid 被遮罩遮住的程度，只看 Grid 內可能找到角點的 pixel
+        enum CellState : uchar {
+            CELL_MASKED = 0,  // 全部被遮住，直接跳過
+            CELL_PARTIAL = 1, // 部分被遮住，需要逐一檢查角點的位置
+            CELL_USABLE = 2   // 完全沒有被遮住
+        };
+
+        // 一層影像在一次提取中共用的設定，在平行提取前準備好，提取期間只讀取
+        struct LevelContext {
+            GridLayout layout; // 該層影像的 Grid 劃分方式
+            const Mat* pMask; // 該層影像的遮罩，沒有遮罩時為 nullptr
+            const uchar* pCellStates; // 每個 Grid 的 CellState (row-major)，沒有遮罩時為 nullptr
+            uchar* pCellThresholds; // 每個 Grid 的自適應閾值，固定閾值時為 nullptr
+            int nTarget; // 每個 Grid 希望保留的角點數量
+            int iScoreTh; // 分數圖模式下，計算整層分數時使用的閾值
+            uchar* pWeakCells; // 分數圖模式下，沒有角點達到自己閾值、要以 miMinTh 重新計算分數的 Grid (row-major)，不需要時為 nullptr
+        };
+
+        // 平行提取的工作單位：某一層影像中連續的幾列 Grid
+        struct Tile {
+            int iLevel; // 影像金字塔的層級
+            int iRowBegin, iRowEnd; // Grid 的列範圍 [iRowBegin, iRowEnd)
+        };
+
+        /*
+        @brief 根據影像大小計算 Grid 的劃分方式
+        
+        @param[in] image 該層影像 */
+        GridLayout computeGridLayout(const Mat &image) const;
+
+        /*
+        @brief 根據遮罩計算每個 Grid 的 CellState
+        
+        @param[in] mask 該層影像的遮罩
+        @param[in] layout 該層影像的 Grid 劃分方式
+        @param[in, out] vCellStates 每個 Grid 的 CellState (row-major) */
+        void computeCellStates(const Mat &mask, const GridLayout &layout, vector<uchar> &vCellStates) const;
+
+        /*
+        @brief 準備一層影像的 LevelContext，並配置該層的分數圖
+        
+        @param[in] image 該層影像
+        @param[in] iLevel 影像金字塔的層級 */
+        void prepareLevel(const Mat &image, int iLevel);
+
+        /*
+        @brief 計算數列 Grid 內最多可能的角點數量，用來預先配置關鍵點的容器
+
+        @param[in] layout 該層影像的 Grid 劃分方式
+        @param[in] nRows Grid 的列數
+        @return 最多可能的角點數量 */
+        static int countMaxCorners(const GridLayout &layout, int nRows);
+
+        /*
+        @brief 把每一層影像切成 Tile，每個 Tile 的 Grid 列數以第 0 層平分給所有執行緒為準，
+        讓各層的 Tile 工作量相近
+        
+        @param[in] nThreads 執行緒數量 */
+        void splitTiles(int nThreads);
+
+        /*
+        @brief 提取關鍵點的主要流程，兩個 extract 共用
+        
+        @param[in, out] vvKeyPointsPerLevel 儲存影像金字塔中，每層影像的關鍵點
+        @param[in] vImagePerLevel 影像金字塔的每一層影像
+        @param[in, out] pImagePyramid 需要同時建立的影像金字塔，影像已經建立好時為 nullptr */
+        void extractLevels(
+            vector<vector<KeyPoint>> &vvKeyPointsPerLevel,
+            const vector<Mat> &vImagePerLevel,
+            ImagePyramid *pImagePyramid
+        );
+
+        /*
+        @brief 提取前準備好每一層影像的設定、Tile 與每個執行緒的暫存空間
+        
+        @param[in] vImagePerLevel 影像金字塔的每一層影像，只會用到影像的大小 */
+        void prepareExtraction(const vector<Mat> &vImagePerLevel);
+
+        /*
+        @brief 提取一個 Tile：Grid 模式直接提取關鍵點，分數圖模式只計算分數
+        
+        @param[in] iTile Tile 的編號
+        @param[in] iThread 執行該 Tile 的執行緒
+        @param[in] vImagePerLevel 影像金字塔的每一層影像 */
+        void extractTile(int iTile, int iThread, const vector<Mat> &vImagePerLevel);
+
+        /*
+        @brief 所有 Tile 都提取完後，合併每一層影像的關鍵點並完成非極大值抑制與統計
+        
+        @param[in, out] vvKeyPointsPerLevel 儲存影像金字塔中，每層影像的關鍵點
+        @param[in] vImagePerLevel 影像金字塔的每一層影像 */
+        void finishExtraction(vector<vector<KeyPoint>> &vvKeyPointsPerLevel, const vector<Mat> &vImagePerLevel);
+
+        /*
+        @brief 逐列接收影像時，平行提取所需的列都已經建立好、還沒提取的 Tile */
+        void extractReadyTiles();
+
+        /*
+        @brief 提取一個 Tile 需要的影像列數，Tile 只會讀取該層影像的前幾列
+        
+        @param[in] tile 要提取的 Tile */
+        int getTileRowEnd(const Tile &tile) const;
+
+        /*
+        @brief 平行處理所有 Tile。需要同時建立影像金字塔時，依「第 0 層影像、第 0 層的 Tile、其他層影像、其他層的 Tile」
+        的順序交給執行緒，每個 Tile 開始前等待該層影像完成。執行緒依序領取工作，等待的對象一定已經有執行緒在處理，不會互相卡住
+        
+        @param[in, out] pImagePyramid 需要同時建立的影像金字塔，影像已經建立好時為 nullptr
+        @param[in] tileTask 處理一個 Tile 的工作，signature 為 void(int iTile, int iThread) */
+        template<typename TileTask>
+        void runTiles(ImagePyramid *pImagePyramid, TileTask &&tileTask);
+
+        /*
+        @brief 一個 Tile 內的每個 Grid 各自呼叫 FAST 提取關鍵點，座標相對於 (iMinBorderX, iMinBorderY)
+        
+        @param[in, out] vKeyPoints 該 Tile 的關鍵點
+        @param[in] image 該層影像
+        @param[in] tile 要提取的 Tile
+        @param[in, out] stats 該 Tile 的提取統計
+        @param[in] iThread 執行該 Tile 的執行緒，用來選擇該執行緒專用的 FAST 偵測器與暫存容器 */
+        void extractPerGrid(vector<KeyPoint> &vKeyPoints, const Mat &image, const Tile &tile, LevelStatistics &stats, int iThread);
+
+        /*
+        @brief 對整層影像合併後的角點做跨 Grid 的非極大值抑制，只需要線性時間
+        
+        @param[in, out] vKeyPoints 該層影像的關鍵點，座標相對於 (iMinBorderX, iMinBorderY)
+        @param[in] image 該層影像
+        @param[in] layout 該層影像的 Grid 劃分方式
+        @param[in] iLevel 影像金字塔的層級
+        @param[in, out] stats 該層影像的提取統計 */
+        void suppressNonMaxima(vector<KeyPoint> &vKeyPoints, const Mat &image, const GridLayout &layout, int iLevel, LevelStatistics &stats);
+
+        /*
+        @brief 分數圖模式的第一階段：計算一個 Tile 內所有 pixel 的 FAST 分數並寫入分數圖，
+        只會寫入該 Tile 自己的列，不同 Tile 可以同時進行
+        
+        @param[in] image 該層影像
+        @param[in] tile 要計算分數的 Tile
+        @param[in] fastDetector 該執行緒專用的 FAST 偵測器 */
+        void scoreTile(const Mat &image, const Tile &tile, FASTDetector &fastDetector);
+
+        /*
+        @brief 檢查一個 Grid 內是否有分數達到 iCellTh，而且在分數圖上通過非極大值抑制的角點
+        
+        @param[in] scoreMap 該層影像的分數圖
+        @param[in] cell Grid 內可能找到角點的範圍
+        @param[in] iCellTh 該 Grid 的閾值
+        @param[in] pMask 部分被遮住的 Grid 傳入遮罩，否則為 nullptr */
+        bool hasStrongCorner(const Mat &scoreMap, const Rect &cell, int iCellTh, const Mat* pMask) const;
+
+        /*
+        @brief 分數圖模式的第二階段：標記一個 Tile 內沒有角點達到自己閾值的 Grid，只會讀取分數圖，不同 Tile 可以同時進行
+        
+        @param[in] tile 要檢查的 Tile */
+        void markWeakCells(const Tile &tile);
+
+        /*
+        @brief 分數圖模式的第三階段：對一個 Tile 內被標記的 Grid 以 miMinTh 重新計算分數，
+        只會寫入這些 Grid，不同 Tile 可以同時進行
+        
+        @param[in] image 該層影像
+        @param[in] tile 要重新計算分數的 Tile
+        @param[in] fastDetector 該執行緒專用的 FAST 偵測器 */
+        void rescoreWeakCells(const Mat &image, const Tile &tile, FASTDetector &fastDetector);
+
+        /*
+        @brief 分數圖模式的最後階段：從整層的分數圖收集一個 Tile 內通過非極大值抑制的角點並依 Grid 分桶，
+        座標相對於 (iMinBorderX, iMinBorderY)
+        
+        @param[in, out] vKeyPoints 該 Tile 的關鍵點
+        @param[in] tile 要收集角點的 Tile
+        @param[in, out] stats 該 Tile 的提取統計 */
+        void collectFromScoreMap(vector<KeyPoint> &vKeyPoints, const Tile &tile, LevelStatistics &stats);
+
+        /*
+        @brief 取得某一層影像每個 Grid 目前的閾值，Grid 數量改變時重設為 miMaxTh
+        
+        @param[in] iLevel 影像金字塔的層級
+        @param[in] layout 該層影像的 Grid 劃分方式 */
+        uchar* getCellThresholds(int iLevel, const GridLayout &layout);
+
+        /*
+        @brief 計算某一層影像每個 Grid 希望保留的角點數量
+        
+        @param[in] iLevel 影像金字塔的層級
+        @param[in] layout 該層影像的 Grid 劃分方式 */
+        int getTargetCornersPerCell(int iLevel, const GridLayout &layout) const;
+
+        /*
+        @brief 根據這次找到的角點數量調整 Grid 的閾值，角點太多就提高、太少就降低
+        
+        @param[in, out] threshold 該 Grid 的閾值
+        @param[in] nCorners 這次在該 Grid 閾值下找到的角點數量
+        @param[in] nTarget 該 Grid 希望保留的角點數量 */
+        void adaptThreshold(uchar &threshold, int nCorners, int nTarget) const;
+
         int mnLevels, mnPaddingPixels, mnKeyPoints, miMaxTh, miMinTh;
         float mfDefaultGridSize;
+        Mode meMode;
+
+        unique_ptr<ThreadPool> mpThreadPool; // 跨影格重複使用的執行緒
+        vector<FASTDetector> mvFASTDetectors; // 每個執行緒各自的 FAST-9 偵測器，依 CPU 指令集選擇 SIMD 實作
+        vector<vector<KeyPoint>> mvvGridKeyPoints; // 每個執行緒各自暫存單一 Grid 關鍵點的容器，跨影格重複使用
+        vector<Mat> mvGridScoreMaps; // 每個執行緒各自的 Grid 視窗分數圖，只會擴增，跨影格重複使用
+        vector<LevelContext> mvLevelContexts; // 每一層影像在這次提取中的設定
+        vector<Tile> mvTiles; // 這次提取的所有 Tile，依層級、Grid 列的順序排列
+        vector<vector<KeyPoint>> mvvTileKeyPoints; // 每個 Tile 各自的關鍵點，依 Tile 順序合併後與單執行緒的結果相同
+        vector<LevelStatistics> mvTileStats; // 每個 Tile 各自的提取統計
+        vector<Mat> mvScoreMaps; // 每一層影像的 FAST 分數圖 (0 代表不是角點)，跨影格重複使用
+
+        ImagePyramid *mpStreamPyramid = nullptr; // 逐列接收影像時正在建立的影像金字塔
+        vector<int> mvnNextTiles; // 逐列接收影像時，每一層影像下一個要提取的 Tile
+        vector<int> mvnLevelTileEnds; // 每一層影像最後一個 Tile 的下一個編號
+        vector<int> mvnReadyTiles; // 這次傳入後可以提取的 Tile
+
+        bool mbAdaptiveThresholds; // 是否使用跨影格的自適應 Grid 閾值
+        float mfCornersPerFeature; // 每個需要的關鍵點希望保留的候選角點數量
+        vector<int> mvnFeaturesPerLevel; // 每一層影像最後需要的關鍵點數量
+        vector<vector<uchar>> mvvCellThresholds; // 每一層影像、每個 Grid 目前的閾值 (row-major)
+        vector<vector<uchar>> mvvWeakCells; // 每一層影像、每個 Grid 是否要以 miMinTh 重新計算分數 (row-major)
+
+        vector<Mat> mvMasks; // 每一層影像的遮罩，沒有遮罩的層級為空
+        vector<vector<uchar>> mvvCellStates; // 每一層影像、每個 Grid 的 CellState (row-major)，設定遮罩時計算
 };
 
 }
-#endif
\ No newline at end of file
+#endif
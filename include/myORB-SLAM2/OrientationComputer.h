@@ -2,6 +2,7 @@
 #define ORIENTATIONCOMPUTER_H
 
 #include <vector>
+#include <cstdint>
 #include <opencv2/core.hpp>
 #include <opencv2/features2d.hpp>
 
@@ -12,12 +13,39 @@ namespace my_ORB_SLAM2 {
 
 class OrientationComputer {
     public:
+        // Instruction sets the moment kernel can run on.
+        enum Instruction {
+            SCALAR = 0,
+            AVX2 = 1
+        };
+
         /*
         @brief Before calculating orientation, it’s important to set a radius.
+        The best kernel the CPU supports is used.
         
-        @param[in] iRadius: Radius of the circular area. */
+        @param[in] iRadius: Radius of the circular area, at most 15. */
         OrientationComputer(int iRadius);
+
+        /*
+        @brief Orientation computer forced onto a specific kernel.
+        
+        @param[in] iRadius: Radius of the circular area, at most 15.
+        @param[in] eInstruction: Instruction set to use; it must be supported by this CPU. */
+        OrientationComputer(int iRadius, Instruction eInstruction);
         ~OrientationComputer() {};
+
+        // Instruction set used by this orientation computer.
+        Instruction meInstruction;
+
+        /*
+        @brief Query CPUID once and return the widest supported instruction set. */
+        static Instruction detectInstruction();
+
+        /*
+        @brief Check whether this CPU can run a given kernel.
+
+        @param[in] eInstruction: Instruction set to check. */
+        static bool isSupported(Instruction eInstruction);
         
         // Radius of the circular area.
         int miRadius;
@@ -31,7 +59,22 @@ class OrientationComputer {
         @param[in] keyPoint: The target keypoint.
         @param[in] image: The image that contains the keypoint. */
         inline float getOrientation(KeyPoint &keyPoint, const Mat &image);
+
+        /*
+        @brief Compute a keypoint's orientation with the AVX2 kernel; the moments are exactly those of getOrientation.
+
+        @param[in] keyPoint: The target keypoint.
+        @param[in] image: The image that contains the keypoint. */
+        inline float getOrientationAVX2(KeyPoint &keyPoint, const Mat &image);
         
+        /*
+        @brief Compute a keypoint's orientation with the kernel of this computer, one keypoint at a time
+        (e.g. for DescriptorComputer::describe).
+
+        @param[in] keyPoint: The target keypoint.
+        @param[in] image: The image that contains the keypoint. */
+        float computeOrientation(KeyPoint &keyPoint, const Mat &image);
+
         /*
         @brief Compute orientation for each keypoint from an image pyramid.
 
@@ -41,6 +84,16 @@ class OrientationComputer {
             vector<vector<KeyPoint>> &vvKeyPointsPerLevel,
             const vector<Mat> &vImagePerLevel
         );
+
+    private:
+        // Fill the per-row x weights and masks of the SIMD kernel from nHalfPointsPerY.
+        void initRowWeights();
+
+        /*
+        x weights (-15 ~ 15, then 0) and masks (1 inside the circle, 0 outside) of the 32 pixels 
+        from x = -15 to x = 16 on each row pair, with weights and masks zeroed outside the circle.*/
+        alignas(32) int8_t mRowWeights[16][32];
+        alignas(32) int8_t mRowMasks[16][32];
 };
 
 }
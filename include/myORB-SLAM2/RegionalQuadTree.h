@@ -1,8 +1,8 @@
 #ifndef REGIONALQUADTREE_H
 #define REGIONALQUADTREE_H
 
-#include <list>
 #include <vector>
+#include <algorithm>
 #include <opencv2/features2d.hpp>
 
 using namespace cv;
@@ -17,33 +17,57 @@ class RegionalQuadTreeNode {
         @brief 設定關鍵點區域四叉樹節點 */
         RegionalQuadTreeNode() {};
         ~RegionalQuadTreeNode() {};
+
+        // 該節點內包含的關鍵點數量
+        int size() const { return miEnd - miBegin; }
         
-        vector<KeyPoint*> mvpKeyPoints; // 該節點內包含的關鍵點指標
+        int miBegin, miEnd; // 該節點內包含的關鍵點指標，在四叉樹 mvpKeyPoints 中的範圍 [miBegin, miEnd)
         int miMinX, miMinY, miMaxX, miMaxY, miMidX, miMidY; // 該節點在影像中的框框座標
+        int miPrev = -1, miNext = -1; // 節點串列中前、後一個節點在 mvNodes 中的索引，-1 代表沒有
         bool mbLocked = false; // 用於判斷該節點是否能夠進行任何更動
 };
 
 class RegionalQuadTree {
     public:
         /*
-        @brief 設定關鍵點區域四叉樹 
+        @brief 設定關鍵點區域四叉樹，節點與關鍵點指標的記憶體會在每次 reset 之間重複使用 */
+        RegionalQuadTree() {};
+        ~RegionalQuadTree() {};
+
+        /*
+        @brief 以一組新的關鍵點重新建立四叉樹，只剩下包含所有關鍵點的根節點
         
-        @param[in] iWidth 影像寬度 
-        @param[in] iHeight 影像高度 
+        @param[in] area 根節點的框框 (例如整張影像，或遮罩中可以使用的範圍)，所有關鍵點都必須在框框內
         @param[in] vKeyPoints 一組關鍵點 */
-        RegionalQuadTree(int iWidth, int iHeight, vector<KeyPoint> &vKeyPoints);
-        ~RegionalQuadTree() {};
+        void reset(const Rect &area, vector<KeyPoint> &vKeyPoints);
 
-        list<RegionalQuadTreeNode> mlNodes; // 該四叉樹的節點串列
-        vector<KeyPoint> &mvKeyPoints; // 四叉樹的所有 Key Points
+        // 所有節點都存放在同一個陣列中，以索引互相連結；被分裂的父節點只會從節點串列中移除，reset 時才一起清除
+        vector<RegionalQuadTreeNode> mvNodes;
+        vector<KeyPoint*> mvpKeyPoints; // 四叉樹所有 Key Points 的指標，每個節點各自擁有其中連續的一段
+        int miHead = -1; // 節點串列中第一個節點的索引，-1 代表沒有任何節點
+        int mnNodes = 0; // 節點串列中的節點數量 (也就是尚未被分裂的節點數量)
 
         /*
-        @brief 根據指定的迭代器，分裂對應的節點
+        @brief 根據指定的索引，分裂對應的節點，子節點會加在節點串列的最前面
             
-        @param[in] lNodesIterator 指定要分裂的節點的迭代器 */
-        list<RegionalQuadTreeNode>::iterator divide(list<RegionalQuadTreeNode>::iterator &lNodesIterator);
+        @param[in] iNode 指定要分裂的節點的索引
+        @return 節點串列中原本位於該節點之後的節點索引 */
+        int divide(int iNode);
+    
+    private:
+        /*
+        @brief 在節點串列的最前面加入一個節點
+        
+        @param[in] node 要加入的節點 */
+        void pushFront(const RegionalQuadTreeNode &node);
+
+        /*
+        @brief 把一個節點從節點串列中移除
+        
+        @param[in] iNode 要移除的節點的索引 */
+        void unlink(int iNode);
 };
 
 }
 
-#endif
\ No newline at end of file
+#endif
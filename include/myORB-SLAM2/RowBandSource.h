@@ -0,0 +1,73 @@
+#ifndef ROWBANDSOURCE_H
+#define ROWBANDSOURCE_H
+
+#include <string>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+
+#include <opencv2/core.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace my_ORB_SLAM2 {
+
+/*
+Reads an 8-bit image from a binary PGM file (P5) in bands of rows, the way a camera delivers a frame line by line
+over DMA. The file is read one band at a time, and each band can be held back until the time its last line
+would arrive from a sensor with a given line period, so that streaming extraction can be tested without a camera. */
+class RowBandSource {
+    public:
+        RowBandSource() {};
+        ~RowBandSource() { close(); };
+
+        RowBandSource(const RowBandSource&) = delete;
+        RowBandSource& operator=(const RowBandSource&) = delete;
+
+        /*
+        @brief Open an image and start the simulated exposure: line i arrives (i + 1) line periods after this call.
+
+        @param[in] filePath: The binary PGM file.
+        @param[in] nBandRows: The number of rows delivered at once.
+        @param[in] dLinePeriod: The time between two lines in microseconds, 0 to deliver the bands as fast as they are read. */
+        bool open(const string& filePath, int nBandRows, double dLinePeriod = 0.0);
+
+        /*
+        @brief Close the file. Called by open and by the destructor. */
+        void close();
+
+        /*
+        @brief Read the next band, waiting for its last line to arrive.
+
+        @param[in, out] band: The rows of the band, pointing into a buffer of the source that the next band overwrites.
+        @return False when the whole image has been delivered or the file is truncated. */
+        bool nextBand(Mat& band);
+
+        /*
+        @brief Write an 8-bit image as a binary PGM file that open accepts.
+
+        @param[in] filePath: The PGM file.
+        @param[in] image: The 8-bit image. */
+        static bool savePGM(const string& filePath, const Mat& image);
+
+        // The size of the image, and the number of rows delivered so far.
+        int mnRows = 0, mnCols = 0;
+        int mnDeliveredRows = 0;
+
+        // The time the last delivered band arrived, i.e. when its last line was complete.
+        chrono::steady_clock::time_point mBandTime;
+
+    private:
+        FILE* mpFile = nullptr;
+        int mnBandRows = 0;
+        double mdLinePeriod = 0.0;
+        chrono::steady_clock::time_point mStartTime;
+
+        // The band buffer, reused for every band and every image of the same width.
+        Mat mBuffer;
+};
+
+} // my_ORB_SLAM2
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+using namespace std;
+
+namespace my_ORB_SLAM2 {
+
+class ThreadPool {
+    public:
+        /*
+        @brief A fixed set of worker threads that stay alive between calls to run().
+        
+        @param[in] nWorkers: Number of worker threads. The thread calling run() also takes tasks. */
+        ThreadPool(int nWorkers);
+        ~ThreadPool();
+
+        // Number of threads that execute tasks, including the thread calling run().
+        int mnThreads;
+
+        /*
+        @brief Execute task(iTask, iThread) for every iTask in [0, nTasks) and wait until all are done.
+        iThread lies in [0, mnThreads) and is unique among the threads running at the same time,
+        so it can index per-thread scratch buffers. Tasks are taken in increasing order, but may finish in any order.
+        
+        @param[in] nTasks: Number of tasks.
+        @param[in] task: Callable with the signature void(int iTask, int iThread). */
+        template<typename Task>
+        void run(int nTasks, Task &&task) {
+            dispatch(nTasks, &invoke<typename remove_reference<Task>::type>, (void*)&task);
+        }
+
+    private:
+        // Call a task through a type-erased pointer, without allocating a std::function.
+        template<typename Task>
+        static void invoke(void* pContext, int iTask, int iThread) {
+            (*static_cast<Task*>(pContext))(iTask, iThread);
+        }
+
+        /*
+        @brief Publish a batch of tasks to the workers, take tasks on this thread, and wait for the batch.
+        
+        @param[in] nTasks: Number of tasks.
+        @param[in] pfTask: Function executing one task.
+        @param[in] pContext: Callable object passed to pfTask. */
+        void dispatch(int nTasks, void (*pfTask)(void*, int, int), void* pContext);
+
+        /*
+        @brief Take tasks from the current batch until none is left.
+        
+        @param[in] iThread: Index of the thread taking the tasks. */
+        void drain(int iThread);
+
+        /*
+        @brief Main loop of a worker thread.
+        
+        @param[in] iThread: Index of the worker (1 ~ mnThreads-1). */
+        void work(int iThread);
+
+        vector<thread> mvWorkers;
+        mutex mMutex;
+        condition_variable mcvStart, mcvDone;
+
+        // Current batch, published under mMutex.
+        unsigned long mnGeneration = 0;
+        bool mbStop = false;
+        void (*mpfTask)(void*, int, int) = nullptr;
+        void* mpContext = nullptr;
+        int mnTasks = 0;
+        int mnBusyWorkers = 0;
+        atomic<int> mnNextTask;
+};
+
+} // my_ORB_SLAM2
+
+#endif
@@ -1,13 +1,202 @@
 #include "myORB-SLAM2/DescriptorComputer.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DESCRIPTOR_COMPUTER_X86
+#endif
+
 namespace my_ORB_SLAM2 {
+#ifdef DESCRIPTOR_COMPUTER_X86
+
+    /*
+    @brief Whether the gathers of compareAVX2 stay inside the memory of the image, including the 3 bytes 
+    read past the farthest pattern point. This is the case unless the keypoint is within the pattern 
+    radius of the bottom of the image's allocation, which only happens on images without padding.
+    
+    @param[in] pCenter: The pointer to the pixel at the keypoint's coordinates.
+    @param[in] image: The image that contains the keypoint.
+    @param[in] iRadius: The radius of the pattern. */
+    static inline bool isGatherInside(const uchar* pCenter, const Mat& image, int iRadius) {
+        return pCenter + iRadius * (ptrdiff_t)image.step + iRadius + 4 <= image.datalimit;
+    }
+
+    /*
+    @brief Compare the pattern points of a keypoint, one descriptor byte (8 pairs) per iteration.
+    A gather reads 4 bytes at each point and only the lowest one is kept. The 3 extra bytes of a point 
+    on the right edge of the image are in the next row or the padding, except on the last rows of 
+    an unpadded image: callers check isGatherInside first and use the scalar kernel there.
+    
+    @param[in, out] pDescriptor: The NBYTES bytes of the descriptor to be written.
+    @param[in] pCenter: The pointer to the pixel at the keypoint's coordinates.
+    @param[in] pOffsets: Memory offsets of the 16 * NBYTES pattern points in kernel order. */
+    template<int NBYTES>
+    __attribute__((target("avx2")))
+    static void compareAVX2(uchar* pDescriptor, const uchar* pCenter, const int* pOffsets) {
+        const __m256i mask = _mm256_set1_epi32(0xFF);
+        const int* pBase = (const int*)pCenter;
+
+        for(int i = 0; i < NBYTES; ++i, pOffsets += 16) {
+            __m256i first = _mm256_i32gather_epi32(pBase, _mm256_loadu_si256((const __m256i*)pOffsets), 1);
+            __m256i second = _mm256_i32gather_epi32(pBase, _mm256_loadu_si256((const __m256i*)(pOffsets + 8)), 1);
+            first = _mm256_and_si256(first, mask);
+            second = _mm256_and_si256(second, mask);
+
+            // Lane k holds pair k, so the sign bits of the comparison are already the bits of the byte.
+            pDescriptor[i] = (uchar)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(second, first)));
+        }
+    }
+
+    /*
+    @brief Rotate the NPOINTS pattern points, 8 per iteration, and turn them into memory offsets.
+    Products and sums are rounded separately (no FMA) and converted to the nearest even integer like cvRound, 
+    so the offsets are exactly those of computeDescriptor.
+    
+    @param[in, out] pOffsets: Memory offsets of the rotated pattern points in kernel order.
+    @param[in] pfX: x coordinates of the pattern points in kernel order.
+    @param[in] pfY: y coordinates of the pattern points in kernel order.
+    @param[in] fCos: Cosine of the keypoint's angle.
+    @param[in] fSin: Sine of the keypoint's angle.
+    @param[in] nStep: The number of bytes of an image row. */
+    template<int NPOINTS>
+    __attribute__((target("avx2")))
+    static void rotatePatternAVX2(int* pOffsets, const float* pfX, const float* pfY, float fCos, float fSin, int nStep) {
+        const __m256 cosine = _mm256_set1_ps(fCos), sine = _mm256_set1_ps(fSin);
+        const __m256i step = _mm256_set1_epi32(nStep);
+
+        for(int i = 0; i < NPOINTS; i += 8) {
+            __m256 x = _mm256_loadu_ps(pfX + i), y = _mm256_loadu_ps(pfY + i);
+            __m256i rotatedX = _mm256_cvtps_epi32(_mm256_sub_ps(_mm256_mul_ps(x, cosine), _mm256_mul_ps(y, sine)));
+            __m256i rotatedY = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(x, sine), _mm256_mul_ps(y, cosine)));
+            _mm256_storeu_si256((__m256i*)(pOffsets + i), _mm256_add_epi32(_mm256_mullo_epi32(rotatedY, step), rotatedX));
+        }
+    }
+
+#endif // DESCRIPTOR_COMPUTER_X86
+
+    /*
+    @brief Call f with the indices 0 to N - 1 as compile-time constants, so that a loop is unrolled 
+    for each descriptor width instead of being bounded at run time.
+    
+    @param[in] f: The loop body, taking the index.
+    @param[in] indices: The indices 0 to N - 1, e.g. make_index_sequence<N>(). */
+    template<class F, size_t... I>
+    static inline void unrollLoop(F&& f, index_sequence<I...>) {
+        (f(integral_constant<int, (int)I>()), ...);
+    }
+
+    /*
+    @brief Descriptor computer using the best kernel the CPU supports. */
+    template<int NBITS, class PATTERN>
+    BasicDescriptorComputer<NBITS, PATTERN>::BasicDescriptorComputer(): meInstruction(detectInstruction()) {}
+
+    /*
+    @brief Descriptor computer forced onto a specific kernel.
+    
+    @param[in] eInstruction: Instruction set to use; it must be supported by this CPU. */
+    template<int NBITS, class PATTERN>
+    BasicDescriptorComputer<NBITS, PATTERN>::BasicDescriptorComputer(Instruction eInstruction): meInstruction(eInstruction) {
+        CV_Assert(isSupported(eInstruction));
+    }
+
+    /*
+    @brief Query CPUID once and return the widest supported instruction set. */
+    DescriptorComputerBase::Instruction DescriptorComputerBase::detectInstruction() {
+        static const Instruction eInstruction = isSupported(AVX2) ? AVX2 : SCALAR;
+        return eInstruction;
+    }
+
+    /*
+    @brief Check whether this CPU can run a given kernel.
+
+    @param[in] eInstruction: Instruction set to check. */
+    bool DescriptorComputerBase::isSupported(Instruction eInstruction) {
+#ifdef DESCRIPTOR_COMPUTER_X86
+        __builtin_cpu_init();
+        switch(eInstruction) {
+            case SCALAR: return true;
+            case AVX2: return __builtin_cpu_supports("avx2");
+        }
+        return false;
+#else
+        return eInstruction == SCALAR;
+#endif
+    }
+
+    /*
+    @brief Read a pattern file: "BPAT", the number of pairs as a 32-bit integer, then the pairs as 8-bit integers.
+    
+    @param[in] filePath: The pattern file.
+    @param[in, out] vPattern: The pairs of the pattern, 4 values per pair. */
+    bool DescriptorComputerBase::readPattern(const string& filePath, vector<int8_t>& vPattern) {
+        FILE* pFile = fopen(filePath.c_str(), "rb");
+        if(!pFile) { return false; }
+
+        char pMagic[4];
+        int32_t nPairs = 0;
+        bool bRead = fread(pMagic, 1, 4, pFile) == 4 && memcmp(pMagic, "BPAT", 4) == 0 &&
+                     fread(&nPairs, sizeof(nPairs), 1, pFile) == 1 && nPairs > 0 && nPairs <= mnMaxPatternPairs;
+        if(bRead) {
+            // A truncated file reads fewer bytes than the header announces.
+            vPattern.resize((size_t)nPairs * 4);
+            bRead = fread(vPattern.data(), 1, vPattern.size(), pFile) == vPattern.size();
+        }
+        fclose(pFile);
+        return bRead;
+    }
+
+    /*
+    @brief Write a pattern file that readPattern and loadPattern accept.
+    
+    @param[in] filePath: The pattern file.
+    @param[in] vPattern: The pairs of the pattern, 4 values per pair. */
+    bool DescriptorComputerBase::savePattern(const string& filePath, const vector<int8_t>& vPattern) {
+        FILE* pFile = fopen(filePath.c_str(), "wb");
+        if(!pFile) { return false; }
+
+        int32_t nPairs = vPattern.size() / 4;
+        if(nPairs == 0 || nPairs > mnMaxPatternPairs) { fclose(pFile); return false; }
+        bool bWritten = fwrite("BPAT", 1, 4, pFile) == 4 &&
+                        fwrite(&nPairs, sizeof(nPairs), 1, pFile) == 1 &&
+                        fwrite(vPattern.data(), 1, nPairs * 4, pFile) == (size_t)nPairs * 4;
+        return fclose(pFile) == 0 && bWritten;
+    }
+
+    /*
+    @brief Replace PATTERN by the first NBITS pairs of a pattern file.
+    
+    @param[in] filePath: The pattern file. */
+    template<int NBITS, class PATTERN>
+    bool BasicDescriptorComputer<NBITS, PATTERN>::loadPattern(const string& filePath) {
+        shared_ptr<LoadedPattern> pLoadedPattern = make_shared<LoadedPattern>();
+        vector<int8_t>& vPattern = pLoadedPattern->vPattern;
+        if(!readPattern(filePath, vPattern) || (int)vPattern.size() < NBITS * 4) { return false; }
+        vPattern.resize(NBITS * 4);
+
+        // Points farther than PATTERN's could be read outside the image.
+        pLoadedPattern->vfX.resize(mnPatternPoints);
+        pLoadedPattern->vfY.resize(mnPatternPoints);
+        int iRadius = fillPatternCoordinates(vPattern.data(), NBITS, pLoadedPattern->vfX.data(), pLoadedPattern->vfY.data());
+        if(iRadius > mPatternCoordinates.miRadius) { return false; }
+
+        mpLoadedPattern = pLoadedPattern;
+        mpPattern = pLoadedPattern->vPattern.data();
+        mpfPatternX = pLoadedPattern->vfX.data();
+        mpfPatternY = pLoadedPattern->vfY.data();
+        miPatternRadius = iRadius;
+
+        // The rotated patterns of the angle bins come from the pattern.
+        setAngleBins(mnAngleBins);
+        return true;
+    }
+
     /*
     @brief Compute a descriptor for a keypoint based on its image.
     
-    @param[in, out] descriptor: The 256-bit descriptor to be written.
+    @param[in, out] descriptor: The NBITS-bit descriptor to be written.
     @param[in] keyPoint: The keypoint used to compute the descriptor based on its coordinates. 
     @param[in] image: The image that contains the keypoint mentioned above. */
-    inline void DescriptorComputer::computeDescriptor(
+    template<int NBITS, class PATTERN>
+    inline void BasicDescriptorComputer<NBITS, PATTERN>::computeDescriptor(
         Descriptor& descriptor,
         const KeyPoint& keyPoint,
         const Mat& image
@@ -21,7 +210,7 @@ namespace my_ORB_SLAM2 {
 
         // Obtain the number of bytes of an image row, 
         // and the pointer to the pixel at the keypoint's coordinates.
-        int nCols = image.cols;
+        int nCols = (int)image.step;
         const uchar* pCenter = &image.at<uchar>(cvRound(keyPoint.pt.y), cvRound(keyPoint.pt.x));
 
         // Rotate the coordinates based on the keypoint's orientation, 
@@ -30,9 +219,12 @@ namespace my_ORB_SLAM2 {
             cvRound(pPattern[i] * fSin + pPattern[i + 1] * fCos) * nCols + \
                 cvRound(pPattern[i] * fCos - pPattern[i + 1] * fSin)
 
-        // The pointer to the first x coordinate in the pattern array.
-        int* pPattern = &mPattern[0];
-        for(int i = 0; i < mnBytesPerDescriptor; ++i, pPattern += 32) {
+        // One byte per iteration. The bound is known at compile time, but the loop is not fully unrolled:
+        // 64 bytes of rotations and roundings overflow the instruction cache and double the 512-bit time.
+        for(int i = 0; i < mnBytesPerDescriptor; ++i) {
+            // The pointer to the first x coordinate of this byte's pairs in the pattern array.
+            const int8_t* pPattern = mpPattern + 32 * i;
+
             // Generate one byte in the descriptor.
             uchar I0, I1, byte = 0;
 
@@ -58,7 +250,7 @@ namespace my_ORB_SLAM2 {
             I0 = pCenter[getOffset(28)]; I1 = pCenter[getOffset(30)];
             byte |= (I0 < I1) << 7;
 
-            // Write this byte into the 32-byte descriptor.
+            // Write this byte into the descriptor.
             descriptor[i] = byte;
         }
 
@@ -66,13 +258,253 @@ namespace my_ORB_SLAM2 {
         #undef getOffset
     }
 
+    /*
+    @brief Compute a descriptor with the AVX2 kernel, bit-identical to computeDescriptor.
+    
+    @param[in, out] descriptor: The NBITS-bit descriptor to be written.
+    @param[in] keyPoint: The keypoint used to compute the descriptor based on its coordinates. 
+    @param[in] image: The image that contains the keypoint mentioned above. */
+    template<int NBITS, class PATTERN>
+    inline void BasicDescriptorComputer<NBITS, PATTERN>::computeDescriptorAVX2(
+        Descriptor& descriptor,
+        const KeyPoint& keyPoint,
+        const Mat& image
+    ) {
+#ifdef DESCRIPTOR_COMPUTER_X86
+        // Near the end of an unpadded image the gathers would read past it, so the scalar kernel is used there.
+        const uchar* pCenter = &image.at<uchar>(cvRound(keyPoint.pt.y), cvRound(keyPoint.pt.x));
+        if(!isGatherInside(pCenter, image, miPatternRadius)) {
+            computeDescriptor(descriptor, keyPoint, image);
+            return;
+        }
+
+        // Same angle, sine and cosine as computeDescriptor.
+        float fRadian = keyPoint.angle * mfDeg2Rad;
+        float fCos = cosf(fRadian);
+        float fSin = sinf(fRadian);
+
+        // Rotate the whole pattern first, then gather and compare.
+        alignas(32) int pOffsets[mnPatternPoints];
+        rotatePatternAVX2<mnPatternPoints>(pOffsets, mpfPatternX, mpfPatternY, fCos, fSin, (int)image.step);
+        compareAVX2<mnBytesPerDescriptor>(descriptor.data(), pCenter, pOffsets);
+#else
+        computeDescriptor(descriptor, keyPoint, image);
+#endif
+    }
+
+    /*
+    @brief Compute a descriptor with the rotated pattern of the keypoint's angle bin.
+    
+    @param[in, out] descriptor: The NBITS-bit descriptor to be written.
+    @param[in] keyPoint: The keypoint used to compute the descriptor based on its coordinates. 
+    @param[in] image: The image that contains the keypoint mentioned above.
+    @param[in] pOffsets: Memory offsets of the rotated pattern points of every bin, for the stride of the image. */
+    template<int NBITS, class PATTERN>
+    inline void BasicDescriptorComputer<NBITS, PATTERN>::computeDescriptorFromTable(
+        Descriptor& descriptor,
+        const KeyPoint& keyPoint,
+        const Mat& image,
+        const int* pOffsets
+    ) {
+        // Round the angle to the nearest bin, 360 degrees wraps around to bin 0.
+        int iBin = cvRound(keyPoint.angle * mnAngleBins / 360.f) % mnAngleBins;
+        if(iBin < 0) { iBin += mnAngleBins; }
+
+        // The pointer to the pixel at the keypoint's coordinates, and the offsets of its bin.
+        const uchar* pCenter = &image.at<uchar>(cvRound(keyPoint.pt.y), cvRound(keyPoint.pt.x));
+        const int* pOffset = pOffsets + iBin * mnPatternPoints;
+
+#ifdef DESCRIPTOR_COMPUTER_X86
+        if(meInstruction == AVX2 && isGatherInside(pCenter, image, miPatternRadius)) {
+            compareAVX2<mnBytesPerDescriptor>(descriptor.data(), pCenter, pOffset);
+            return;
+        }
+#endif
+
+        // Offsets are in kernel order, so pair k of a byte compares offset k with offset 8 + k.
+        // Each pair gives one bit, so the loop only loads and compares, and is unrolled for this width.
+        unrollLoop([&](auto i) {
+            const int* pByteOffset = pOffset + 16 * i;
+            uchar byte = 0;
+            for(int k = 0; k < 8; ++k)
+                byte |= (pCenter[pByteOffset[k]] < pCenter[pByteOffset[8 + k]]) << k;
+            descriptor[i] = byte;
+        }, make_index_sequence<mnBytesPerDescriptor>());
+    }
+
+    /*
+    @brief Quantize keypoint angles into nAngleBins bins and look up precomputed rotated patterns.
+    
+    @param[in] nAngleBins: The number of angle bins, 0 to go back to the exact rotation. */
+    template<int NBITS, class PATTERN>
+    void BasicDescriptorComputer<NBITS, PATTERN>::setAngleBins(int nAngleBins) {
+        mnAngleBins = max(nAngleBins, 0);
+        mvnRotatedPattern.resize(mnAngleBins * mnPatternPoints * 2);
+
+        // Rotate the pattern to the center angle of each bin, exactly as computeDescriptor does.
+        for(int iBin = 0; iBin < mnAngleBins; ++iBin) {
+            float fRadian = (iBin * 360.f / mnAngleBins) * mfDeg2Rad;
+            float fCos = cosf(fRadian);
+            float fSin = sinf(fRadian);
+
+            int* pRotated = &mvnRotatedPattern[iBin * mnPatternPoints * 2];
+            for(int i = 0; i < mnPatternPoints; ++i) {
+                float fX = mpfPatternX[i], fY = mpfPatternY[i];
+                pRotated[2 * i] = cvRound(fX * fCos - fY * fSin);
+                pRotated[2 * i + 1] = cvRound(fX * fSin + fY * fCos);
+            }
+        }
+
+        // The offsets depend on the bins, so every level rebuilds them on the next frame.
+        mvnOffsetSteps.assign(mvnOffsetSteps.size(), -1);
+    }
+
+    /*
+    @brief Obtain the rotated pattern offsets of a pyramid level, rebuilt only when the image stride changes.
+    
+    @param[in] iLevel: The pyramid level.
+    @param[in] nStep: The number of bytes of an image row at this level. */
+    template<int NBITS, class PATTERN>
+    const int* BasicDescriptorComputer<NBITS, PATTERN>::getRotatedOffsets(int iLevel, int nStep) {
+        if(iLevel >= (int)mvvnRotatedOffsets.size()) {
+            mvvnRotatedOffsets.resize(iLevel + 1);
+            mvnOffsetSteps.resize(iLevel + 1, -1);
+        }
+
+        vector<int>& vnOffsets = mvvnRotatedOffsets[iLevel];
+        if(mvnOffsetSteps[iLevel] != nStep) {
+            vnOffsets.resize(mnAngleBins * mnPatternPoints);
+            for(int i = 0; i < mnAngleBins * mnPatternPoints; ++i)
+                vnOffsets[i] = mvnRotatedPattern[2 * i + 1] * nStep + mvnRotatedPattern[2 * i];
+            mvnOffsetSteps[iLevel] = nStep;
+        }
+        return vnOffsets.data();
+    }
+
+    /*
+    @brief Blur an image with a 7x7 Gaussian kernel (sigma = 2) and reflect-101 borders, see GaussianFilter.
+    
+    @param[in] image: The 8-bit image to be blurred.
+    @param[in, out] blurredImage: The blurred image, reallocated only when its size changes. */
+    template<int NBITS, class PATTERN>
+    void BasicDescriptorComputer<NBITS, PATTERN>::blur(const Mat& image, Mat& blurredImage) {
+        mGaussianFilter.apply(image, blurredImage);
+    }
+
+    /*
+    @brief Blur only the blocks of each level that the keypoints' patterns reach, instead of the whole level.
+    
+    @param[in] bEnable: Whether to blur only around the keypoints. */
+    template<int NBITS, class PATTERN>
+    void BasicDescriptorComputer<NBITS, PATTERN>::setLocalSmoothing(bool bEnable) {
+        mbLocalSmoothing = bEnable;
+    }
+
+    /*
+    @brief Blur with 8-bit fixed-point weights instead of GaussianBlur, in compute() and with local smoothing.
+    
+    @param[in] bEnable: Whether to use the fixed-point blur. */
+    template<int NBITS, class PATTERN>
+    void BasicDescriptorComputer<NBITS, PATTERN>::setFixedPointBlur(bool bEnable) {
+        mGaussianFilter.meImplementation = bEnable ? GaussianFilter::FIXED_POINT : GaussianFilter::OPENCV;
+    }
+
+    /*
+    @brief Blur the blocks of an image that the patterns of its keypoints reach, and leave the others untouched.
+    
+    @param[in] image: The 8-bit image to be blurred.
+    @param[in, out] blurredImage: The blurred image, reallocated only when its size changes.
+    @param[in] vKeyPoints: The keypoints in this image. */
+    template<int NBITS, class PATTERN>
+    void BasicDescriptorComputer<NBITS, PATTERN>::blurAroundKeyPoints(const Mat& image, Mat& blurredImage, const vector<KeyPoint>& vKeyPoints) {
+        // Blocks are wider than tall: a region costs 6 extra rows for the vertical kernel but nothing extra per column.
+        const int nBlockWidth = 16, nBlockHeight = 32;
+        int nRows = image.rows, nCols = image.cols;
+        int nBlockCols = (nCols + nBlockWidth - 1) / nBlockWidth, nBlockRows = (nRows + nBlockHeight - 1) / nBlockHeight;
+        blurredImage.create(nRows, nCols, CV_8U);
+
+        // Mark the blocks covered by the square that the pattern of each keypoint can reach.
+        mvbBlurredBlocks.assign(nBlockCols * nBlockRows, 0);
+        for(const KeyPoint& keyPoint : vKeyPoints) {
+            int iX = cvRound(keyPoint.pt.x), iY = cvRound(keyPoint.pt.y);
+            int iMinCol = max(iX - miPatternRadius, 0) / nBlockWidth, iMaxCol = min(iX + miPatternRadius, nCols - 1) / nBlockWidth;
+            int iMinRow = max(iY - miPatternRadius, 0) / nBlockHeight, iMaxRow = min(iY + miPatternRadius, nRows - 1) / nBlockHeight;
+            for(int iRow = iMinRow; iRow <= iMaxRow; ++iRow)
+                memset(&mvbBlurredBlocks[iRow * nBlockCols + iMinCol], 1, iMaxCol - iMinCol + 1);
+        }
+
+        // Regions re-filter 6 rows around every block row, so a mostly covered image is cheaper to blur whole.
+        int nMarkedBlocks = 0;
+        for(uchar bMarked : mvbBlurredBlocks) { nMarkedBlocks += bMarked; }
+        if(nMarkedBlocks * 4 >= nBlockCols * nBlockRows * 3) {
+            blur(image, blurredImage);
+            return;
+        }
+
+        // Blur each run of marked blocks in a block row as one region.
+        for(int iRow = 0; iRow < nBlockRows; ++iRow) {
+            const uchar* pbBlocks = &mvbBlurredBlocks[iRow * nBlockCols];
+            int iY = iRow * nBlockHeight, nHeight = min(nBlockHeight, nRows - iY);
+            for(int iCol = 0; iCol < nBlockCols; ) {
+                if(!pbBlocks[iCol]) { ++iCol; continue; }
+
+                int iEndCol = iCol;
+                while(iEndCol < nBlockCols && pbBlocks[iEndCol]) { ++iEndCol; }
+                int iX = iCol * nBlockWidth, nWidth = min(iEndCol * nBlockWidth, nCols) - iX;
+                mGaussianFilter.applyRegion(image, blurredImage, Rect(iX, iY, nWidth, nHeight));
+                iCol = iEndCol;
+            }
+        }
+    }
+
+    /*
+    @brief The blurred image of a level for compute(), a header into a buffer with a border of miPatternRadius pixels.
+    
+    @param[in] iLevel: The pyramid level.
+    @param[in] size: The size of the level. */
+    template<int NBITS, class PATTERN>
+    Mat& BasicDescriptorComputer<NBITS, PATTERN>::getBlurredImage(int iLevel, Size size) {
+        Mat& buffer = mvBlurredBuffers[iLevel];
+        Mat& blurredImage = mvBlurredImages[iLevel];
+        int nBorder = miPatternRadius;
+        if(buffer.rows != size.height + 2 * nBorder || buffer.cols != size.width + 2 * nBorder || blurredImage.size() != size) {
+            buffer.create(size.height + 2 * nBorder, size.width + 2 * nBorder, CV_8U);
+            blurredImage = buffer(Rect(nBorder, nBorder, size.width, size.height));
+        }
+        return blurredImage;
+    }
+
+    /*
+    @brief Copy the outermost pixels of a blurred image into its border of miPatternRadius pixels.
+    
+    @param[in, out] blurredImage: The blurred image, a header returned by getBlurredImage. */
+    template<int NBITS, class PATTERN>
+    void BasicDescriptorComputer<NBITS, PATTERN>::replicateBorder(Mat& blurredImage) {
+        int nBorder = miPatternRadius, nRows = blurredImage.rows, nCols = blurredImage.cols;
+        if(nBorder == 0 || blurredImage.empty()) { return; }
+
+        ptrdiff_t nStep = blurredImage.step;
+        for(int iY = 0; iY < nRows; ++iY) {
+            uchar* pRow = blurredImage.ptr<uchar>(iY);
+            memset(pRow - nBorder, pRow[0], nBorder);
+            memset(pRow + nCols, pRow[nCols - 1], nBorder);
+        }
+        const uchar* pFirstRow = blurredImage.ptr<uchar>(0) - nBorder;
+        const uchar* pLastRow = blurredImage.ptr<uchar>(nRows - 1) - nBorder;
+        for(int i = 1; i <= nBorder; ++i) {
+            memcpy((uchar*)pFirstRow - i * nStep, pFirstRow, nCols + 2 * nBorder);
+            memcpy((uchar*)pLastRow + i * nStep, pLastRow, nCols + 2 * nBorder);
+        }
+    }
+
     /*
     @brief Compute the descriptors for all the keypoints in the image pyramid.
     
     @param[in, out] vvDescriptorsPerLevel: Stores all the descriptors at each pyramid level.
     @param[in] vvKeyPointsPerLevel: Stores all the keypoints at each pyramid level.
     @param[in] vImagePerLevel: Stores all the images at each pyramid level. */
-    void DescriptorComputer::compute(
+    template<int NBITS, class PATTERN>
+    void BasicDescriptorComputer<NBITS, PATTERN>::compute(
         vector<vector<Descriptor>>& vvDescriptorsPerLevel,
         const vector<vector<KeyPoint>>& vvKeyPointsPerLevel,
         const vector<Mat>& vImagePerLevel
@@ -80,30 +512,152 @@ namespace my_ORB_SLAM2 {
         // Obtain the number of levels in the image pyramid.
         int nLevels = vImagePerLevel.size();
 
-        // Resize this vector to match the number of levels.
+        // Resize these vectors to match the number of levels.
         vvDescriptorsPerLevel.resize(nLevels);
+        mvBlurredBuffers.resize(nLevels);
+        mvBlurredImages.resize(nLevels);
 
         // Iterate over the levels in the image pyramid.
         for(int iLevel = 0; iLevel < nLevels; ++iLevel) {
-            // Image and keypoints at this level.
-            const Mat& image = vImagePerLevel[iLevel];
-            const vector<KeyPoint>& vKeyPoints = vvKeyPointsPerLevel[iLevel];
+            // Blurring the image helps reduce noise, either the whole level or only where the patterns reach.
+            // The blurred image of each level keeps its buffer, so nothing is allocated after the first frame.
+            // The border is replicated from the blurred pixels, as in the blurred levels of ImagePyramid; with local smoothing
+            // it may copy unblurred blocks, but only where no pattern reaches, since blocks at the edges are blurred for edge keypoints.
+            Mat& blurredImage = getBlurredImage(iLevel, vImagePerLevel[iLevel].size());
+            if(mbLocalSmoothing)
+                blurAroundKeyPoints(vImagePerLevel[iLevel], blurredImage, vvKeyPointsPerLevel[iLevel]);
+            else
+                blur(vImagePerLevel[iLevel], blurredImage);
+            replicateBorder(blurredImage);
 
-            // The number of keypoints at this level.
-            int nKeyPoints = vKeyPoints.size();
+            computeLevel(vvDescriptorsPerLevel[iLevel], vvKeyPointsPerLevel[iLevel], blurredImage, iLevel);
+        }
+    }
+
+    /*
+    @brief Compute the descriptors for all the keypoints from an already blurred image pyramid.
+    
+    @param[in, out] vvDescriptorsPerLevel: Stores all the descriptors at each pyramid level.
+    @param[in] vvKeyPointsPerLevel: Stores all the keypoints at each pyramid level.
+    @param[in] vBlurredImagePerLevel: Stores all the blurred images at each pyramid level. */
+    template<int NBITS, class PATTERN>
+    void BasicDescriptorComputer<NBITS, PATTERN>::computeBlurred(
+        vector<vector<Descriptor>>& vvDescriptorsPerLevel,
+        const vector<vector<KeyPoint>>& vvKeyPointsPerLevel,
+        const vector<Mat>& vBlurredImagePerLevel
+    ) {
+        int nLevels = vBlurredImagePerLevel.size();
+        vvDescriptorsPerLevel.resize(nLevels);
+
+        for(int iLevel = 0; iLevel < nLevels; ++iLevel)
+            computeLevel(vvDescriptorsPerLevel[iLevel], vvKeyPointsPerLevel[iLevel], vBlurredImagePerLevel[iLevel], iLevel);
+    }
+
+    /*
+    @brief Compute the orientation and the descriptor of every keypoint in one pass, visiting the keypoints by row.
+    
+    @param[in, out] vvDescriptorsPerLevel: Stores all the descriptors at each pyramid level.
+    @param[in, out] vvKeyPointsPerLevel: Stores all the keypoints at each pyramid level, their angles are written.
+    @param[in] vImagePerLevel: Stores all the images at each pyramid level, used for the orientation.
+    @param[in] vBlurredImagePerLevel: Stores all the blurred images at each pyramid level.
+    @param[in] orientationComputer: Computes the orientation of each keypoint. */
+    template<int NBITS, class PATTERN>
+    void BasicDescriptorComputer<NBITS, PATTERN>::describe(
+        vector<vector<Descriptor>>& vvDescriptorsPerLevel,
+        vector<vector<KeyPoint>>& vvKeyPointsPerLevel,
+        const vector<Mat>& vImagePerLevel,
+        const vector<Mat>& vBlurredImagePerLevel,
+        OrientationComputer& orientationComputer
+    ) {
+        int nLevels = vImagePerLevel.size();
+        vvDescriptorsPerLevel.resize(nLevels);
 
-            // This vector stores all the descriptors to be computed at this level.
+        for(int iLevel = 0; iLevel < nLevels; ++iLevel) {
+            const Mat& image = vImagePerLevel[iLevel];
+            const Mat& blurredImage = vBlurredImagePerLevel[iLevel];
+            vector<KeyPoint>& vKeyPoints = vvKeyPointsPerLevel[iLevel];
             vector<Descriptor>& vDescriptors = vvDescriptorsPerLevel[iLevel];
+            int nKeyPoints = vKeyPoints.size();
             vDescriptors.resize(nKeyPoints);
 
-            // Blurring the image helps reduce noise.
-            Mat blurredImage = image.clone();
-            GaussianBlur(image, blurredImage, Size(7, 7), 2, 2);
+            // Visit the keypoints row by row, so that neighbouring keypoints share the rows in cache.
+            // The row is packed above the index, so a plain integer sort gives the order.
+            mvnKeyPointOrder.resize(nKeyPoints);
+            for(int i = 0; i < nKeyPoints; ++i) 
+                mvnKeyPointOrder[i] = ((int64_t)vKeyPoints[i].pt.y << 32) | i;
+            sort(mvnKeyPointOrder.begin(), mvnKeyPointOrder.end());
+
+            const int* pOffsets = mnAngleBins > 0 ? getRotatedOffsets(iLevel, (int)blurredImage.step) : nullptr;
+            int nRadius = orientationComputer.miRadius;
+            for(int k = 0; k < nKeyPoints; ++k) {
+                // Prefetch the ends of the rows that the next keypoint reads: the circle in the image, 
+                // the pattern in the blurred image. Each row segment spans at most two cache lines.
+                if(k + 1 < nKeyPoints) {
+                    const KeyPoint& next = vKeyPoints[(int)mvnKeyPointOrder[k + 1]];
+                    const uchar* pNext = &image.at<uchar>(next.pt.y, next.pt.x);
+                    const uchar* pBlurredNext = &blurredImage.at<uchar>(cvRound(next.pt.y), cvRound(next.pt.x));
+                    for(int iY = -nRadius; iY <= nRadius; ++iY) {
+                        __builtin_prefetch(pNext + iY * (int)image.step - nRadius);
+                        __builtin_prefetch(pNext + iY * (int)image.step + nRadius);
+                    }
+                    for(int iY = -miPatternRadius; iY <= miPatternRadius; ++iY) {
+                        __builtin_prefetch(pBlurredNext + iY * (int)blurredImage.step - miPatternRadius);
+                        __builtin_prefetch(pBlurredNext + iY * (int)blurredImage.step + miPatternRadius);
+                    }
+                }
+
+                // The angle is needed by the descriptor right away.
+                int i = (int)mvnKeyPointOrder[k];
+                KeyPoint& keyPoint = vKeyPoints[i];
+                keyPoint.angle = orientationComputer.computeOrientation(keyPoint, image);
+
+                if(pOffsets)
+                    computeDescriptorFromTable(vDescriptors[i], keyPoint, blurredImage, pOffsets);
+                else if(meInstruction == AVX2)
+                    computeDescriptorAVX2(vDescriptors[i], keyPoint, blurredImage);
+                else
+                    computeDescriptor(vDescriptors[i], keyPoint, blurredImage);
+            }
+        }
+    }
+
+    /*
+    @brief Compute the descriptors of the keypoints at one pyramid level.
+    
+    @param[in, out] vDescriptors: The descriptors to be computed at this level.
+    @param[in] vKeyPoints: The keypoints at this level.
+    @param[in] blurredImage: The blurred image at this level.
+    @param[in] iLevel: The pyramid level. */
+    template<int NBITS, class PATTERN>
+    void BasicDescriptorComputer<NBITS, PATTERN>::computeLevel(
+        vector<Descriptor>& vDescriptors,
+        const vector<KeyPoint>& vKeyPoints,
+        const Mat& blurredImage,
+        int iLevel
+    ) {
+        // The number of keypoints at this level.
+        int nKeyPoints = vKeyPoints.size();
+        vDescriptors.resize(nKeyPoints);
 
-            // Compute descriptor for each keypoint at this level.
+        // Compute descriptor for each keypoint at this level, 
+        // either with the rotated pattern of its angle bin or with an exact rotation.
+        if(mnAngleBins > 0) {
+            const int* pOffsets = getRotatedOffsets(iLevel, (int)blurredImage.step);
+            for(int i = 0; i < nKeyPoints; ++i)
+                computeDescriptorFromTable(vDescriptors[i], vKeyPoints[i], blurredImage, pOffsets);
+        }
+        else if(meInstruction == AVX2) {
+            for(int i = 0; i < nKeyPoints; ++i)
+                computeDescriptorAVX2(vDescriptors[i], vKeyPoints[i], blurredImage);
+        }
+        else {
             for(int i = 0; i < nKeyPoints; ++i)
                 computeDescriptor(vDescriptors[i], vKeyPoints[i], blurredImage);
         }
     }
 
+    // The descriptor widths and patterns the library is built for.
+    template class BasicDescriptorComputer<256, ORBPattern>;
+    template class BasicDescriptorComputer<512, ExtendedORBPattern>;
+
 } // my_ORB_SLAM2
\ No newline at end of file
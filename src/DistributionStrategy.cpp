@@ -0,0 +1,270 @@
+#include "myORB-SLAM2/DistributionStrategy.h"
+
+namespace my_ORB_SLAM2 {
+    /*
+    @brief 區域四叉樹均勻化：每次都分裂關鍵點最多的節點，直到節點數量達標
+    
+    @param[in, out] vDistributedKeyPoints 均勻化後的關鍵點，會先被清空
+    @param[in] vKeyPoints 該層影像的關鍵點
+    @param[in] nFeatures 該層影像要提取的關鍵點數量
+    @param[in] area 該層影像中關鍵點所在的範圍
+    @param[in] nUsablePixels 範圍內可以使用的 pixel 數量 */
+    void QuadTreeDistribution::distribute(
+        vector<KeyPoint> &vDistributedKeyPoints,
+        vector<KeyPoint> &vKeyPoints,
+        int nFeatures, const Rect &area, int nUsablePixels
+    ) {
+        // 設定關鍵點區域四叉樹
+        RegionalQuadTree &quadTree = mQuadTree;
+        quadTree.reset(area, vKeyPoints);
+
+        // 以節點內的關鍵點數量為鍵值的 max-heap，每次都分裂目前關鍵點最多的 Node
+        // 關鍵點數量相同時，先分裂較早建立的 Node，讓結果不受 heap 內部順序影響
+        auto isLessPopulated = [&quadTree](int iNode1, int iNode2) {
+            int n1 = quadTree.mvNodes[iNode1].size(), n2 = quadTree.mvNodes[iNode2].size();
+            return n1 < n2 || (n1 == n2 && iNode1 > iNode2);
+        };
+
+        // 只有關鍵點數量大於 1 的 Node 才需要放進 heap
+        mvnSplitHeap.clear();
+        if(quadTree.miHead != -1 && !quadTree.mvNodes[quadTree.miHead].mbLocked)
+            mvnSplitHeap.push_back(quadTree.miHead);
+
+        // 不斷分裂關鍵點最多的 Node，Nodes 數量一達到該層要提取的關鍵點數量就停止
+        // 每次分裂只需要 O(log N) 的 heap 操作，不需要每一輪都遍歷或重新排序所有 Nodes
+        while(!mvnSplitHeap.empty() && quadTree.mnNodes < nFeatures) {
+            pop_heap(mvnSplitHeap.begin(), mvnSplitHeap.end(), isLessPopulated);
+            int iNode = mvnSplitHeap.back();
+            mvnSplitHeap.pop_back();
+
+            // 分裂後新增的子 Node 位於 mvNodes 的最後面
+            int iFirstChild = quadTree.mvNodes.size();
+            quadTree.divide(iNode);
+
+            // 把還可以分裂的子 Node 放進 heap
+            // 框框已經縮小到 1 pixel 的 Node 無法再分開重疊在同一個 pixel 上的關鍵點，不再分裂
+            for(int iChild = iFirstChild; iChild < (int)quadTree.mvNodes.size(); iChild++) {
+                const RegionalQuadTreeNode &child = quadTree.mvNodes[iChild];
+                if(child.mbLocked) { continue; }
+                if(child.miMaxX - child.miMinX <= 1 && child.miMaxY - child.miMinY <= 1) { continue; }
+
+                mvnSplitHeap.push_back(iChild);
+                push_heap(mvnSplitHeap.begin(), mvnSplitHeap.end(), isLessPopulated);
+            }
+        }
+
+        // 預先分配該層關鍵點的記憶體空間，容器由呼叫者跨影格重複使用，所以先清空
+        vDistributedKeyPoints.clear();
+        vDistributedKeyPoints.reserve(quadTree.mnNodes);
+        for(int iNode = quadTree.miHead; iNode != -1; iNode = quadTree.mvNodes[iNode].miNext) {
+            const RegionalQuadTreeNode &node = quadTree.mvNodes[iNode];
+            // 取得該 Node 中品質最耗好的關鍵點
+            // 分裂時是就地重新排列關鍵點指標，所以分數相同時選擇原本順序較前 (位址較小) 的關鍵點
+            float fMaxResponse = -INFINITY;
+            KeyPoint* pKeyPoint = nullptr;
+            vector<KeyPoint*>::iterator vitBegin = quadTree.mvpKeyPoints.begin() + node.miBegin;
+            vector<KeyPoint*>::iterator vitEnd = quadTree.mvpKeyPoints.begin() + node.miEnd;
+            for(vector<KeyPoint*>::iterator vit = vitBegin; vit != vitEnd; ++vit) {
+                if((*vit)->response > fMaxResponse || ((*vit)->response == fMaxResponse && (*vit) < pKeyPoint)) {
+                    fMaxResponse = (*vit)->response;
+                    pKeyPoint = (*vit);
+                }
+            }
+
+            // 儲存該 Node 的關鍵點
+            vDistributedKeyPoints.push_back(*pKeyPoint);
+        }
+    }
+
+    /*
+    @brief 網格分桶均勻化：每個格子保留分數最高的 K 個關鍵點，數量不足時再從其餘關鍵點中依分數補齊
+    
+    @param[in, out] vDistributedKeyPoints 均勻化後的關鍵點，會先被清空
+    @param[in] vKeyPoints 該層影像的關鍵點
+    @param[in] nFeatures 該層影像要提取的關鍵點數量
+    @param[in] area 該層影像中關鍵點所在的範圍
+    @param[in] nUsablePixels 範圍內可以使用的 pixel 數量 */
+    void GridBucketDistribution::distribute(
+        vector<KeyPoint> &vDistributedKeyPoints,
+        vector<KeyPoint> &vKeyPoints,
+        int nFeatures, const Rect &area, int nUsablePixels
+    ) {
+        vDistributedKeyPoints.clear();
+        int nKeyPoints = vKeyPoints.size();
+        if(nKeyPoints == 0 || nFeatures <= 0) { return; }
+
+        // 關鍵點數量不超過需求時全部保留
+        if(nKeyPoints <= nFeatures) {
+            vDistributedKeyPoints.insert(vDistributedKeyPoints.end(), vKeyPoints.begin(), vKeyPoints.end());
+            return;
+        }
+
+        // 分數較高的排前面，分數相同時依原本的順序，讓結果是唯一的
+        auto isBetter = [&vKeyPoints](int i1, int i2) {
+            float f1 = vKeyPoints[i1].response, f2 = vKeyPoints[i2].response;
+            return f1 > f2 || (f1 == f2 && i1 < i2);
+        };
+
+        // 把關鍵點所在的範圍切成正方形格子，讓可以使用的 pixel 約分成 nFeatures 個格子
+        // 外框內被遮住的格子沒有關鍵點，會把名額讓給其他格子
+        float fCellSize = sqrt((float)max(nUsablePixels, 1) / nFeatures);
+        float fInvCellSize = 1.f / fCellSize;
+        int nCols = max(1, (int)ceil(area.width * fInvCellSize));
+        int nRows = max(1, (int)ceil(area.height * fInvCellSize));
+        int nCells = nCols * nRows;
+
+        // 以 counting sort 把關鍵點依格子分桶，只需要線性時間
+        mvnCellOfKeyPoint.resize(nKeyPoints);
+        mvnCellStarts.assign(nCells + 1, 0);
+        for(int i = 0; i < nKeyPoints; i++) {
+            int iCol = min(max((int)((vKeyPoints[i].pt.x - area.x) * fInvCellSize), 0), nCols - 1);
+            int iRow = min(max((int)((vKeyPoints[i].pt.y - area.y) * fInvCellSize), 0), nRows - 1);
+            mvnCellOfKeyPoint[i] = iRow * nCols + iCol;
+            mvnCellStarts[mvnCellOfKeyPoint[i] + 1]++;
+        }
+
+        int nNonEmptyCells = 0;
+        for(int iCell = 0; iCell < nCells; iCell++) {
+            nNonEmptyCells += (mvnCellStarts[iCell + 1] > 0);
+            mvnCellStarts[iCell + 1] += mvnCellStarts[iCell];
+        }
+
+        // 分配後 mvnCellStarts[iCell] 會移到下一個格子的起點
+        mvnBucketed.resize(nKeyPoints);
+        for(int i = 0; i < nKeyPoints; i++)
+            mvnBucketed[mvnCellStarts[mvnCellOfKeyPoint[i]]++] = i;
+
+        // 沒有關鍵點的格子把名額讓給其他格子
+        int K = (nFeatures + nNonEmptyCells - 1) / nNonEmptyCells;
+
+        // 每個格子保留前 K 名
+        mvnSelected.clear();
+        mvnRemaining.clear();
+        vector<int>::iterator vitBegin = mvnBucketed.begin();
+        for(int iCell = 0; iCell < nCells; iCell++) {
+            vector<int>::iterator vitEnd = mvnBucketed.begin() + mvnCellStarts[iCell];
+            if(vitEnd - vitBegin <= K) {
+                mvnSelected.insert(mvnSelected.end(), vitBegin, vitEnd);
+            }
+            else {
+                nth_element(vitBegin, vitBegin + K, vitEnd, isBetter);
+                mvnSelected.insert(mvnSelected.end(), vitBegin, vitBegin + K);
+                mvnRemaining.insert(mvnRemaining.end(), vitBegin + K, vitEnd);
+            }
+            vitBegin = vitEnd;
+        }
+
+        // 名額超過時只保留分數最高的 nFeatures 個，不足時從其餘關鍵點中依分數補齊
+        int nSelected = mvnSelected.size();
+        if(nSelected > nFeatures) {
+            nth_element(mvnSelected.begin(), mvnSelected.begin() + nFeatures, mvnSelected.end(), isBetter);
+            mvnSelected.resize(nFeatures);
+        }
+        else if(nSelected < nFeatures) {
+            int nMissing = min(nFeatures - nSelected, (int)mvnRemaining.size());
+            nth_element(mvnRemaining.begin(), mvnRemaining.begin() + nMissing, mvnRemaining.end(), isBetter);
+            mvnSelected.insert(mvnSelected.end(), mvnRemaining.begin(), mvnRemaining.begin() + nMissing);
+        }
+
+        vDistributedKeyPoints.reserve(mvnSelected.size());
+        for(int i : mvnSelected)
+            vDistributedKeyPoints.push_back(vKeyPoints[i]);
+    }
+
+    /*
+    @brief SSC 自適應非極大值抑制：以二分搜尋找出覆蓋正方形的邊長，讓保留的關鍵點數量接近 nFeatures
+    
+    @param[in, out] vDistributedKeyPoints 均勻化後的關鍵點，依分數由高到低排列，會先被清空
+    @param[in] vKeyPoints 該層影像的關鍵點
+    @param[in] nFeatures 該層影像要提取的關鍵點數量
+    @param[in] area 該層影像中關鍵點所在的範圍
+    @param[in] nUsablePixels 範圍內可以使用的 pixel 數量 */
+    void SSCDistribution::distribute(
+        vector<KeyPoint> &vDistributedKeyPoints,
+        vector<KeyPoint> &vKeyPoints,
+        int nFeatures, const Rect &area, int nUsablePixels
+    ) {
+        vDistributedKeyPoints.clear();
+        int nKeyPoints = vKeyPoints.size();
+        if(nKeyPoints == 0 || nFeatures <= 0) { return; }
+
+        // 依分數由高到低排序，分數相同時依原本的順序
+        mvnSorted.resize(nKeyPoints);
+        for(int i = 0; i < nKeyPoints; i++) { mvnSorted[i] = i; }
+        sort(mvnSorted.begin(), mvnSorted.end(), [&vKeyPoints](int i1, int i2) {
+            float f1 = vKeyPoints[i1].response, f2 = vKeyPoints[i2].response;
+            return f1 > f2 || (f1 == f2 && i1 < i2);
+        });
+
+        // 關鍵點數量不超過需求，或只需要一個關鍵點時，直接依分數保留
+        if(nKeyPoints <= nFeatures || nFeatures == 1) {
+            int nKept = min(nKeyPoints, nFeatures);
+            for(int i = 0; i < nKept; i++)
+                vDistributedKeyPoints.push_back(vKeyPoints[mvnSorted[i]]);
+            return;
+        }
+
+        // 正方形邊長的搜尋範圍，上界為原論文中均勻放置 nFeatures 個點時的解，下界為 sqrt(N / nFeatures)
+        // 關鍵點只會落在可以使用的 pixel 上，所以把範圍依可以使用的比例等比縮小後再求上界
+        double dScale = sqrt((double)max(nUsablePixels, 1) / max(area.area(), 1));
+        double dRows = area.height * dScale, dCols = area.width * dScale, dK = nFeatures;
+        double dExp1 = dRows + dCols + 2 * dK;
+        double dExp2 = 4 * dCols + 4 * dK + 4 * dRows * dK + dRows * dRows + dCols * dCols - 2 * dRows * dCols + 4 * dRows * dCols * dK;
+        double dExp3 = sqrt(dExp2);
+        double dSol1 = -round((dExp1 + dExp3) / (dK - 1));
+        double dSol2 = -round((dExp1 - dExp3) / (dK - 1));
+        int iHigh = (int)max(dSol1, dSol2);
+        int iLow = (int)floor(sqrt((double)nKeyPoints / dK));
+
+        // 保留數量落在 nFeatures 的容許範圍內就停止
+        int nMinKept = (int)(nFeatures * (1.f - mfTolerance));
+        int nMaxKept = (int)(nFeatures * (1.f + mfTolerance));
+
+        mvnBestKept.clear();
+        int iPrevSide = -1;
+        while(iLow <= iHigh) {
+            int iSide = iLow + (iHigh - iLow) / 2;
+            if(iSide == iPrevSide) { break; }
+            iPrevSide = iSide;
+
+            // 以邊長一半的格子記錄覆蓋範圍，一個關鍵點會覆蓋它周圍 2 * nSpan + 1 個格子寬的正方形
+            int iCellSize = max(iSide / 2, 1);
+            int nCellCols = area.width / iCellSize + 1;
+            int nCellRows = area.height / iCellSize + 1;
+            int nSpan = iSide / iCellSize;
+            mvbCovered.assign((size_t)nCellCols * nCellRows, 0);
+
+            // 依分數由高到低，保留還沒有被覆蓋的關鍵點
+            mvnKept.clear();
+            for(int i : mvnSorted) {
+                int iCol = min(max((int)((vKeyPoints[i].pt.x - area.x) / iCellSize), 0), nCellCols - 1);
+                int iRow = min(max((int)((vKeyPoints[i].pt.y - area.y) / iCellSize), 0), nCellRows - 1);
+                if(mvbCovered[iRow * nCellCols + iCol]) { continue; }
+
+                mvnKept.push_back(i);
+                int iMinRow = max(iRow - nSpan, 0), iMaxRow = min(iRow + nSpan, nCellRows - 1);
+                int iMinCol = max(iCol - nSpan, 0), iMaxCol = min(iCol + nSpan, nCellCols - 1);
+                for(int iCoverRow = iMinRow; iCoverRow <= iMaxRow; iCoverRow++)
+                    fill(mvbCovered.begin() + iCoverRow * nCellCols + iMinCol, mvbCovered.begin() + iCoverRow * nCellCols + iMaxCol + 1, 1);
+            }
+
+            // 最後一次搜尋的結果就是輸出
+            swap(mvnBestKept, mvnKept);
+            int nKept = mvnBestKept.size();
+            if(nKept >= nMinKept && nKept <= nMaxKept) { break; }
+
+            // 保留太少代表正方形太大，反之太小
+            if(nKept < nMinKept) { iHigh = iSide - 1; }
+            else { iLow = iSide + 1; }
+        }
+
+        // 搜尋範圍無效時 (例如影像太小)，退回直接依分數保留
+        const vector<int> &vnKept = mvnBestKept.empty() ? mvnSorted : mvnBestKept;
+
+        // 保留的關鍵點已經依分數排列，超過 nFeatures 時捨棄分數最低的部分
+        int nKept = min((int)vnKept.size(), nFeatures);
+        vDistributedKeyPoints.reserve(nKept);
+        for(int i = 0; i < nKept; i++)
+            vDistributedKeyPoints.push_back(vKeyPoints[vnKept[i]]);
+    }
+}
@@ -1,11 +1,78 @@
 #include "myORB-SLAM2/Distributor.h"
 
 namespace my_ORB_SLAM2 {
+    /*
+    @brief 設定所有層級使用的均勻化策略
+    
+    @param[in] eStrategy 均勻化策略 */
+    void Distributor::setStrategy(Strategy eStrategy) {
+        meDefaultStrategy = eStrategy;
+        mveStrategiesPerLevel.clear();
+    }
+
+    /*
+    @brief 設定某一層影像使用的均勻化策略
+    
+    @param[in] iLevel 影像金字塔的層級
+    @param[in] eStrategy 均勻化策略 */
+    void Distributor::setStrategy(int iLevel, Strategy eStrategy) {
+        if(iLevel >= (int)mveStrategiesPerLevel.size())
+            mveStrategiesPerLevel.resize(iLevel + 1, meDefaultStrategy);
+        mveStrategiesPerLevel[iLevel] = eStrategy;
+    }
+
+    /*
+    @brief 取得某一層影像使用的均勻化策略
+    
+    @param[in] iLevel 影像金字塔的層級 */
+    DistributionStrategy* Distributor::getStrategy(int iLevel) {
+        Strategy eStrategy = iLevel < (int)mveStrategiesPerLevel.size() ? mveStrategiesPerLevel[iLevel] : meDefaultStrategy;
+        switch(eStrategy) {
+            case GRID_BUCKET: return &mGridBucketDistribution;
+            case SSC: return &mSSCDistribution;
+            default: return &mQuadTreeDistribution;
+        }
+    }
+
+    /*
+    @brief 設定每一層影像的靜態遮罩，記錄每一層遮罩中可以使用的 pixel 的外框
+    
+    @param[in] vMasks 每一層影像的遮罩，非 0 代表可以使用 */
+    void Distributor::setMasks(const vector<Mat> &vMasks) {
+        mvMaskAreas.assign(vMasks.size(), Rect());
+        mvMaskSizes.assign(vMasks.size(), Size());
+        mvnMaskPixels.assign(vMasks.size(), 0);
+        for(size_t iLevel = 0; iLevel < vMasks.size(); iLevel++) {
+            const Mat &mask = vMasks[iLevel];
+            mvMaskSizes[iLevel] = mask.size();
+            mvnMaskPixels[iLevel] = countNonZero(mask);
+            int iMinX = mask.cols, iMinY = mask.rows, iMaxX = -1, iMaxY = -1;
+            for(int iY = 0; iY < mask.rows; iY++) {
+                const uchar* pRow = mask.ptr<uchar>(iY);
+                int iX = 0;
+                while(iX < mask.cols && pRow[iX] == 0) { iX++; }
+                if(iX == mask.cols) { continue; }
+
+                // 該列有可以使用的 pixel，再從右邊找最後一個
+                iMinX = min(iMinX, iX);
+                iX = mask.cols - 1;
+                while(pRow[iX] == 0) { iX--; }
+                iMaxX = max(iMaxX, iX);
+                iMinY = min(iMinY, iY);
+                iMaxY = iY;
+            }
+
+            // 整層都被遮住時保持空的外框，均勻化時改用整張影像
+            if(iMaxY >= 0)
+                mvMaskAreas[iLevel] = Rect(iMinX, iMinY, iMaxX - iMinX + 1, iMaxY - iMinY + 1);
+        }
+    }
+
     /*
     @brief 用於均勻化，對應於影像金字塔中每一層的關鍵點
     
     @param[in, out] vvDistributedKeyPointsPerLevel 用於取得均勻化的關鍵點容器
-    @param[in] vvKeyPointsPerLevel 對應於影像金字塔中每一層的關鍵點
+    @param[in, out] vvKeyPointsPerLevel 對應於影像金字塔中每一層的關鍵點，有遮罩時會移除遮罩外框以外的關鍵點
     @param[in] vnFeaturesPerLevel 對應於影像金字塔中每一層的待提取關鍵點數
     @param[in] vImagePerLevel 影像金字塔中每一層的影像 */
     void Distributor::distribute(
@@ -18,84 +85,31 @@ namespace my_ORB_SLAM2 {
         // 對應於影像金字塔中的每一層影像
         vvDistributedKeyPointsPerLevel.resize(vImagePerLevel.size());
 
-        // 遍歷影像金字塔
-        for(int iLevel = 0; iLevel < vImagePerLevel.size(); iLevel++) {
-            // 設定關鍵點區域四叉樹
-            int iWidth, iHeight; // 取得該層影像的長寬
-            iWidth = vImagePerLevel[iLevel].cols;
-            iHeight = vImagePerLevel[iLevel].rows;
-            vector<KeyPoint> &vKeyPoints = vvKeyPointsPerLevel[iLevel];
-            RegionalQuadTree quadTree(iWidth, iHeight, vKeyPoints);
-
-            // 開始分裂四叉樹節點
-            while(true) {
-                // 取得四叉樹的 Nodes 迭代器
-                list<RegionalQuadTreeNode>::iterator lit = 
-                quadTree.mlNodes.begin();
+        // 遍歷影像金字塔，每一層影像使用各自設定的均勻化策略
+        for(int iLevel = 0; iLevel < (int)vImagePerLevel.size(); iLevel++) {
+            // 有遮罩時只在可以使用的範圍內劃分空間，遮罩大小與該層影像不同時不使用遮罩 (與 KeyPointExtractor 相同)
+            Rect area(0, 0, vImagePerLevel[iLevel].cols, vImagePerLevel[iLevel].rows);
+            int nUsablePixels = area.area();
+            if(iLevel < (int)mvMaskAreas.size() && mvMaskSizes[iLevel] == area.size() && !mvMaskAreas[iLevel].empty()) {
+                area = mvMaskAreas[iLevel];
+                nUsablePixels = mvnMaskPixels[iLevel];
 
-                // 計算目前有幾個 Node 可以分裂
-                int nDistribution = 0;
-                while(lit != quadTree.mlNodes.end()) {
-                    if(lit->mvpKeyPoints.size() > 1) { nDistribution++; }
-                    lit++;
-                }
-
-                // 如果目前沒有可以分裂的 Node，就結束 Loop
-                if(nDistribution == 0) { break; }
-                
-                // 如果目前有可以分裂的 Node
-                // 就計算下一輪分裂完之後，此四叉樹大概會有幾個 Nodes
-                int nNextNodes = quadTree.mlNodes.size() + nDistribution * 3;
-
-                // 如果下一輪的 Nodes 數量小於該層總共要提取的關鍵點數量
-                // 那就把除了關鍵點數量為 1 的 Node之外，剩餘的所有 Nodes 都分裂一次
-                if(nNextNodes < vnFeaturesPerLevel[iLevel]) {
-                    lit = quadTree.mlNodes.begin();
-                    while(lit != quadTree.mlNodes.end())
-                        lit = quadTree.divide(lit);
-                }
-                // 否則就分裂最後一次
-                else {
-                    // 判斷 Nodes 數是否達標
-                    bool bComplete = false;
-
-                    // 先依照關鍵點數量由大到小排序
-                    quadTree.mlNodes.sort([](const RegionalQuadTreeNode &n1, const RegionalQuadTreeNode &n2) { return n1.mvpKeyPoints.size() > n2.mvpKeyPoints.size();});
-                    
-                    // 從最多關鍵點的 Node 開始分裂
-                    lit = quadTree.mlNodes.begin();
-                    while(lit != quadTree.mlNodes.end()) {
-                        lit = quadTree.divide(lit);
-
-                        // 如果 Noeds 數量達標，就停止分裂
-                        if(quadTree.mlNodes.size() >= vnFeaturesPerLevel[iLevel]) {
-                            bComplete = true;
-                            break;
-                        }
-                    } 
-                    
-                    // 結束整個分裂流程
-                    if(bComplete) { break; }
-                }
+                // 範圍以外的關鍵點落在被遮住的 pixel 上，先移除，四叉樹的根節點才會包含所有關鍵點
+                vector<KeyPoint> &vKeyPoints = vvKeyPointsPerLevel[iLevel];
+                vKeyPoints.erase(
+                    remove_if(vKeyPoints.begin(), vKeyPoints.end(), [&area](const KeyPoint &keyPoint) {
+                        return !area.contains(Point((int)keyPoint.pt.x, (int)keyPoint.pt.y));
+                    }),
+                    vKeyPoints.end()
+                );
             }
 
-            // 預先分配該層關鍵點的記憶體空間
-            vvDistributedKeyPointsPerLevel[iLevel].reserve(quadTree.mlNodes.size());
-            for(RegionalQuadTreeNode &node : quadTree.mlNodes) {
-                // 取得該 Node 中品質最耗好的關鍵點
-                float fMaxResponse = -INFINITY;
-                KeyPoint* pKeyPoint = nullptr;
-                vector<KeyPoint*> &keyPoints = node.mvpKeyPoints;
-                for(vector<KeyPoint*>::iterator vit = keyPoints.begin(); vit != keyPoints.end(); ++vit) {
-                    if((*vit)->response > fMaxResponse) {
-                        fMaxResponse = (*vit)->response;
-                        pKeyPoint = (*vit);
-                    }
-                }
-
-                // 根據對應的金字塔層級儲存該關鍵點
-                vvDistributedKeyPointsPerLevel[iLevel].push_back(*pKeyPoint);
-            }
+            getStrategy(iLevel)->distribute(
+                vvDistributedKeyPointsPerLevel[iLevel],
+                vvKeyPointsPerLevel[iLevel],
+                vnFeaturesPerLevel[iLevel],
+                area, nUsablePixels
+            );
         }
     };
 
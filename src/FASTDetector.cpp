@@ -0,0 +1,399 @@
+#include "myORB-SLAM2/FASTDetector.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FAST_DETECTOR_X86
+#endif
+
+namespace my_ORB_SLAM2 {
+
+/*
+@brief Compute the offsets of the 16 circle pixels (plus 9 wrapped ones used by the score), 
+in the same order as OpenCV so that scores are bit-exact.
+
+@param[in, out] pPixel: 25 offsets relative to the center pixel.
+@param[in] nStep: Number of bytes of an image row. */
+static void makeOffsets(int pPixel[25], int nStep) {
+    static const int offsets[16][2] = {
+        {0,  3}, { 1,  3}, { 2,  2}, { 3,  1}, { 3, 0}, { 3, -1}, { 2, -2}, { 1, -3},
+        {0, -3}, {-1, -3}, {-2, -2}, {-3, -1}, {-3, 0}, {-3,  1}, {-2,  2}, {-1,  3}
+    };
+
+    for(int k = 0; k < 16; ++k)
+        pPixel[k] = offsets[k][0] + offsets[k][1] * nStep;
+    for(int k = 16; k < 25; ++k)
+        pPixel[k] = pPixel[k - 16];
+}
+
+/*
+@brief Corner score of a pixel that already passed the segment test. 
+This is the largest threshold for which the pixel is still a corner (OpenCV's cornerScore<16>).
+
+@param[in] pCenter: Pointer to the pixel.
+@param[in] pPixel: Offsets of the circle pixels.
+@param[in] iThreshold: Threshold used by the segment test. */
+static inline int cornerScore(const uchar* pCenter, const int* pPixel, int iThreshold) {
+    // Intensity differences between the center and the circle, the first 9 repeated at the end.
+    int v = pCenter[0];
+    short d[25];
+    for(int k = 0; k < 25; ++k)
+        d[k] = (short)(v - pCenter[pPixel[k]]);
+
+    // Darker circle: the best arc of 9 pixels whose smallest difference is the largest.
+    int a0 = iThreshold;
+    for(int k = 0; k < 16; k += 2) {
+        int a = min((int)d[k + 1], (int)d[k + 2]);
+        a = min(a, (int)d[k + 3]);
+        if(a <= a0) { continue; }
+        a = min(a, (int)d[k + 4]);
+        a = min(a, (int)d[k + 5]);
+        a = min(a, (int)d[k + 6]);
+        a = min(a, (int)d[k + 7]);
+        a = min(a, (int)d[k + 8]);
+        a0 = max(a0, min(a, (int)d[k]));
+        a0 = max(a0, min(a, (int)d[k + 9]));
+    }
+
+    // Brighter circle: same search with the signs flipped.
+    int b0 = -a0;
+    for(int k = 0; k < 16; k += 2) {
+        int b = max((int)d[k + 1], (int)d[k + 2]);
+        b = max(b, (int)d[k + 3]);
+        b = max(b, (int)d[k + 4]);
+        b = max(b, (int)d[k + 5]);
+        if(b >= b0) { continue; }
+        b = max(b, (int)d[k + 6]);
+        b = max(b, (int)d[k + 7]);
+        b = max(b, (int)d[k + 8]);
+        b0 = min(b0, max(b, (int)d[k]));
+        b0 = min(b0, max(b, (int)d[k + 9]));
+    }
+
+    return -b0 - 1;
+}
+
+/*
+@brief Check whether a 16-bit circle mask contains 9 contiguous set bits (wrapping around).
+
+@param[in] nMask: Bit k is set when circle pixel k passes the test. */
+static inline bool hasArc(uint32_t nMask) {
+    uint32_t m = nMask | (nMask << 16);
+    uint32_t x = m & (m >> 1); // runs of 2
+    x &= x >> 2; // runs of 4
+    x &= x >> 4; // runs of 8
+    x &= m >> 8; // runs of 9
+    return (x & 0xFFFF) != 0;
+}
+
+/*
+@brief Same test as hasArc(), but for up to 64 pixels at once. 
+Entry k holds one bit per pixel telling whether its circle pixel k passes the test.
+
+@param[in] pMasks: 16 lane masks, one per circle pixel. */
+static inline uint64_t arcLanes(const uint64_t pMasks[16]) {
+    uint64_t runs2[16], runs4[16], result = 0;
+    for(int k = 0; k < 16; ++k)
+        runs2[k] = pMasks[k] & pMasks[(k + 1) & 15];
+    for(int k = 0; k < 16; ++k)
+        runs4[k] = runs2[k] & runs2[(k + 2) & 15];
+    for(int k = 0; k < 16; ++k)
+        result |= runs4[k] & runs4[(k + 4) & 15] & pMasks[(k + 8) & 15];
+    return result;
+}
+
+/*
+@brief Score a run of pixels one at a time.
+
+@param[in] pCenter: Pointer to the first pixel.
+@param[in, out] pScore: Scores to be written.
+@param[in] nPixels: Number of pixels.
+@param[in] pPixel: Offsets of the circle pixels.
+@param[in] iThreshold: Segment test threshold. */
+static void scoreRowScalar(const uchar* pCenter, uchar* pScore, int nPixels, const int* pPixel, int iThreshold) {
+    for(int i = 0; i < nPixels; ++i) {
+        const uchar* p = pCenter + i;
+        int vBright = p[0] + iThreshold;
+        int vDark = p[0] - iThreshold;
+        pScore[i] = 0;
+
+        // Any arc of 9 pixels covers one of {0, 8} and one of {4, 12}, so test those first.
+        uint32_t nBright = 0, nDark = 0;
+        for(int k = 0; k < 16; k += 4) {
+            int x = p[pPixel[k]];
+            nBright |= uint32_t(x > vBright) << k;
+            nDark |= uint32_t(x < vDark) << k;
+        }
+        bool bBright = (nBright & 0x0101) && (nBright & 0x1010);
+        bool bDark = (nDark & 0x0101) && (nDark & 0x1010);
+        if(!bBright && !bDark) { continue; }
+
+        // Full segment test.
+        for(int k = 1; k < 16; ++k) {
+            if((k & 3) == 0) { continue; }
+            int x = p[pPixel[k]];
+            nBright |= uint32_t(x > vBright) << k;
+            nDark |= uint32_t(x < vDark) << k;
+        }
+        if(hasArc(nBright) || hasArc(nDark))
+            pScore[i] = (uchar)cornerScore(p, pPixel, iThreshold);
+    }
+}
+
+/*
+@brief Write the scores of the corners found in a block of pixels.
+
+@param[in] pCenter: Pointer to the first pixel of the block.
+@param[in, out] pScore: Scores of the block, already zeroed.
+@param[in] nCorners: One bit per corner pixel in the block.
+@param[in] pPixel: Offsets of the circle pixels.
+@param[in] iThreshold: Segment test threshold. */
+static inline void scoreCorners(const uchar* pCenter, uchar* pScore, uint64_t nCorners, const int* pPixel, int iThreshold) {
+    while(nCorners) {
+        int i = __builtin_ctzll(nCorners);
+        pScore[i] = (uchar)cornerScore(pCenter + i, pPixel, iThreshold);
+        nCorners &= nCorners - 1;
+    }
+}
+
+#ifdef FAST_DETECTOR_X86
+
+// 16 pixels per iteration. SSE2 only has signed byte compares, so both sides are shifted by 0x80.
+__attribute__((target("sse2")))
+static void scoreRowSSE2(const uchar* pCenter, uchar* pScore, int nPixels, const int* pPixel, int iThreshold) {
+    const __m128i delta = _mm_set1_epi8((char)0x80);
+    const __m128i threshold = _mm_set1_epi8((char)iThreshold);
+    const __m128i zero = _mm_setzero_si128();
+
+    int i = 0;
+    for(; i + 16 <= nPixels; i += 16) {
+        const uchar* p = pCenter + i;
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i vBright = _mm_xor_si128(_mm_adds_epu8(v, threshold), delta);
+        __m128i vDark = _mm_xor_si128(_mm_subs_epu8(v, threshold), delta);
+        _mm_storeu_si128((__m128i*)(pScore + i), zero);
+
+        uint64_t bright[16], dark[16];
+        for(int k = 0; k < 16; k += 4) {
+            __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + pPixel[k])), delta);
+            bright[k] = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(x, vBright));
+            dark[k] = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(vDark, x));
+        }
+        uint64_t nCandidates = ((bright[0] | bright[8]) & (bright[4] | bright[12])) |
+                               ((dark[0] | dark[8]) & (dark[4] | dark[12]));
+        if(nCandidates == 0) { continue; }
+
+        for(int k = 1; k < 16; ++k) {
+            if((k & 3) == 0) { continue; }
+            __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + pPixel[k])), delta);
+            bright[k] = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(x, vBright));
+            dark[k] = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(vDark, x));
+        }
+        scoreCorners(p, pScore + i, (arcLanes(bright) | arcLanes(dark)) & nCandidates, pPixel, iThreshold);
+    }
+
+    scoreRowScalar(pCenter + i, pScore + i, nPixels - i, pPixel, iThreshold);
+}
+
+// 32 pixels per iteration.
+__attribute__((target("avx2")))
+static void scoreRowAVX2(const uchar* pCenter, uchar* pScore, int nPixels, const int* pPixel, int iThreshold) {
+    const __m256i delta = _mm256_set1_epi8((char)0x80);
+    const __m256i threshold = _mm256_set1_epi8((char)iThreshold);
+    const __m256i zero = _mm256_setzero_si256();
+
+    int i = 0;
+    for(; i + 32 <= nPixels; i += 32) {
+        const uchar* p = pCenter + i;
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i vBright = _mm256_xor_si256(_mm256_adds_epu8(v, threshold), delta);
+        __m256i vDark = _mm256_xor_si256(_mm256_subs_epu8(v, threshold), delta);
+        _mm256_storeu_si256((__m256i*)(pScore + i), zero);
+
+        uint64_t bright[16], dark[16];
+        for(int k = 0; k < 16; k += 4) {
+            __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + pPixel[k])), delta);
+            bright[k] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(x, vBright));
+            dark[k] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(vDark, x));
+        }
+        uint64_t nCandidates = ((bright[0] | bright[8]) & (bright[4] | bright[12])) |
+                               ((dark[0] | dark[8]) & (dark[4] | dark[12]));
+        if(nCandidates == 0) { continue; }
+
+        for(int k = 1; k < 16; ++k) {
+            if((k & 3) == 0) { continue; }
+            __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + pPixel[k])), delta);
+            bright[k] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(x, vBright));
+            dark[k] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(vDark, x));
+        }
+        scoreCorners(p, pScore + i, (arcLanes(bright) | arcLanes(dark)) & nCandidates, pPixel, iThreshold);
+    }
+
+    scoreRowScalar(pCenter + i, pScore + i, nPixels - i, pPixel, iThreshold);
+}
+
+// 64 pixels per iteration. AVX-512BW has unsigned byte compares that write straight into mask registers.
+__attribute__((target("avx512f,avx512bw")))
+static void scoreRowAVX512BW(const uchar* pCenter, uchar* pScore, int nPixels, const int* pPixel, int iThreshold) {
+    const __m512i threshold = _mm512_set1_epi8((char)iThreshold);
+    const __m512i zero = _mm512_setzero_si512();
+
+    int i = 0;
+    for(; i + 64 <= nPixels; i += 64) {
+        const uchar* p = pCenter + i;
+        __m512i v = _mm512_loadu_si512((const void*)p);
+        __m512i vBright = _mm512_adds_epu8(v, threshold);
+        __m512i vDark = _mm512_subs_epu8(v, threshold);
+        _mm512_storeu_si512((void*)(pScore + i), zero);
+
+        uint64_t bright[16], dark[16];
+        for(int k = 0; k < 16; k += 4) {
+            __m512i x = _mm512_loadu_si512((const void*)(p + pPixel[k]));
+            bright[k] = _mm512_cmpgt_epu8_mask(x, vBright);
+            dark[k] = _mm512_cmplt_epu8_mask(x, vDark);
+        }
+        uint64_t nCandidates = ((bright[0] | bright[8]) & (bright[4] | bright[12])) |
+                               ((dark[0] | dark[8]) & (dark[4] | dark[12]));
+        if(nCandidates == 0) { continue; }
+
+        for(int k = 1; k < 16; ++k) {
+            if((k & 3) == 0) { continue; }
+            __m512i x = _mm512_loadu_si512((const void*)(p + pPixel[k]));
+            bright[k] = _mm512_cmpgt_epu8_mask(x, vBright);
+            dark[k] = _mm512_cmplt_epu8_mask(x, vDark);
+        }
+        scoreCorners(p, pScore + i, (arcLanes(bright) | arcLanes(dark)) & nCandidates, pPixel, iThreshold);
+    }
+
+    scoreRowScalar(pCenter + i, pScore + i, nPixels - i, pPixel, iThreshold);
+}
+
+#endif // FAST_DETECTOR_X86
+
+/*
+@brief FAST-9 (16-pixel circle) detector using the best kernel the CPU supports. */
+FASTDetector::FASTDetector(): meInstruction(detectInstruction()) {}
+
+/*
+@brief FAST-9 detector forced onto a specific kernel. 
+
+@param[in] eInstruction: Instruction set to use; it must be supported by this CPU. */
+FASTDetector::FASTDetector(Instruction eInstruction): meInstruction(eInstruction) {
+    CV_Assert(isSupported(eInstruction));
+}
+
+/*
+@brief Query CPUID once and return the widest supported instruction set. */
+FASTDetector::Instruction FASTDetector::detectInstruction() {
+    static const Instruction eInstruction = []() {
+        if(isSupported(AVX512BW)) { return AVX512BW; }
+        if(isSupported(AVX2)) { return AVX2; }
+        if(isSupported(SSE2)) { return SSE2; }
+        return SCALAR;
+    }();
+    return eInstruction;
+}
+
+/*
+@brief Check whether this CPU can run a given kernel.
+
+@param[in] eInstruction: Instruction set to check. */
+bool FASTDetector::isSupported(Instruction eInstruction) {
+#ifdef FAST_DETECTOR_X86
+    __builtin_cpu_init();
+    switch(eInstruction) {
+        case SCALAR: return true;
+        case SSE2: return __builtin_cpu_supports("sse2");
+        case AVX2: return __builtin_cpu_supports("avx2");
+        case AVX512BW: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+    return false;
+#else
+    return eInstruction == SCALAR;
+#endif
+}
+
+/*
+@brief Write the FAST-9 score of every pixel in a region into a score map.
+
+@param[in] image: 8-bit single-channel image.
+@param[in, out] scoreMap: 8-bit map with the same size as image. Only pixels inside roi are written.
+@param[in] roi: Region to score. It must stay at least 3 pixels away from the image border.
+@param[in] iThreshold: Segment test threshold, clamped to [1, 255]. */
+void FASTDetector::computeScores(const Mat &image, Mat &scoreMap, const Rect &roi, int iThreshold) {
+    CV_Assert(image.type() == CV_8U && scoreMap.type() == CV_8U);
+    CV_Assert(roi.x >= 3 && roi.y >= 3 && roi.x + roi.width <= image.cols - 3 && roi.y + roi.height <= image.rows - 3);
+
+    // A zero threshold would make a zero-score corner look like an empty pixel.
+    iThreshold = min(max(iThreshold, 1), 255);
+
+    // Offsets of the circle pixels depend on the row stride.
+    int pPixel[25];
+    makeOffsets(pPixel, (int)image.step);
+
+    for(int iY = roi.y; iY < roi.y + roi.height; ++iY) {
+        const uchar* pCenter = image.ptr<uchar>(iY) + roi.x;
+        uchar* pScore = scoreMap.ptr<uchar>(iY) + roi.x;
+
+        switch(meInstruction) {
+#ifdef FAST_DETECTOR_X86
+            case AVX512BW: scoreRowAVX512BW(pCenter, pScore, roi.width, pPixel, iThreshold); break;
+            case AVX2: scoreRowAVX2(pCenter, pScore, roi.width, pPixel, iThreshold); break;
+            case SSE2: scoreRowSSE2(pCenter, pScore, roi.width, pPixel, iThreshold); break;
+#endif
+            default: scoreRowScalar(pCenter, pScore, roi.width, pPixel, iThreshold); break;
+        }
+    }
+}
+
+/*
+@brief Detect FAST-9 corners. The output matches cv::FAST(image, vKeyPoints, iThreshold, bNonmaxSuppression).
+
+@param[in] image: 8-bit single-channel image.
+@param[in, out] vKeyPoints: Detected corners, in row-major order.
+@param[in] iThreshold: Segment test threshold, clamped to [1, 255].
+@param[in] bNonmaxSuppression: Whether to keep only local maxima of the 3x3 neighbourhood. */
+void FASTDetector::detect(const Mat &image, vector<KeyPoint> &vKeyPoints, int iThreshold, bool bNonmaxSuppression) {
+    vKeyPoints.clear();
+    if(image.rows < 7 || image.cols < 7) { return; }
+
+    // Borrow a block of the score buffer with the size of the image.
+    reserve(image.rows, image.cols);
+    Mat scoreMap = mScoreBuffer.rowRange(0, image.rows).colRange(0, image.cols);
+
+    // The 3-pixel ring is never scored, it has to read as "no corner" during suppression.
+    scoreMap.setTo(Scalar(0));
+    computeScores(image, scoreMap, Rect(3, 3, image.cols - 6, image.rows - 6), iThreshold);
+
+    for(int iY = 3; iY < image.rows - 3; ++iY) {
+        const uchar* pPrev = scoreMap.ptr<uchar>(iY - 1);
+        const uchar* pCurr = scoreMap.ptr<uchar>(iY);
+        const uchar* pNext = scoreMap.ptr<uchar>(iY + 1);
+
+        for(int iX = 3; iX < image.cols - 3; ++iX) {
+            int score = pCurr[iX];
+            if(score == 0) { continue; }
+
+            // Keep a corner only if its score is strictly larger than all 8 neighbours.
+            if(bNonmaxSuppression && !(
+                score > pPrev[iX - 1] && score > pPrev[iX] && score > pPrev[iX + 1] &&
+                score > pCurr[iX - 1] && score > pCurr[iX + 1] &&
+                score > pNext[iX - 1] && score > pNext[iX] && score > pNext[iX + 1]
+            )) { continue; }
+
+            // cv::FAST only reports a response when suppression is enabled.
+            vKeyPoints.emplace_back((float)iX, (float)iY, 7.f, -1, bNonmaxSuppression ? (float)score : 0.f);
+        }
+    }
+}
+
+/*
+@brief Grow the score buffer of detect() in advance, so images up to this size never allocate.
+
+@param[in] nRows: Largest image height passed to detect().
+@param[in] nCols: Largest image width passed to detect(). */
+void FASTDetector::reserve(int nRows, int nCols) {
+    if(mScoreBuffer.rows < nRows || mScoreBuffer.cols < nCols)
+        mScoreBuffer.create(max(mScoreBuffer.rows, nRows), max(mScoreBuffer.cols, nCols), CV_8U);
+}
+
+} // my_ORB_SLAM2
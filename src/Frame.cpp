@@ -1,4 +1,5 @@
 #include "myORB-SLAM2/Frame.h"
+#include "myORB-SLAM2/FramePool.h"
 
 namespace my_ORB_SLAM2 {
 
@@ -8,13 +9,31 @@ unsigned long Frame::mNextID = 0;
 /*
 @brief Constructor for a regular frame object.
 
-@param[in] vfScaleFactors: Scale factor of each level used to map coordinates back to level 0. 
-@param[in] pvvKeyPointsPerLevel: Pointer to the pyramid that contains keypoints. 
-@param[in] pvvDescriptorsPerLevel: Pointer to the pyramid that contains descriptors. */
+@param[in] imageSize: Size of the image at level 0, which the grid covers.
+@param[in] vfScaleFactors: Scale factor of each level used to map coordinates back to level 0.
+@param[in] vvKeyPointsPerLevel: Keypoints in the pyramid.
+@param[in] vvDescriptorsPerLevel: Descriptors in the pyramid. */
 Frame::Frame(
+    const Size& imageSize,
     const vector<float>& vfScaleFactors,
-    vector<vector<KeyPoint>>* pvvKeyPointsPerLevel,
-    vector<vector<Descriptor>>* pvvDescriptorsPerLevel
+    const vector<vector<KeyPoint>>& vvKeyPointsPerLevel,
+    const vector<vector<Descriptor>>& vvDescriptorsPerLevel
+): mnReferences(0) {
+    assign(imageSize, vfScaleFactors, vvKeyPointsPerLevel, vvDescriptorsPerLevel);
+}
+
+/*
+@brief Fill the frame with new data as a new frame, reusing the storage it already has.
+
+@param[in] imageSize: Size of the image at level 0, which the grid covers.
+@param[in] vfScaleFactors: Scale factor of each level used to map coordinates back to level 0.
+@param[in] vvKeyPointsPerLevel: Keypoints in the pyramid.
+@param[in] vvDescriptorsPerLevel: Descriptors in the pyramid. */
+void Frame::assign(
+    const Size& imageSize,
+    const vector<float>& vfScaleFactors,
+    const vector<vector<KeyPoint>>& vvKeyPointsPerLevel,
+    const vector<vector<Descriptor>>& vvDescriptorsPerLevel
 ) {
     // Assign the ID of this frame
     mID = mNextID++;
@@ -22,21 +41,181 @@ Frame::Frame(
     // Record the creation time of this frame.
     mTimePoint = chrono::steady_clock::now();
 
-    // Copy scale factors, pvvKeyPointsPerLevel and pvvDescriptorsPerLevel.
+    // A recycled frame has no pose yet.
+    mTcw.release();
+
+    // Copy scale factors.
     mvfScaleFactors = vfScaleFactors;
-    mpvvKeyPointsPerLevel = pvvKeyPointsPerLevel;
-    mpvvDescriptorsPerLevel = pvvDescriptorsPerLevel;
-
-    // Iterator over keypoints of the pyramid.
-    int iLevel = 0;
-    for(vector<KeyPoint>& mvKeyPoints : *mpvvKeyPointsPerLevel) {
-        // No need to process keypoints at level 0.
-        if(iLevel == 0) { iLevel++; continue; }
-
-        // Map each keypoint's coordinates to level 0 according to its level in the pyramid.
-        for(KeyPoint& mKeyPoint : mvKeyPoints)
-            mKeyPoint.pt *= mvfScaleFactors[mKeyPoint.octave];
+
+    // Every keypoint needs its descriptor and every level its scale factor, the copy below relies on both.
+    int nLevels = vvKeyPointsPerLevel.size();
+    CV_Assert(vvDescriptorsPerLevel.size() == vvKeyPointsPerLevel.size() && vfScaleFactors.size() >= vvKeyPointsPerLevel.size());
+    for(int iLevel = 0; iLevel < nLevels; ++iLevel)
+        CV_Assert(vvDescriptorsPerLevel[iLevel].size() == vvKeyPointsPerLevel[iLevel].size());
+
+    // Offsets of the levels in the arrays.
+    mvnLevelOffsets.resize(nLevels + 1);
+    mvnLevelOffsets[0] = 0;
+    for(int iLevel = 0; iLevel < nLevels; ++iLevel)
+        mvnLevelOffsets[iLevel + 1] = mvnLevelOffsets[iLevel] + vvKeyPointsPerLevel[iLevel].size();
+    mnKeyPoints = mvnLevelOffsets[nLevels];
+
+    // One block for all the arrays: 4 float arrays, the descriptors, then the octaves.
+    // Padding to 8 keypoints keeps every array on a 32-byte boundary.
+    // The block only grows, with some headroom, so a recycled frame normally keeps the block it has.
+    int nCapacity = (mnKeyPoints + 7) & ~7;
+    size_t nBytes = nCapacity * (4 * sizeof(float) + sizeof(Descriptor) + sizeof(uint8_t)) + 64;
+    if(mBuffer.empty() || mBuffer.total() < nBytes)
+        mBuffer.create(1, (int)(nBytes + (mpPoolLink ? nBytes / 4 : 0)), CV_8U);
+    uchar* pBlock = (uchar*)(((uintptr_t)mBuffer.data + 63) & ~(uintptr_t)63);
+    mpfX = (float*)pBlock;
+    mpfY = mpfX + nCapacity;
+    mpfAngle = mpfY + nCapacity;
+    mpfResponse = mpfAngle + nCapacity;
+    mpDescriptors = (Descriptor*)(mpfResponse + nCapacity);
+    mpnOctave = (uint8_t*)(mpDescriptors + nCapacity);
+
+    // Copy each level, mapping each keypoint's coordinates to level 0 according to its level in the pyramid.
+    for(int iLevel = 0; iLevel < nLevels; ++iLevel) {
+        const vector<KeyPoint>& vKeyPoints = vvKeyPointsPerLevel[iLevel];
+        float fScaleFactor = mvfScaleFactors[iLevel];
+        int iOffset = mvnLevelOffsets[iLevel];
+        for(size_t i = 0; i < vKeyPoints.size(); ++i) {
+            const KeyPoint& keyPoint = vKeyPoints[i];
+            mpfX[iOffset + i] = keyPoint.pt.x * fScaleFactor;
+            mpfY[iOffset + i] = keyPoint.pt.y * fScaleFactor;
+            mpfAngle[iOffset + i] = keyPoint.angle;
+            mpfResponse[iOffset + i] = keyPoint.response;
+            mpnOctave[iOffset + i] = (uint8_t)iLevel;
+        }
+        if(!vKeyPoints.empty())
+            memcpy(mpDescriptors + iOffset, vvDescriptorsPerLevel[iLevel].data(), vKeyPoints.size() * sizeof(Descriptor));
+    }
+
+    // Assign the keypoints to the grid.
+    mfGridCellWidthInv = (float)FRAME_GRID_COLS / imageSize.width;
+    mfGridCellHeightInv = (float)FRAME_GRID_ROWS / imageSize.height;
+    assignToGrid();
+}
+
+/*
+@brief Drop a reference taken through a FramePtr. The last one returns the frame to its pool, or deletes it. */
+void Frame::releaseReference() {
+    if(mnReferences.fetch_sub(1, memory_order_acq_rel) != 1)
+        return;
+
+    if(mpPoolLink) {
+        // The pool cannot be destroyed while the link is locked. The local reference keeps the link,
+        // and so the mutex, alive if the pool deletes this frame instead of keeping it.
+        shared_ptr<FramePoolLink> pPoolLink = mpPoolLink;
+        lock_guard<mutex> lock(pPoolLink->mMutex);
+        if(pPoolLink->mpPool) {
+            pPoolLink->mpPool->recycle(this);
+            return;
+        }
+    }
+    delete this;
+}
+
+/*
+@brief Sort the keypoint indices by grid cell, counting the keypoints of each cell first and then placing them. */
+void Frame::assignToGrid() {
+    const int nCells = FRAME_GRID_COLS * FRAME_GRID_ROWS;
+    mvnGridOffsets.assign(nCells + 1, 0);
+    if(mpPoolLink && (int)mvnGridIndices.capacity() < mnKeyPoints)
+        mvnGridIndices.reserve(mnKeyPoints + mnKeyPoints / 4);
+    mvnGridIndices.resize(mnKeyPoints);
+
+    // Count into mvnGridOffsets[c + 1], then accumulate so that mvnGridOffsets[c] is where cell c starts.
+    for(int i = 0; i < mnKeyPoints; ++i)
+        ++mvnGridOffsets[getCell(i) + 1];
+    for(int iCell = 0; iCell < nCells; ++iCell)
+        mvnGridOffsets[iCell + 1] += mvnGridOffsets[iCell];
+
+    // Place the keypoints, moving each start forward; afterwards mvnGridOffsets[c] is where cell c + 1 starts.
+    // Recomputing the cells is cheaper than keeping them in a buffer that a recycled frame would have to carry.
+    for(int i = 0; i < mnKeyPoints; ++i)
+        mvnGridIndices[mvnGridOffsets[getCell(i)]++] = i;
+    for(int iCell = nCells; iCell > 0; --iCell)
+        mvnGridOffsets[iCell] = mvnGridOffsets[iCell - 1];
+    mvnGridOffsets[0] = 0;
+}
+
+/*
+@brief The grid cell of a keypoint. Coordinates mapped from the coarser levels may be slightly outside of the image,
+so the cells are clamped.
+
+@param[in] i: The index of the keypoint in the frame. */
+int Frame::getCell(int i) const {
+    int iCol = min(max((int)(mpfX[i] * mfGridCellWidthInv), 0), FRAME_GRID_COLS - 1);
+    int iRow = min(max((int)(mpfY[i] * mfGridCellHeightInv), 0), FRAME_GRID_ROWS - 1);
+    return iRow * FRAME_GRID_COLS + iCol;
+}
+
+/*
+@brief The keypoints and descriptors of one pyramid level.
+
+@param[in] iLevel: The pyramid level. */
+Frame::LevelView Frame::getLevel(int iLevel) const {
+    int iOffset = mvnLevelOffsets[iLevel];
+    LevelView level;
+    level.pfX = mpfX + iOffset;
+    level.pfY = mpfY + iOffset;
+    level.pfAngle = mpfAngle + iOffset;
+    level.pfResponse = mpfResponse + iOffset;
+    level.pDescriptors = mpDescriptors + iOffset;
+    level.nKeyPoints = mvnLevelOffsets[iLevel + 1] - iOffset;
+    level.iLevel = iLevel;
+    level.fScaleFactor = mvfScaleFactors[iLevel];
+    return level;
+}
+
+/*
+@brief Rebuild a keypoint from the arrays.
+
+@param[in] i: The index of the keypoint in the frame. */
+KeyPoint Frame::getKeyPoint(int i) const {
+    int iLevel = mpnOctave[i];
+    return KeyPoint(mpfX[i], mpfY[i], 7.f * mvfScaleFactors[iLevel], mpfAngle[i], mpfResponse[i], iLevel);
+}
+
+/*
+@brief Find the keypoints within a square window, using the grid.
+
+@param[in, out] vnIndices: The indices of the keypoints whose level-0 coordinates are less than fRadius away
+                           from (fX, fY) along both axes.
+@param[in] fX, fY: The center of the window, in level-0 pixels.
+@param[in] fRadius: The half size of the window.
+@param[in] nMinLevel, nMaxLevel: The range of levels to keep; a negative value leaves that side open. */
+void Frame::getFeaturesInArea(
+    vector<int>& vnIndices,
+    float fX, float fY, float fRadius,
+    int nMinLevel, int nMaxLevel
+) const {
+    vnIndices.clear();
+
+    // The cells overlapping the window, clamped like the keypoints were when they were assigned to the grid.
+    int iMinCol = min(max((int)floorf((fX - fRadius) * mfGridCellWidthInv), 0), FRAME_GRID_COLS - 1);
+    int iMaxCol = min(max((int)floorf((fX + fRadius) * mfGridCellWidthInv), 0), FRAME_GRID_COLS - 1);
+    int iMinRow = min(max((int)floorf((fY - fRadius) * mfGridCellHeightInv), 0), FRAME_GRID_ROWS - 1);
+    int iMaxRow = min(max((int)floorf((fY + fRadius) * mfGridCellHeightInv), 0), FRAME_GRID_ROWS - 1);
+
+    bool bCheckLevels = nMinLevel >= 0 || nMaxLevel >= 0;
+    if(nMinLevel < 0) { nMinLevel = 0; }
+    if(nMaxLevel < 0) { nMaxLevel = mvfScaleFactors.size() - 1; }
+
+    for(int iRow = iMinRow; iRow <= iMaxRow; ++iRow) {
+        // The cells of a row are adjacent in the index array.
+        int iBegin = mvnGridOffsets[iRow * FRAME_GRID_COLS + iMinCol];
+        int iEnd = mvnGridOffsets[iRow * FRAME_GRID_COLS + iMaxCol + 1];
+        for(int j = iBegin; j < iEnd; ++j) {
+            int i = mvnGridIndices[j];
+            if(bCheckLevels && (mpnOctave[i] < nMinLevel || mpnOctave[i] > nMaxLevel))
+                continue;
+            if(fabsf(mpfX[i] - fX) < fRadius && fabsf(mpfY[i] - fY) < fRadius)
+                vnIndices.push_back(i);
+        }
     }
 }
 
-} // my_ORB_SLAM2
\ No newline at end of file
+} // my_ORB_SLAM2
@@ -0,0 +1,123 @@
+#include "myORB-SLAM2/FramePool.h"
+
+#include <algorithm>
+
+namespace my_ORB_SLAM2 {
+
+/*
+@brief Frames whose storage is reused once they are no longer referenced.
+
+@param[in] nMaxResidentFrames: The maximum number of frames alive at the same time, in use or free. 0 means no limit. */
+FramePool::FramePool(int nMaxResidentFrames): mnMaxResidentFrames(max(nMaxResidentFrames, 0)), mpLink(make_shared<FramePoolLink>()) {
+    mpLink->mpPool = this;
+}
+
+FramePool::~FramePool() {
+    // Detach the frames still in use: from now on their last FramePtr deletes them.
+    // A frame being recycled holds the link's mutex, so it is in mvpFreeFrames once the lock is taken.
+    {
+        lock_guard<mutex> linkLock(mpLink->mMutex);
+        mpLink->mpPool = nullptr;
+    }
+
+    lock_guard<mutex> lock(mMutex);
+    for(Frame* pFrame : mvpFreeFrames)
+        delete pFrame;
+}
+
+/*
+@brief Take a free frame, or create one, and fill it as the constructor of Frame does.
+Returns an empty FramePtr when mnMaxResidentFrames frames are already in use.
+
+@param[in] imageSize: Size of the image at level 0, which the grid covers.
+@param[in] vfScaleFactors: Scale factor of each level used to map coordinates back to level 0.
+@param[in] vvKeyPointsPerLevel: Keypoints in the pyramid.
+@param[in] vvDescriptorsPerLevel: Descriptors in the pyramid. */
+FramePtr FramePool::acquire(
+    const Size& imageSize,
+    const vector<float>& vfScaleFactors,
+    const vector<vector<KeyPoint>>& vvKeyPointsPerLevel,
+    const vector<vector<Descriptor>>& vvDescriptorsPerLevel
+) {
+    Frame* pFrame = nullptr;
+    {
+        lock_guard<mutex> lock(mMutex);
+        if(!mvpFreeFrames.empty()) {
+            pFrame = mvpFreeFrames.back();
+            mvpFreeFrames.pop_back();
+        }
+        else if(mnMaxResidentFrames > 0 && mnResidentFrames >= mnMaxResidentFrames)
+            return FramePtr();
+        else
+            ++mnResidentFrames;
+    }
+
+    if(!pFrame)
+        pFrame = new Frame(mpLink);
+
+    // Filling the frame does not need the lock.
+    pFrame->assign(imageSize, vfScaleFactors, vvKeyPointsPerLevel, vvDescriptorsPerLevel);
+    return FramePtr(pFrame);
+}
+
+/*
+@brief Take back a frame whose last reference was dropped.
+
+@param[in] pFrame: The frame. */
+void FramePool::recycle(Frame* pFrame) {
+    {
+        lock_guard<mutex> lock(mMutex);
+        if(mnMaxResidentFrames == 0 || mnResidentFrames <= mnMaxResidentFrames) {
+            mvpFreeFrames.push_back(pFrame);
+            return;
+        }
+
+        // Over the limit after setMaxResidentFrames(): let this frame go.
+        --mnResidentFrames;
+    }
+    delete pFrame;
+}
+
+/*
+@brief Change the maximum number of resident frames. Free frames above the limit are deleted at once,
+frames in use when they are released.
+
+@param[in] nMaxResidentFrames: The maximum number of frames alive at the same time, 0 means no limit. */
+void FramePool::setMaxResidentFrames(int nMaxResidentFrames) {
+    lock_guard<mutex> lock(mMutex);
+    mnMaxResidentFrames = max(nMaxResidentFrames, 0);
+    if(mnMaxResidentFrames > 0)
+        deleteFreeFrames(mnMaxResidentFrames);
+}
+
+/*
+@brief Delete the free frames. */
+void FramePool::shrink() {
+    lock_guard<mutex> lock(mMutex);
+    deleteFreeFrames(0);
+}
+
+/*
+@brief Delete free frames until at most nResidentFrames frames are alive or no frame is free. Called under mMutex.
+
+@param[in] nResidentFrames: The number of resident frames to go down to. */
+void FramePool::deleteFreeFrames(int nResidentFrames) {
+    while(!mvpFreeFrames.empty() && mnResidentFrames > nResidentFrames) {
+        Frame* pFrame = mvpFreeFrames.back();
+        mvpFreeFrames.pop_back();
+        --mnResidentFrames;
+        delete pFrame;
+    }
+}
+
+int FramePool::getResidentFrames() {
+    lock_guard<mutex> lock(mMutex);
+    return mnResidentFrames;
+}
+
+int FramePool::getFreeFrames() {
+    lock_guard<mutex> lock(mMutex);
+    return mvpFreeFrames.size();
+}
+
+} // my_ORB_SLAM2
@@ -0,0 +1,255 @@
+#include "myORB-SLAM2/GaussianFilter.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace my_ORB_SLAM2 {
+
+// The ring keeps the 8 most recent rows: 7 for the kernel plus the one being pushed.
+static const int RING_ROWS = 8;
+
+/*
+@brief Reflect-101 border: pixel -i maps to pixel i, and pixel n-1+i maps to pixel n-1-i.
+
+@param[in] i: The index of the pixel.
+@param[in] n: The number of pixels. */
+static inline int reflect(int i, int n) {
+    return i < 0 ? -i : (i >= n ? 2 * n - 2 - i : i);
+}
+
+/*
+@brief Horizontal pass over a padded row. The weights sum to 256, so a filtered pixel fits in 16 bits without rounding.
+The kernel is symmetric, so pixels at the same distance are added before the multiplication.
+
+@param[in] pPadded: The row with 3 reflected pixels on both sides, pointing at its first pixel.
+@param[in, out] pDst: The filtered row.
+@param[in] nCols: The number of pixels in the row.
+@param[in] pKernel: The kernel weights (center, 1, 2, 3 pixels away). */
+static void filterHorizontal(const uchar* pPadded, ushort* pDst, int nCols, const int* pKernel) {
+    const int k0 = pKernel[0], k1 = pKernel[1], k2 = pKernel[2], k3 = pKernel[3];
+    int iX = 0;
+
+#ifdef __SSE2__
+    // 16 pixels per iteration in 16-bit lanes: pairs are at most 510 and every sum stays below 65536.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w0 = _mm_set1_epi16((short)k0), w1 = _mm_set1_epi16((short)k1);
+    const __m128i w2 = _mm_set1_epi16((short)k2), w3 = _mm_set1_epi16((short)k3);
+    for(; iX + 16 <= nCols; iX += 16) {
+        const uchar* p = pPadded + iX;
+        __m128i v[7];
+        for(int i = 0; i < 7; ++i)
+            v[i] = _mm_loadu_si128((const __m128i*)(p + i - 3));
+
+        for(int iHalf = 0; iHalf < 2; ++iHalf) {
+            __m128i u[7];
+            for(int i = 0; i < 7; ++i)
+                u[i] = iHalf == 0 ? _mm_unpacklo_epi8(v[i], zero) : _mm_unpackhi_epi8(v[i], zero);
+
+            __m128i sum = _mm_mullo_epi16(u[3], w0);
+            sum = _mm_add_epi16(sum, _mm_mullo_epi16(_mm_add_epi16(u[2], u[4]), w1));
+            sum = _mm_add_epi16(sum, _mm_mullo_epi16(_mm_add_epi16(u[1], u[5]), w2));
+            sum = _mm_add_epi16(sum, _mm_mullo_epi16(_mm_add_epi16(u[0], u[6]), w3));
+            _mm_storeu_si128((__m128i*)(pDst + iX + 8 * iHalf), sum);
+        }
+    }
+#endif
+
+    for(; iX < nCols; ++iX) {
+        const uchar* p = pPadded + iX;
+        pDst[iX] = (ushort)(k0 * p[0] + k1 * (p[-1] + p[1]) + k2 * (p[-2] + p[2]) + k3 * (p[-3] + p[3]));
+    }
+}
+
+/*
+@brief Vertical pass over 7 horizontally filtered rows, then the 16 fractional bits are rounded away.
+
+@param[in] pRows: The 7 rows from 3 rows above to 3 rows below the written row.
+@param[in, out] pDst: The blurred row.
+@param[in] nCols: The number of pixels in the row.
+@param[in] pKernel: The kernel weights (center, 1, 2, 3 pixels away). */
+static void filterVerticalRow(const ushort* const* pRows, uchar* pDst, int nCols, const int* pKernel) {
+    const int k0 = pKernel[0], k1 = pKernel[1], k2 = pKernel[2], k3 = pKernel[3];
+    int iX = 0;
+
+#ifdef __SSE2__
+    // 8 pixels per iteration with multiply-add of pairs of rows. Rows are biased by -32768 so that
+    // they fit in signed 16 bits, which removes 256 * 32768 from the sum; it is added back before rounding.
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    const __m128i w0 = _mm_set1_epi32(k0), w1 = _mm_set1_epi32(k1 | (k1 << 16));
+    const __m128i w2 = _mm_set1_epi32(k2 | (k2 << 16)), w3 = _mm_set1_epi32(k3 | (k3 << 16));
+    const __m128i offset = _mm_set1_epi32(256 * 32768 + (1 << 15));
+    for(; iX + 8 <= nCols; iX += 8) {
+        __m128i v[7];
+        for(int i = 0; i < 7; ++i)
+            v[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(pRows[i] + iX)), bias);
+
+        // The center row is paired with itself and a zero weight.
+        __m128i sumLo = _mm_add_epi32(offset, _mm_madd_epi16(_mm_unpacklo_epi16(v[3], v[3]), w0));
+        __m128i sumHi = _mm_add_epi32(offset, _mm_madd_epi16(_mm_unpackhi_epi16(v[3], v[3]), w0));
+        sumLo = _mm_add_epi32(sumLo, _mm_madd_epi16(_mm_unpacklo_epi16(v[2], v[4]), w1));
+        sumHi = _mm_add_epi32(sumHi, _mm_madd_epi16(_mm_unpackhi_epi16(v[2], v[4]), w1));
+        sumLo = _mm_add_epi32(sumLo, _mm_madd_epi16(_mm_unpacklo_epi16(v[1], v[5]), w2));
+        sumHi = _mm_add_epi32(sumHi, _mm_madd_epi16(_mm_unpackhi_epi16(v[1], v[5]), w2));
+        sumLo = _mm_add_epi32(sumLo, _mm_madd_epi16(_mm_unpacklo_epi16(v[0], v[6]), w3));
+        sumHi = _mm_add_epi32(sumHi, _mm_madd_epi16(_mm_unpackhi_epi16(v[0], v[6]), w3));
+
+        __m128i result = _mm_packs_epi32(_mm_srli_epi32(sumLo, 16), _mm_srli_epi32(sumHi, 16));
+        _mm_storel_epi64((__m128i*)(pDst + iX), _mm_packus_epi16(result, result));
+    }
+#endif
+
+    for(; iX < nCols; ++iX) {
+        unsigned int sum = k0 * pRows[3][iX] +
+                           k1 * (pRows[2][iX] + pRows[4][iX]) +
+                           k2 * (pRows[1][iX] + pRows[5][iX]) +
+                           k3 * (pRows[0][iX] + pRows[6][iX]);
+        pDst[iX] = (uchar)((sum + (1 << 15)) >> 16);
+    }
+}
+
+/*
+@brief Blur a whole image.
+
+@param[in] image: The 8-bit image to be blurred.
+@param[in, out] blurredImage: The blurred image, reallocated only when its size changes. */
+void GaussianFilter::apply(const Mat& image, Mat& blurredImage) {
+    if(meImplementation == OPENCV) {
+        // Reflect at the borders of the image itself, even when it is a view into a larger buffer (e.g. the pyramid atlas).
+        blurredImage.create(image.rows, image.cols, CV_8U);
+        GaussianBlur(image, blurredImage, Size(7, 7), 2, 2, BORDER_REFLECT_101 | BORDER_ISOLATED);
+        return;
+    }
+
+    begin(image.size(), blurredImage);
+    for(int iY = 0; iY < image.rows; ++iY)
+        pushRow(image.ptr<uchar>(iY));
+    end();
+}
+
+/*
+@brief Start blurring an image that will be pushed row by row.
+
+@param[in] size: The size of the image.
+@param[in, out] blurredImage: The blurred image, reallocated only when its size changes. */
+void GaussianFilter::begin(Size size, Mat& blurredImage) {
+    mnRows = size.height;
+    mnCols = size.width;
+    mnPushedRows = 0;
+    mnWrittenRows = 0;
+
+    mpBlurredImage = &blurredImage;
+    blurredImage.create(mnRows, mnCols, CV_8U);
+
+    // GaussianBlur needs the whole image, so the rows are collected until end().
+    if(meImplementation == OPENCV) {
+        if(mSourceBuffer.rows < mnRows || mSourceBuffer.cols < mnCols)
+            mSourceBuffer.create(max(mSourceBuffer.rows, mnRows), max(mSourceBuffer.cols, mnCols), CV_8U);
+        mSourceImage = mSourceBuffer(Rect(0, 0, mnCols, mnRows));
+        return;
+    }
+
+    // The ring and the padded row are shared by every image size, so they only grow.
+    if(mRingBuffer.cols < mnCols) { mRingBuffer.create(RING_ROWS, mnCols, CV_16U); }
+    if((int)mvPaddedRow.size() < mnCols + 6) { mvPaddedRow.resize(mnCols + 6); }
+}
+
+/*
+@brief Push the next row of the image, top to bottom.
+
+@param[in] pRow: The pixels of the row. */
+void GaussianFilter::pushRow(const uchar* pRow) {
+    if(meImplementation == OPENCV) {
+        memcpy(mSourceImage.ptr<uchar>(mnPushedRows++), pRow, mnCols);
+        return;
+    }
+
+    // Pad the row with reflected pixels, so that the horizontal pass has no border case.
+    uchar* pPadded = mvPaddedRow.data() + 3;
+    memcpy(pPadded, pRow, mnCols);
+    for(int i = 1; i <= 3; ++i) {
+        pPadded[-i] = pRow[reflect(-i, mnCols)];
+        pPadded[mnCols - 1 + i] = pRow[reflect(mnCols - 1 + i, mnCols)];
+    }
+    filterHorizontal(pPadded, mRingBuffer.ptr<ushort>(mnPushedRows % RING_ROWS), mnCols, mGaussianKernel);
+    ++mnPushedRows;
+
+    // A row can be blurred once the 3 rows below it are filtered (rows above it are still in the ring).
+    while(mnWrittenRows + 3 < mnPushedRows)
+        filterVertical(mnWrittenRows++);
+}
+
+/*
+@brief Write the last blurred rows once every row has been pushed. */
+void GaussianFilter::end() {
+    if(meImplementation == OPENCV) {
+        GaussianBlur(mSourceImage, *mpBlurredImage, Size(7, 7), 2, 2, BORDER_REFLECT_101 | BORDER_ISOLATED);
+        mnWrittenRows = mnRows;
+        mpBlurredImage = nullptr;
+        return;
+    }
+
+    // The rows below the last one are reflected, so every remaining row can be written now.
+    while(mnWrittenRows < mnRows)
+        filterVertical(mnWrittenRows++);
+    mpBlurredImage = nullptr;
+}
+
+/*
+@brief Blur only a region of an image, as apply would blur it: pixels outside the region are read
+(or reflected at the image border) but not written.
+
+@param[in] image: The 8-bit image to be blurred.
+@param[in, out] blurredImage: The blurred image, with the same size as image.
+@param[in] roi: The region to be blurred, inside the image. */
+void GaussianFilter::applyRegion(const Mat& image, Mat& blurredImage, const Rect& roi) {
+    int nRows = image.rows, nCols = image.cols;
+
+    // Blur the region with a margin of 3 pixels, so that only pixels of the margin see the reflection at its edges.
+    // Where the margin is cut by the image, the reflection is the image's own, as in apply.
+    if(meImplementation == OPENCV) {
+        Rect outer = Rect(roi.x - 3, roi.y - 3, roi.width + 6, roi.height + 6) & Rect(0, 0, nCols, nRows);
+        GaussianBlur(image(outer), mRegionBuffer, Size(7, 7), 2, 2, BORDER_REFLECT_101 | BORDER_ISOLATED);
+        Mat region = blurredImage(roi);
+        mRegionBuffer(Rect(roi.x - outer.x, roi.y - outer.y, roi.width, roi.height)).copyTo(region);
+        return;
+    }
+
+    if(mRingBuffer.cols < roi.width) { mRingBuffer.create(RING_ROWS, roi.width, CV_16U); }
+    if((int)mvPaddedRow.size() < roi.width + 6) { mvPaddedRow.resize(roi.width + 6); }
+
+    // Rows from 3 above to 3 below the region go through the ring; the i-th of them is stored in slot i % RING_ROWS.
+    uchar* pPadded = mvPaddedRow.data() + 3;
+    for(int i = 0; i < roi.height + 6; ++i) {
+        const uchar* pRow = image.ptr<uchar>(reflect(roi.y - 3 + i, nRows));
+
+        // The 3 pixels on both sides of the region are read from the image, or reflected at its border.
+        memcpy(pPadded, pRow + roi.x, roi.width);
+        for(int j = 1; j <= 3; ++j) {
+            pPadded[-j] = pRow[reflect(roi.x - j, nCols)];
+            pPadded[roi.width - 1 + j] = pRow[reflect(roi.x + roi.width - 1 + j, nCols)];
+        }
+        filterHorizontal(pPadded, mRingBuffer.ptr<ushort>(i % RING_ROWS), roi.width, mGaussianKernel);
+
+        // Once the rows 3 below it are filtered, a row of the region can be written.
+        if(i >= 6) {
+            const ushort* pRows[7];
+            for(int j = 0; j < 7; ++j)
+                pRows[j] = mRingBuffer.ptr<ushort>((i - 6 + j) % RING_ROWS);
+            filterVerticalRow(pRows, blurredImage.ptr<uchar>(roi.y + i - 6) + roi.x, roi.width, mGaussianKernel);
+        }
+    }
+}
+
+/*
+@brief Write one blurred row from the horizontally filtered rows in the ring.
+
+@param[in] iY: The row to be written. */
+void GaussianFilter::filterVertical(int iY) {
+    const ushort* pRows[7];
+    for(int i = -3; i <= 3; ++i)
+        pRows[i + 3] = mRingBuffer.ptr<ushort>(reflect(iY + i, mnRows) % RING_ROWS);
+    filterVerticalRow(pRows, mpBlurredImage->ptr<uchar>(iY), mnCols, mGaussianKernel);
+}
+
+} // my_ORB_SLAM2
@@ -1,15 +1,32 @@
 #include "myORB-SLAM2/ImagePyramid.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace my_ORB_SLAM2 {
+    // atlas 中每一層影像第一個 pixel 與每一列的對齊單位 (bytes)
+    static const int ATLAS_ALIGNMENT = 64;
+
+    /*
+    @brief 向上對齊到 ATLAS_ALIGNMENT 的倍數
+    
+    @param[in] n 要對齊的數值 */
+    static inline int alignUp(int n) {
+        return (n + ATLAS_ALIGNMENT - 1) / ATLAS_ALIGNMENT * ATLAS_ALIGNMENT;
+    }
+
     /*
     @brief 影像金字塔
     
     @param[in] nLevels 影像金字塔的層數
     @param[in] fScaleFactor 每層之間的縮放因子 (例如 1.2) 
-    @param[in] nFeatures 總共需要提取的特徵點數量 */
-    ImagePyramid::ImagePyramid(int nLevels, float fScaleFactor, int nFeatures) {
+    @param[in] nFeatures 總共需要提取的特徵點數量
+    @param[in] nBorder 每一層影像四周邊界的寬度 */
+    ImagePyramid::ImagePyramid(int nLevels, float fScaleFactor, int nFeatures, int nBorder) {
         // 初始化影像金字塔基礎參數
         mnLevels = nLevels;
+        mnBorder = max(nBorder, 0);
         mnFeatures = nFeatures;
         mfScaleFactor = fScaleFactor;
 
@@ -18,6 +35,13 @@ namespace my_ORB_SLAM2 {
         mvfScaleFactors.resize(mnLevels);
         mvfInvScaleFactors.resize(mnLevels);
         mvImages.resize(mnLevels);
+        mvBlurredImages.resize(mnLevels);
+        mvvnXOffsets.resize(mnLevels);
+        mvnSourceCols.assign(mnLevels, 0);
+        mvLevelRects.resize(mnLevels);
+        mvXKernels.resize(mnLevels);
+        mvYKernels.resize(mnLevels);
+        mvnAvailableRows.assign(mnLevels, 0);
 
         // 初始化影像金字塔中，每一層的縮小倍數與反向縮放倍數
         mvfScaleFactors[0] = 1.0f;
@@ -28,17 +52,82 @@ namespace my_ORB_SLAM2 {
         }
 
         // 計算影像金字塔中每一層應提取的特徵點數量 (根據公式)
+        computeFeaturesPerLevel(vector<float>());
+
+        info(); // 輸出影像金字塔相關資訊
+    }
+
+    /*
+    @brief 計算每一層影像應提取的特徵點數量
+    
+    @param[in] vfUsableRatios 每一層影像可以使用的面積比例，空的 vector 代表沒有遮罩 */
+    void ImagePyramid::computeFeaturesPerLevel(const vector<float> &vfUsableRatios) {
         int sumFeatures = 0;
         float factor = 1.0f / mfScaleFactor;
         float nDesiredFeaturesPerScale = (mnFeatures*(1-factor)) / (1-(float)pow((double)factor, (double)mnLevels));
-        for(int level = 0; level < mnLevels-1; level++) {
-            mvnFeaturesPerLevel[level] = cvRound(nDesiredFeaturesPerScale);
+        int iLastLevel = mnLevels-1;
+
+        // 有遮罩時，等比數列的權重總和改為每一層的權重乘上可以使用的面積比例後再加總
+        // 完全被遮住的層級不分配特徵點，剩下的數量交給最後一個可以使用的層級
+        if(!vfUsableRatios.empty()) {
+            float fWeightSum = 0.0f, fWeight = 1.0f;
+            for(int level = 0; level < mnLevels; level++) {
+                fWeightSum += fWeight * vfUsableRatios[level];
+                fWeight *= factor;
+            }
+            nDesiredFeaturesPerScale = fWeightSum > 0.0f ? mnFeatures / fWeightSum : 0.0f;
+            while(iLastLevel > 0 && vfUsableRatios[iLastLevel] == 0.0f) { iLastLevel--; }
+        }
+
+        for(int level = 0; level < mnLevels; level++) {
+            float fUsableRatio = vfUsableRatios.empty() ? 1.0f : vfUsableRatios[level];
+            mvnFeaturesPerLevel[level] = level < iLastLevel ? cvRound(nDesiredFeaturesPerScale * fUsableRatio) : 0;
             sumFeatures += mvnFeaturesPerLevel[level];
-            nDesiredFeaturesPerScale *= factor; 
+            nDesiredFeaturesPerScale *= factor;
         }
-        mvnFeaturesPerLevel[mnLevels-1] = max(mnFeatures-sumFeatures, 0);
+        if(vfUsableRatios.empty() || vfUsableRatios[iLastLevel] > 0.0f)
+            mvnFeaturesPerLevel[iLastLevel] = max(mnFeatures-sumFeatures, 0);
+    }
 
-        info(); // 輸出影像金字塔相關資訊
+    /*
+    @brief 設定相機的靜態遮罩，建立每一層影像的遮罩並重新分配每一層應提取的特徵點數量
+    
+    @param[in] mask 與第 0 層影像同大小的 8-bit 遮罩，非 0 代表可以使用；空的 Mat 代表不使用遮罩 */
+    void ImagePyramid::setMask(const Mat &mask) {
+        if(mask.empty()) {
+            mvMasks.clear();
+            computeFeaturesPerLevel(vector<float>());
+            return;
+        }
+
+        // 已經設定過影像時，遮罩必須與影像同大小；還沒有影像時，之後大小不同的層級不會使用遮罩
+        CV_Assert(mask.type() == CV_8U);
+        CV_Assert(mAtlas.empty() || mask.size() == mAtlasImageSize);
+
+        // 每一層影像的大小與 atlas 中的影像相同，遮罩只在設定時建立一次，不放進 atlas
+        vector<float> vfUsableRatios(mnLevels);
+        mvMasks.resize(mnLevels);
+        for(int level = 0; level < mnLevels; ++level) {
+            float scale = mvfInvScaleFactors[level];
+            Size levelSize(cvRound(mask.cols*scale), cvRound(mask.rows*scale));
+            Mat &levelMask = mvMasks[level];
+            levelMask.create(levelSize, CV_8U);
+
+            // 該層的 pixel 對應回第 0 層的位置，與關鍵點座標乘上 mvfScaleFactors 還原到第 0 層的方式相同
+            float fScale = mvfScaleFactors[level];
+            long nUsable = 0;
+            for(int iY = 0; iY < levelSize.height; iY++) {
+                const uchar* pSrc = mask.ptr<uchar>(min((int)(iY * fScale), mask.rows - 1));
+                uchar* pDst = levelMask.ptr<uchar>(iY);
+                for(int iX = 0; iX < levelSize.width; iX++) {
+                    pDst[iX] = pSrc[min((int)(iX * fScale), mask.cols - 1)] ? 255 : 0;
+                    nUsable += (pDst[iX] != 0);
+                }
+            }
+            vfUsableRatios[level] = levelSize.area() > 0 ? (float)nUsable / levelSize.area() : 0.0f;
+        }
+
+        computeFeaturesPerLevel(vfUsableRatios);
     }
 
     /*
@@ -46,11 +135,493 @@ namespace my_ORB_SLAM2 {
     
     @param[in] image 影像金字塔的影像*/
     void ImagePyramid::setImage(const Mat &image) {
-        mvImages[0] = image;
-        for (int level = 1; level < mnLevels; ++level) {
+        beginImage(image);
+        for (int level = 0; level < mnLevels; ++level)
+            buildLevel(level);
+    }
+
+    /*
+    @brief 設定縮小影像的方式
+    
+    @param[in] eInterpolation 縮小影像的方式 */
+    void ImagePyramid::setInterpolation(Interpolation eInterpolation) {
+        meInterpolation = eInterpolation;
+    }
+
+    /*
+    @brief 分層建立影像金字塔的第一步：規劃 atlas 並把每一層影像標記為尚未完成
+    
+    @param[in] image 影像金字塔的影像，所有層級完成前都必須保持有效
+    @param[in] nThreads 會呼叫 buildLevel 的執行緒數量 */
+    void ImagePyramid::beginImage(const Mat &image, int nThreads) {
+        mpSourceImage = &image;
+
+        // 影像大小改變時才重新規劃 atlas
+        allocateAtlas(image.size());
+
+        // 每個執行緒各自的高斯濾波器與暫存列，執行緒數量增加時才配置
+        nThreads = max(nThreads, 1);
+        if((int)mvGaussianFilters.size() < nThreads) { mvGaussianFilters.resize(nThreads); }
+        if((int)mvvnRowBuffers.size() < nThreads) { mvvnRowBuffers.resize(nThreads); }
+        setFilterImplementation();
+
+        mvnAvailableRows.assign(mnLevels, 0);
+        mnReadyLevels.store(0, memory_order_release);
+    }
+
+    /*
+    @brief 開始以列為單位接收影像，之後以 pushRows 依序傳入第 0 層影像的每一列
+    
+    @param[in] size 第 0 層影像的大小 */
+    void ImagePyramid::beginStream(Size size) {
+        allocateAtlas(size);
+
+        // 每一層影像交錯建立，所以每一層各自使用一個高斯濾波器，第 i 層使用 mvGaussianFilters[i]
+        if((int)mvGaussianFilters.size() < mnLevels) { mvGaussianFilters.resize(mnLevels); }
+        if(mvvnRowBuffers.empty()) { mvvnRowBuffers.resize(1); }
+        setFilterImplementation();
+        if(mbBlurredPyramid) {
+            for(int level = 0; level < mnLevels; ++level)
+                mvGaussianFilters[level].begin(mvImages[level].size(), mvBlurredImages[level]);
+        }
+
+        // 面積平均直接讀取 atlas 中的第 0 層影像，先算好垂直方向的取樣方式，才知道每一列需要第 0 層影像的哪些列
+        mpSourceImage = &mvImages[0];
+        if(meInterpolation == AREA) {
+            for(int level = 1; level < mnLevels; ++level) {
+                computeAreaKernel(mvXKernels[level], size.width, mvImages[level].cols, 256, 8);
+                computeAreaKernel(mvYKernels[level], size.height, mvImages[level].rows, 128, 1);
+            }
+        }
+
+        mvnAvailableRows.assign(mnLevels, 0);
+        mnReadyLevels.store(0, memory_order_release);
+    }
+
+    /*
+    @brief 傳入第 0 層影像接下來的數列，並建立每一層影像中已經可以建立的列
+    
+    @param[in] rows 接下來的數列，寬度與影像相同，超過影像高度的列會被忽略 */
+    void ImagePyramid::pushRows(const Mat &rows) {
+        // 第 0 層影像直接複製到 atlas 中
+        Mat &level0 = mvImages[0];
+        int iRowBegin = mvnAvailableRows[0], iRowEnd = min(iRowBegin + rows.rows, level0.rows);
+        for(int iY = iRowBegin; iY < iRowEnd; iY++) {
+            memcpy(level0.ptr<uchar>(iY), rows.ptr<uchar>(iY - iRowBegin), level0.cols);
+            if(mbBlurredPyramid) { mvGaussianFilters[0].pushRow(level0.ptr<uchar>(iY)); }
+        }
+        finishStreamRows(0, iRowBegin, iRowEnd);
+
+        // 由低到高建立每一層影像中來源影像已經足夠的列，NEAREST 的來源是上一層影像，所以同一次傳入就可以一路往上建立
+        for(int level = 1; level < mnLevels; ++level) {
+            int iSourceLevel = meInterpolation == AREA ? 0 : level - 1;
+            int nSourceRows = mvnAvailableRows[iSourceLevel];
+            iRowBegin = mvnAvailableRows[level];
+            iRowEnd = iRowBegin;
+            while(iRowEnd < mvImages[level].rows && getSourceRowEnd(level, iRowEnd + 1) <= nSourceRows) { iRowEnd++; }
+            if(iRowEnd == iRowBegin) { continue; }
+
+            GaussianFilter *pGaussianFilter = mbBlurredPyramid ? &mvGaussianFilters[level] : nullptr;
+            if(meInterpolation == AREA)
+                resizeArea(level, 0, iRowBegin, iRowEnd, pGaussianFilter);
+            else
+                resizeNearest(mvImages[level - 1], level, iRowBegin, iRowEnd, pGaussianFilter);
+            finishStreamRows(level, iRowBegin, iRowEnd);
+        }
+    }
+
+    /*
+    @brief 建立一層影像的前 iRowEnd 列需要的來源影像列數
+    
+    @param[in] iLevel 影像金字塔的層級 (大於 0)
+    @param[in] iRowEnd 該層影像的列數 */
+    int ImagePyramid::getSourceRowEnd(int iLevel, int iRowEnd) const {
+        if(iRowEnd <= 0) { return 0; }
+        if(meInterpolation == AREA) {
+            const AreaKernel &yKernel = mvYKernels[iLevel];
+            return yKernel.vnStarts[iRowEnd - 1] + yKernel.nTaps;
+        }
+
+        // 與 resizeNearest 的取樣位置相同
+        int nSourceRows = mvImages[iLevel - 1].rows;
+        double dInvScaleY = 1.0 / ((double)mvImages[iLevel].rows / nSourceRows);
+        return min(cvFloor((iRowEnd - 1) * dInvScaleY), nSourceRows - 1) + 1;
+    }
+
+    /*
+    @brief 逐列接收影像時，一層影像新建立了 [iRowBegin, iRowEnd) 列
+    
+    @param[in] iLevel 影像金字塔的層級
+    @param[in] iRowBegin, iRowEnd 新建立的列 */
+    void ImagePyramid::finishStreamRows(int iLevel, int iRowBegin, int iRowEnd) {
+        if(iRowEnd == iRowBegin) { return; }
+        Mat &image = mvImages[iLevel];
+        replicateBorder(image, iRowBegin, iRowEnd);
+        mvnAvailableRows[iLevel] = iRowEnd;
+        if(iRowEnd < image.rows) { return; }
+
+        // 模糊影像最後 3 列要等到最後一列傳入後才能寫入，所以整層完成時才填入模糊影像的邊界
+        if(mbBlurredPyramid) {
+            mvGaussianFilters[iLevel].end();
+            replicateBorder(mvBlurredImages[iLevel], 0, image.rows);
+        }
+        markLevelReady(iLevel);
+    }
+
+    /*
+    @brief 建立一層影像 (以及模糊影像與邊界)，完成後通知等待該層影像的執行緒
+    
+    @param[in] iLevel 影像金字塔的層級
+    @param[in] iThread 執行緒的編號 */
+    void ImagePyramid::buildLevel(int iLevel, int iThread) {
+        Mat &dst = mvImages[iLevel];
+
+        // 啟用模糊影像金字塔時，每一列寫入 atlas 後還在快取中就交給該執行緒的高斯濾波器
+        GaussianFilter *pGaussianFilter = mbBlurredPyramid ? &mvGaussianFilters[iThread] : nullptr;
+        if(pGaussianFilter) { pGaussianFilter->begin(dst.size(), mvBlurredImages[iLevel]); }
+
+        if(iLevel == 0) {
+            // 第 0 層影像複製到 atlas 中
+            const Mat &image = *mpSourceImage;
+            for(int iY = 0; iY < image.rows; iY++) {
+                memcpy(dst.ptr<uchar>(iY), image.ptr<uchar>(iY), image.cols);
+                if(pGaussianFilter) { pGaussianFilter->pushRow(dst.ptr<uchar>(iY)); }
+            }
+        } else if(meInterpolation == AREA) {
+            resizeArea(iLevel, iThread, 0, dst.rows, pGaussianFilter);
+        } else {
+            // 最近鄰插值由上一層影像縮小，只會讀取上一層影像的內部，上一層影像的邊界可以同時填入
+            waitLevel(iLevel - 1);
+            resizeNearest(mvImages[iLevel - 1], iLevel, 0, dst.rows, pGaussianFilter);
+        }
+
+        if(pGaussianFilter) { pGaussianFilter->end(); }
+
+        replicateBorder(dst, 0, dst.rows);
+        if(mbBlurredPyramid) { replicateBorder(mvBlurredImages[iLevel], 0, dst.rows); }
+
+        mvnAvailableRows[iLevel] = dst.rows;
+        markLevelReady(iLevel);
+    }
+
+    /*
+    @brief 等待一層影像完成
+    
+    @param[in] iLevel 影像金字塔的層級 */
+    void ImagePyramid::waitLevel(int iLevel) {
+        if(isLevelReady(iLevel)) { return; }
+        unique_lock<mutex> lock(mReadyMutex);
+        mcvLevelReady.wait(lock, [&]() { return isLevelReady(iLevel); });
+    }
+
+    /*
+    @brief 標記一層影像已經完成，並喚醒等待的執行緒
+    
+    @param[in] iLevel 影像金字塔的層級 */
+    void ImagePyramid::markLevelReady(int iLevel) {
+        // 在鎖內更新，等待的執行緒檢查完條件、還沒開始等待之前不會錯過通知
+        {
+            lock_guard<mutex> lock(mReadyMutex);
+            mnReadyLevels.fetch_or((uint64_t)1 << iLevel, memory_order_release);
+        }
+        mcvLevelReady.notify_all();
+    }
+
+    /*
+    @brief 依第 0 層影像的大小規劃 atlas，影像大小不變時沿用上一次的 atlas
+    
+    @param[in] size 第 0 層影像的大小 */
+    void ImagePyramid::allocateAtlas(Size size) {
+        if(!mAtlas.empty() && size == mAtlasImageSize && mbAtlasBlurred == mbBlurredPyramid) { return; }
+        mAtlasImageSize = size;
+        mbAtlasBlurred = mbBlurredPyramid;
+
+        // atlas 的寬度以第 0 層影像 (含邊界) 為準，每一列的第一層影像從 iFirstX 開始
+        int iFirstX = alignUp(mnBorder);
+        int nAtlasCols = alignUp(iFirstX + size.width + mnBorder);
+
+        // 由左到右放入每一層影像，放不下時換到下一列，每一列的高度是該列中最高的影像 (含邊界)
+        int iNextX = 0, iRowY = 0, nRowHeight = 0;
+        for(int level = 0; level < mnLevels; ++level) {
             float scale = mvfInvScaleFactors[level];
-            Size size(cvRound(image.cols*scale), cvRound(image.rows*scale));
-            resize(mvImages[level-1], mvImages[level], size, 0, 0, INTER_NEAREST);
+            Size levelSize(cvRound(size.width*scale), cvRound(size.height*scale));
+
+            int iX = alignUp(iNextX + mnBorder);
+            if(iNextX > 0 && iX + levelSize.width + mnBorder > nAtlasCols) {
+                iRowY += nRowHeight;
+                nRowHeight = 0;
+                iX = iFirstX;
+            }
+            mvLevelRects[level] = Rect(iX, iRowY + mnBorder, levelSize.width, levelSize.height);
+            iNextX = iX + levelSize.width + mnBorder;
+            nRowHeight = max(nRowHeight, levelSize.height + 2 * mnBorder);
+        }
+        mnAtlasRows = iRowY + nRowHeight;
+
+        // 只配置一次記憶體，模糊影像金字塔放在原始影像的下方，每一層影像都是指向 atlas 的 header
+        mAtlas.create(mbBlurredPyramid ? 2 * mnAtlasRows : mnAtlasRows, nAtlasCols, CV_8U);
+        for(int level = 0; level < mnLevels; ++level) {
+            const Rect &rect = mvLevelRects[level];
+            mvImages[level] = mAtlas(rect);
+            if(mbBlurredPyramid)
+                mvBlurredImages[level] = mAtlas(Rect(rect.x, rect.y + mnAtlasRows, rect.width, rect.height));
+            else
+                mvBlurredImages[level].release();
+        }
+    }
+
+    /*
+    @brief 把影像最外圈的 pixel 複製到四周 mnBorder 寬的邊界中 (與 BORDER_REPLICATE 相同)
+    
+    @param[in, out] image 指向 atlas 的影像 header，四周必須各有 mnBorder 的空間
+    @param[in] iRowBegin, iRowEnd 要處理的列 */
+    void ImagePyramid::replicateBorder(Mat &image, int iRowBegin, int iRowEnd) {
+        if(mnBorder == 0 || image.empty()) { return; }
+        int nCols = image.cols, nRows = image.rows;
+        size_t nStep = image.step;
+
+        // 左右邊界：每一列複製第一個與最後一個 pixel
+        for(int iY = iRowBegin; iY < iRowEnd; iY++) {
+            uchar* pRow = image.ptr<uchar>(iY);
+            memset(pRow - mnBorder, pRow[0], mnBorder);
+            memset(pRow + nCols, pRow[nCols - 1], mnBorder);
+        }
+
+        // 上下邊界：複製含左右邊界的第一列與最後一列，四個角落也一起填入
+        const uchar* pFirstRow = image.ptr<uchar>(0) - mnBorder;
+        const uchar* pLastRow = image.ptr<uchar>(nRows - 1) - mnBorder;
+        for(int i = 1; i <= mnBorder; i++) {
+            if(iRowBegin == 0) { memcpy((uchar*)pFirstRow - i * nStep, pFirstRow, nCols + 2 * mnBorder); }
+            if(iRowEnd == nRows) { memcpy((uchar*)pLastRow + i * nStep, pLastRow, nCols + 2 * mnBorder); }
+        }
+    }
+
+    /*
+    @brief 設定是否同時建立模糊影像金字塔
+    
+    @param[in] bEnable 是否建立模糊影像金字塔 */
+    void ImagePyramid::enableBlurredPyramid(bool bEnable) {
+        mbBlurredPyramid = bEnable;
+    }
+
+    /*
+    @brief 設定模糊影像金字塔是否使用 8-bit 定點數的高斯模糊
+    
+    @param[in] bEnable 是否使用定點數的高斯模糊 */
+    void ImagePyramid::setFixedPointBlur(bool bEnable) {
+        mbFixedPointBlur = bEnable;
+    }
+
+    /*
+    @brief 讓每個高斯濾波器使用目前設定的實作，濾波器數量增加後呼叫 */
+    void ImagePyramid::setFilterImplementation() {
+        for(GaussianFilter &gaussianFilter : mvGaussianFilters)
+            gaussianFilter.meImplementation = mbFixedPointBlur ? GaussianFilter::FIXED_POINT : GaussianFilter::OPENCV;
+    }
+
+    /*
+    @brief 以最近鄰插值把上一層影像縮小為該層影像，取樣位置與 cv::resize 的 INTER_NEAREST 相同
+    
+    @param[in] src 上一層影像
+    @param[in] iLevel 影像金字塔的層級
+    @param[in] iRowBegin, iRowEnd 要建立的列
+    @param[in] pGaussianFilter 逐列模糊該層影像的高斯濾波器，不建立模糊影像時為 nullptr */
+    void ImagePyramid::resizeNearest(const Mat &src, int iLevel, int iRowBegin, int iRowEnd, GaussianFilter *pGaussianFilter) {
+        // 該層影像是 atlas 中已經配置好的區域
+        Mat &dst = mvImages[iLevel];
+        Size size = dst.size();
+
+        // 與 cv::resize 相同，以 double 計算縮放倍率的倒數再取 floor，並限制在上一層影像的範圍內
+        // 直接以 src.cols / size.width 計算時，剛好落在整數上的取樣位置可能因為捨入誤差而與 cv::resize 差一個 pixel
+        double dInvScaleX = 1.0 / ((double)size.width / src.cols);
+        double dInvScaleY = 1.0 / ((double)size.height / src.rows);
+
+        // 每個 column 的取樣位置只有在影像寬度改變時才重新計算
+        vector<int> &vnXOffsets = mvvnXOffsets[iLevel];
+        if((int)vnXOffsets.size() != size.width || mvnSourceCols[iLevel] != src.cols) {
+            mvnSourceCols[iLevel] = src.cols;
+            vnXOffsets.resize(size.width);
+            for(int iX = 0; iX < size.width; iX++)
+                vnXOffsets[iX] = min(cvFloor(iX * dInvScaleX), src.cols - 1);
+        }
+
+        const int* pXOffsets = vnXOffsets.data();
+        for(int iY = iRowBegin; iY < iRowEnd; iY++) {
+            const uchar* pSrc = src.ptr<uchar>(min(cvFloor(iY * dInvScaleY), src.rows - 1));
+            uchar* pDst = dst.ptr<uchar>(iY);
+            for(int iX = 0; iX < size.width; iX++)
+                pDst[iX] = pSrc[pXOffsets[iX]];
+
+            if(pGaussianFilter) { pGaussianFilter->pushRow(pDst); }
+        }
+    }
+
+    /*
+    @brief 計算一個方向上的面積平均取樣方式，輸入、輸出的大小不變時沿用上一次的結果
+    
+    @param[in, out] kernel 取樣方式
+    @param[in] nSrc 輸入的 pixel 數量
+    @param[in] nDst 輸出的 pixel 數量
+    @param[in] nWeightSum 每個輸出 pixel 的權重總和
+    @param[in] nTapsAlignment 權重數量補齊的單位 */
+    void ImagePyramid::computeAreaKernel(AreaKernel &kernel, int nSrc, int nDst, int nWeightSum, int nTapsAlignment) {
+        if(kernel.nSrc == nSrc && kernel.nDst == nDst) { return; }
+        kernel.nSrc = nSrc;
+        kernel.nDst = nDst;
+
+        // 輸出的第 i 個 pixel 涵蓋輸入的 [i * dScale, (i + 1) * dScale)，與 cv::resize 的 INTER_AREA 相同
+        double dScale = (double)nSrc / nDst;
+        kernel.nTaps = 1;
+        for(int i = 0; i < nDst; i++) {
+            double dStart = i * dScale, dEnd = min((i + 1) * dScale, (double)nSrc);
+            kernel.nTaps = max(kernel.nTaps, (int)ceil(dEnd) - (int)floor(dStart));
+        }
+        kernel.nTaps = min(kernel.nTaps, nSrc);
+        kernel.nStride = (kernel.nTaps + nTapsAlignment - 1) / nTapsAlignment * nTapsAlignment;
+        int nTaps = kernel.nTaps;
+
+        // 每個輸出 pixel 都使用 nTaps 個輸入 pixel，沒有涵蓋到的權重為 0，靠近影像右側 (下方) 時起點往前移，不會讀到影像外
+        kernel.vnStarts.resize(nDst);
+        kernel.vnWeights.assign((size_t)nDst * kernel.nStride, 0);
+        for(int i = 0; i < nDst; i++) {
+            double dStart = i * dScale, dEnd = min((i + 1) * dScale, (double)nSrc);
+            int iFirst = (int)floor(dStart), iLast = min((int)ceil(dEnd), nSrc);
+            int iStart = min(iFirst, nSrc - nTaps);
+            kernel.vnStarts[i] = iStart;
+
+            // 權重是重疊長度佔整個範圍的比例，四捨五入到 1/nWeightSum，誤差補在最大的權重上讓總和剛好是 nWeightSum
+            int16_t *pnWeights = &kernel.vnWeights[(size_t)i * kernel.nStride];
+            int nSum = 0, kMax = iFirst - iStart;
+            for(int j = iFirst; j < iLast; j++) {
+                double dOverlap = min((double)(j + 1), dEnd) - max((double)j, dStart);
+                int k = j - iStart;
+                pnWeights[k] = (int16_t)cvRound(nWeightSum * dOverlap / (dEnd - dStart));
+                nSum += pnWeights[k];
+                if(pnWeights[k] > pnWeights[kMax]) { kMax = k; }
+            }
+            pnWeights[kMax] = (int16_t)(pnWeights[kMax] + nWeightSum - nSum);
+        }
+    }
+
+    /*
+    @brief 垂直方向合併輸入影像的 nTaps 列 (權重總和 128)，結果不捨入，255 * 128 不會超過 int16_t
+    
+    @param[in, out] pDst 合併後的一列
+    @param[in] pFirstRow 第一個輸入列
+    @param[in] nStep 輸入影像每一列的 bytes
+    @param[in] pnWeights 每一列的權重
+    @param[in] nTaps 輸入列的數量
+    @param[in] nCols 每一列的 pixel 數量 */
+    static void sumRowsVertical(int16_t *pDst, const uchar *pFirstRow, size_t nStep, const int16_t *pnWeights, int nTaps, int nCols) {
+        int iX = 0;
+#ifdef __SSE2__
+        // 一次處理 16 個 pixel
+        const __m128i zero = _mm_setzero_si128();
+        for(; iX <= nCols - 16; iX += 16) {
+            __m128i sumLo = zero, sumHi = zero;
+            const uchar *pRow = pFirstRow + iX;
+            for(int k = 0; k < nTaps; k++, pRow += nStep) {
+                __m128i weight = _mm_set1_epi16(pnWeights[k]);
+                __m128i v = _mm_loadu_si128((const __m128i*)pRow);
+                sumLo = _mm_add_epi16(sumLo, _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), weight));
+                sumHi = _mm_add_epi16(sumHi, _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), weight));
+            }
+            _mm_storeu_si128((__m128i*)(pDst + iX), sumLo);
+            _mm_storeu_si128((__m128i*)(pDst + iX + 8), sumHi);
+        }
+#endif
+        for(; iX < nCols; iX++) {
+            int nSum = 0;
+            const uchar *pRow = pFirstRow + iX;
+            for(int k = 0; k < nTaps; k++, pRow += nStep)
+                nSum += pnWeights[k] * pRow[0];
+            pDst[iX] = (int16_t)nSum;
+        }
+    }
+
+    /*
+    @brief 水平方向合併垂直方向的結果 (權重總和 256)，兩個方向的權重總和是 2^15，加上 2^14 之後右移 15 bits 即為四捨五入的結果
+    
+    @param[in, out] pDst 該層影像的一列
+    @param[in] pRow 垂直方向合併後的一列，結尾之後至少還有 nStride 個可以讀取的元素
+    @param[in] pnStarts, pnWeights, nTaps, nStride 水平方向的取樣方式 (AreaKernel)
+    @param[in] nDst 該層影像的寬度 */
+    static void sumColumnsHorizontal(
+        uchar *pDst, const int16_t *pRow, const int *pnStarts, const int16_t *pnWeights, int nTaps, int nStride, int nDst
+    ) {
+        int iX = 0;
+#ifdef __SSE2__
+        // 一次處理 4 個 pixel，每個 pixel 以 _mm_madd_epi16 計算 8 個權重的乘積和，再轉置相加
+        if(nStride % 8 == 0) {
+            const __m128i round = _mm_set1_epi32(1 << 14);
+            for(; iX <= nDst - 4; iX += 4) {
+                __m128i vSums[4];
+                for(int i = 0; i < 4; i++) {
+                    const int16_t *pSrc = pRow + pnStarts[iX + i];
+                    const int16_t *pWeights = pnWeights + (size_t)(iX + i) * nStride;
+                    vSums[i] = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)pSrc), _mm_loadu_si128((const __m128i*)pWeights));
+                    for(int k = 8; k < nStride; k += 8)
+                        vSums[i] = _mm_add_epi32(vSums[i], _mm_madd_epi16(
+                            _mm_loadu_si128((const __m128i*)(pSrc + k)), _mm_loadu_si128((const __m128i*)(pWeights + k))
+                        ));
+                }
+                __m128i sum01 = _mm_add_epi32(_mm_unpacklo_epi32(vSums[0], vSums[1]), _mm_unpackhi_epi32(vSums[0], vSums[1]));
+                __m128i sum23 = _mm_add_epi32(_mm_unpacklo_epi32(vSums[2], vSums[3]), _mm_unpackhi_epi32(vSums[2], vSums[3]));
+                __m128i sum = _mm_add_epi32(_mm_unpacklo_epi64(sum01, sum23), _mm_unpackhi_epi64(sum01, sum23));
+                sum = _mm_srli_epi32(_mm_add_epi32(sum, round), 15);
+                sum = _mm_packs_epi32(sum, sum);
+                sum = _mm_packus_epi16(sum, sum);
+                int nPixels = _mm_cvtsi128_si32(sum);
+                memcpy(pDst + iX, &nPixels, 4);
+            }
+        }
+#endif
+        for(; iX < nDst; iX++) {
+            const int16_t *pSrc = pRow + pnStarts[iX];
+            const int16_t *pWeights = pnWeights + (size_t)iX * nStride;
+            int nSum = 1 << 14;
+            for(int k = 0; k < nTaps; k++)
+                nSum += pWeights[k] * pSrc[k];
+            pDst[iX] = (uchar)(nSum >> 15);
+        }
+    }
+
+    /*
+    @brief 以面積平均把第 0 層影像直接縮小為該層影像，寫入 atlas 中該層影像的位置
+    
+    @param[in] iLevel 影像金字塔的層級
+    @param[in] iThread 執行緒的編號，用來選擇暫存記憶體
+    @param[in] iRowBegin, iRowEnd 要建立的列
+    @param[in] pGaussianFilter 逐列模糊該層影像的高斯濾波器，不建立模糊影像時為 nullptr */
+    void ImagePyramid::resizeArea(int iLevel, int iThread, int iRowBegin, int iRowEnd, GaussianFilter *pGaussianFilter) {
+        // 直接讀取輸入的影像 (逐列接收時為 atlas 中的第 0 層影像)，不需要等待第 0 層影像複製到 atlas 中
+        const Mat &src = *mpSourceImage;
+        Mat &dst = mvImages[iLevel];
+
+        // 取樣方式只有在影像大小改變時才重新計算，水平方向的權重補齊到 8 個，SIMD 每次讀取 8 個
+        AreaKernel &xKernel = mvXKernels[iLevel], &yKernel = mvYKernels[iLevel];
+        computeAreaKernel(xKernel, src.cols, dst.cols, 256, 8);
+        computeAreaKernel(yKernel, src.rows, dst.rows, 128, 1);
+
+        // 水平方向每個 pixel 讀取補齊後的 nStride 個元素，最後一個 pixel 會讀到影像寬度之後 (權重為 0)
+        // 暫存列只屬於這個執行緒，只會增加，不會在每張影像重新配置
+        vector<int16_t> &vnBuffer = mvvnRowBuffers[iThread];
+        if(vnBuffer.size() < (size_t)(src.cols + xKernel.nStride)) { vnBuffer.resize(src.cols + xKernel.nStride); }
+        int16_t *pBuffer = vnBuffer.data();
+        const int nTapsY = yKernel.nTaps;
+        for(int iY = iRowBegin; iY < iRowEnd; iY++) {
+            // 先在垂直方向合併，縮小後的列數較少，水平方向只需要處理合併後的一列
+            sumRowsVertical(
+                pBuffer, src.ptr<uchar>(yKernel.vnStarts[iY]), src.step,
+                &yKernel.vnWeights[(size_t)iY * nTapsY], nTapsY, src.cols
+            );
+
+            uchar *pDst = dst.ptr<uchar>(iY);
+            sumColumnsHorizontal(
+                pDst, pBuffer, xKernel.vnStarts.data(), xKernel.vnWeights.data(), xKernel.nTaps, xKernel.nStride, dst.cols
+            );
+
+            if(pGaussianFilter) { pGaussianFilter->pushRow(pDst); }
         }
     }
-}
\ No newline at end of file
+}
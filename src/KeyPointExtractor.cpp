@@ -9,16 +9,283 @@ namespace my_ORB_SLAM2 {
     @param[in] mnPaddingPixels 邊緣向內部填充的 pixels 數量
     @param[in] mnKeyPoints 總共要提取的關鍵點數量
     @param[in] miMaxTh 一開始提取關鍵點時使用的閾值
-    @param[in] miMinTh 放寬標準後，提取關鍵點的閾值 */
-    KeyPointExtractor::KeyPointExtractor(int mnLevels, float mfDefaultGridSize, int mnPaddingPixels, int mnKeyPoints, int miMaxTh, int miMinTh) {
+    @param[in] miMinTh 放寬標準後，提取關鍵點的閾值
+    @param[in] meMode 關鍵點提取模式 */
+    KeyPointExtractor::KeyPointExtractor(int mnLevels, float mfDefaultGridSize, int mnPaddingPixels, int mnKeyPoints, int miMaxTh, int miMinTh, Mode meMode) {
         this->mnLevels = mnLevels;
         this->mfDefaultGridSize = mfDefaultGridSize;
         this->mnPaddingPixels = mnPaddingPixels;
         this->mnKeyPoints = mnKeyPoints;
         this->miMaxTh = miMaxTh;
         this->miMinTh = miMinTh;
+        this->meMode = meMode;
+
+        // 每一層影像各自擁有一張分數圖，第一次提取時才依影像大小配置
+        mvScoreMaps.resize(mnLevels);
+
+        // 初始化每一層影像的提取統計
+        mvStatsPerLevel.assign(mnLevels, LevelStatistics());
+        mvTotalStatsPerLevel.assign(mnLevels, LevelStatistics());
+        mnFrames = 0;
+
+        // 預設使用固定的 miMaxTh / miMinTh
+        mbAdaptiveThresholds = false;
+        mfCornersPerFeature = 1.5f;
+        mvvCellThresholds.resize(mnLevels);
+        mvvWeakCells.resize(mnLevels);
+
+        // 預設不使用遮罩
+        mvMasks.resize(mnLevels);
+        mvvCellStates.resize(mnLevels);
+
+        // 預設只使用呼叫 extract 的執行緒
+        mvLevelContexts.resize(mnLevels);
+        setThreads(1);
     };
 
+    /*
+    @brief 設定提取時使用的執行緒數量，執行緒會一直保留到下一次設定或解構為止
+    
+    @param[in] nThreads 執行緒數量 (包含呼叫 extract 的執行緒)，1 代表不使用額外的執行緒 */
+    void KeyPointExtractor::setThreads(int nThreads) {
+        nThreads = max(nThreads, 1);
+        if(mpThreadPool && mpThreadPool->mnThreads == nThreads) { return; }
+
+        // 先結束舊的執行緒，再建立新的執行緒
+        mpThreadPool.reset();
+        mpThreadPool.reset(new ThreadPool(nThreads - 1));
+
+        // FASTDetector 內部有暫存的分數圖，每個執行緒需要各自的一份，暫存容器也一樣
+        mvFASTDetectors.resize(nThreads);
+        mvvGridKeyPoints.resize(nThreads);
+        mvGridScoreMaps.resize(nThreads);
+    }
+
+    /*
+    @brief 啟用跨影格的自適應 Grid 閾值
+    
+    @param[in] vnFeaturesPerLevel 每一層影像最後需要的關鍵點數量 (例如 ImagePyramid::mvnFeaturesPerLevel)
+    @param[in] fCornersPerFeature 每個需要的關鍵點，希望保留幾個候選角點給 Distributor */
+    void KeyPointExtractor::enableAdaptiveThresholds(const vector<int> &vnFeaturesPerLevel, float fCornersPerFeature) {
+        mbAdaptiveThresholds = true;
+        mvnFeaturesPerLevel = vnFeaturesPerLevel;
+        mvnFeaturesPerLevel.resize(mnLevels, 0);
+        mfCornersPerFeature = fCornersPerFeature;
+
+        // 清除舊的閾值，下一次提取時從 miMaxTh 重新開始
+        for(vector<uchar> &vCellThresholds : mvvCellThresholds)
+            vCellThresholds.clear();
+    }
+
+    /*
+    @brief 停用自適應 Grid 閾值，回到固定的 miMaxTh / miMinTh */
+    void KeyPointExtractor::disableAdaptiveThresholds() {
+        mbAdaptiveThresholds = false;
+    }
+
+    /*
+    @brief 設定每一層影像的靜態遮罩，並計算每個 Grid 的 CellState
+    
+    @param[in] vMasks 每一層影像的遮罩，非 0 代表可以使用；傳入空的 vector 代表不使用遮罩 */
+    void KeyPointExtractor::setMasks(const vector<Mat> &vMasks) {
+        for(int iLevel = 0; iLevel < mnLevels; iLevel++) {
+            mvMasks[iLevel] = iLevel < (int)vMasks.size() ? vMasks[iLevel] : Mat();
+            mvvCellStates[iLevel].clear();
+            if(mvMasks[iLevel].empty()) { continue; }
+
+            // Grid 劃分方式只由影像大小決定，遮罩與該層影像同大小，所以可以先算好
+            computeCellStates(mvMasks[iLevel], computeGridLayout(mvMasks[iLevel]), mvvCellStates[iLevel]);
+        }
+
+        // 分數圖中完全被遮住的 Grid 之後不會再寫入，必須是 0 才不會影響相鄰角點的非極大值抑制
+        // 所以清除上一張影像留下的分數，下一次提取時重新配置
+        for(Mat &scoreMap : mvScoreMaps)
+            scoreMap.release();
+    }
+
+    /*
+    @brief 根據遮罩計算每個 Grid 的 CellState
+    
+    @param[in] mask 該層影像的遮罩
+    @param[in] layout 該層影像的 Grid 劃分方式
+    @param[in, out] vCellStates 每個 Grid 的 CellState (row-major) */
+    void KeyPointExtractor::computeCellStates(const Mat &mask, const GridLayout &layout, vector<uchar> &vCellStates) const {
+        vCellStates.assign((size_t)layout.nRows * layout.nCols, CELL_USABLE);
+
+        // FAST 只會在距離提取範圍邊界 3 pixels 以內的地方找到角點
+        int iMinValidX = layout.iMinBorderX + 3, iMaxValidX = layout.iMaxBorderX - 3;
+        int iMinValidY = layout.iMinBorderY + 3, iMaxValidY = layout.iMaxBorderY - 3;
+
+        // Grid 模式的視窗向外擴增 6 單位後，角點落在 Grid 本身向右下平移 3 pixels 的範圍，分數圖模式的 Grid 也使用相同的範圍
+        // 所以只要檢查這個範圍，兩種模式都不會漏掉可以使用的角點
+        for(int iRow = 0; iRow < layout.nRows; iRow++) {
+            int iMinY = iMinValidY + iRow * layout.iGridHeight;
+            int iMaxY = min(iMinValidY + (iRow + 1) * layout.iGridHeight, iMaxValidY);
+            for(int iCol = 0; iCol < layout.nCols; iCol++) {
+                int iMinX = iMinValidX + iCol * layout.iGridWidth;
+                int iMaxX = min(iMinValidX + (iCol + 1) * layout.iGridWidth, iMaxValidX);
+
+                // 找不到角點的 Grid 維持原本的處理方式，統計也與沒有遮罩時相同
+                if(iMinX >= iMaxX || iMinY >= iMaxY) { continue; }
+
+                int nUsable = countNonZero(mask(Rect(iMinX, iMinY, iMaxX - iMinX, iMaxY - iMinY)));
+                uchar &state = vCellStates[iRow * layout.nCols + iCol];
+                if(nUsable == 0) { state = CELL_MASKED; }
+                else if(nUsable < (iMaxX - iMinX) * (iMaxY - iMinY)) { state = CELL_PARTIAL; }
+            }
+        }
+    }
+
+    /*
+    @brief 取得某一層影像每個 Grid 目前的閾值，Grid 數量改變時重設為 miMaxTh
+    
+    @param[in] iLevel 影像金字塔的層級
+    @param[in] layout 該層影像的 Grid 劃分方式 */
+    uchar* KeyPointExtractor::getCellThresholds(int iLevel, const GridLayout &layout) {
+        vector<uchar> &vCellThresholds = mvvCellThresholds[iLevel];
+        size_t nCells = (size_t)layout.nRows * layout.nCols;
+        if(vCellThresholds.size() != nCells)
+            vCellThresholds.assign(nCells, (uchar)min(max(miMaxTh, 1), 255));
+        return vCellThresholds.data();
+    }
+
+    /*
+    @brief 計算某一層影像每個 Grid 希望保留的角點數量
+    
+    @param[in] iLevel 影像金字塔的層級
+    @param[in] layout 該層影像的 Grid 劃分方式 */
+    int KeyPointExtractor::getTargetCornersPerCell(int iLevel, const GridLayout &layout) const {
+        // 完全被遮住的 Grid 不會提取角點，目標數量只分配給其他 Grid
+        int nCells = layout.nRows * layout.nCols;
+        const uchar* pCellStates = mvLevelContexts[iLevel].pCellStates;
+        if(pCellStates) { nCells -= count(pCellStates, pCellStates + nCells, (uchar)CELL_MASKED); }
+        nCells = max(nCells, 1);
+        return max(1, cvRound(mfCornersPerFeature * mvnFeaturesPerLevel[iLevel] / nCells));
+    }
+
+    /*
+    @brief 根據這次找到的角點數量調整 Grid 的閾值，角點太多就提高、太少就降低
+    
+    @param[in, out] threshold 該 Grid 的閾值
+    @param[in] nCorners 這次在該 Grid 閾值下找到的角點數量
+    @param[in] nTarget 該 Grid 希望保留的角點數量 */
+    void KeyPointExtractor::adaptThreshold(uchar &threshold, int nCorners, int nTarget) const {
+        // 閾值最高只到 miMaxTh 的 4 倍，避免紋理突然增加時需要很多張影像才能降回來
+        int iUpperTh = min(255, max(miMaxTh, 1) * 4);
+
+        // 介於 nTarget 與 2 * nTarget 之間就維持不變，避免閾值在兩個值之間來回震盪
+        if(nCorners > 2 * nTarget && threshold < iUpperTh) { threshold++; }
+        else if(nCorners < nTarget && threshold > max(miMinTh, 1)) { threshold--; }
+    }
+
+    /*
+    @brief 根據影像大小計算 Grid 的劃分方式
+    
+    @param[in] image 該層影像 */
+    KeyPointExtractor::GridLayout KeyPointExtractor::computeGridLayout(const Mat &image) const {
+        GridLayout layout;
+
+        // 設定可提取關鍵點的邊界
+        layout.iMinBorderX = mnPaddingPixels - 3;
+        layout.iMinBorderY = layout.iMinBorderX;
+        layout.iMaxBorderX = image.cols - mnPaddingPixels + 3;
+        layout.iMaxBorderY = image.rows - mnPaddingPixels + 3;
+
+        // 計算關鍵點提取範圍的長寬
+        float fWidth = float(layout.iMaxBorderX - layout.iMinBorderX);
+        float fHeight = float(layout.iMaxBorderY - layout.iMinBorderY);
+
+        // 計算目前的關鍵點提取範圍可以畫分成幾個行、列
+        layout.nCols = int(fWidth / mfDefaultGridSize);
+        layout.nRows = int(fHeight / mfDefaultGridSize);
+
+        // 計算每個小格子的寬、高
+        layout.iGridWidth = ceil(fWidth / layout.nCols);
+        layout.iGridHeight = ceil(fHeight / layout.nRows);
+
+        return layout;
+    }
+
+    /*
+    @brief 準備一層影像的 LevelContext，並配置該層的分數圖
+    
+    @param[in] image 該層影像
+    @param[in] iLevel 影像金字塔的層級 */
+    void KeyPointExtractor::prepareLevel(const Mat &image, int iLevel) {
+        LevelContext &context = mvLevelContexts[iLevel];
+
+        // 計算該層影像的 Grid 劃分方式
+        context.layout = computeGridLayout(image);
+        const GridLayout &layout = context.layout;
+
+        // 遮罩與該層影像同大小時，才使用設定遮罩時計算好的 CellState
+        const Mat &mask = mvMasks[iLevel];
+        bool bMasked = !mask.empty() && mask.rows == image.rows && mask.cols == image.cols;
+        context.pMask = bMasked ? &mask : nullptr;
+        context.pCellStates = bMasked ? mvvCellStates[iLevel].data() : nullptr;
+
+        // 自適應模式下，每個 Grid 從上一張影像調整後的閾值開始，否則固定為 miMaxTh
+        context.pCellThresholds = mbAdaptiveThresholds ? getCellThresholds(iLevel, layout) : nullptr;
+        context.nTarget = mbAdaptiveThresholds ? getTargetCornersPerCell(iLevel, layout) : 0;
+
+        // 計算分數時使用所有 Grid 中最寬鬆的閾值：固定模式為 miMinTh，自適應模式為目前最小的 Grid 閾值
+        context.iScoreTh = miMinTh;
+        if(context.pCellThresholds)
+            context.iScoreTh = *min_element(context.pCellThresholds, context.pCellThresholds + layout.nRows * layout.nCols);
+
+        // 分數圖的閾值高於 miMinTh 時，才需要記錄哪些 Grid 要以 miMinTh 重新計算分數
+        context.pWeakCells = nullptr;
+        if(meMode == SCORE_MAP && context.iScoreTh > miMinTh) {
+            mvvWeakCells[iLevel].assign((size_t)layout.nRows * layout.nCols, 0);
+            context.pWeakCells = mvvWeakCells[iLevel].data();
+        }
+
+        // 分數圖與該層影像同大小，只有在影像大小改變時才重新配置
+        // 提取範圍外的一圈 pixel 永遠是 0，非極大值抑制時就不必檢查邊界
+        Mat &scoreMap = mvScoreMaps[iLevel];
+        if(scoreMap.rows != image.rows || scoreMap.cols != image.cols) {
+            scoreMap.create(image.rows, image.cols, CV_8U);
+            scoreMap.setTo(Scalar(0));
+        }
+    }
+
+    /*
+    @brief 計算數列 Grid 內最多可能的角點數量：嚴格的非極大值抑制下，相鄰的 pixel 不會同時是角點，所以每個 Grid 的每個 2x2 區塊最多只有一個角點
+    Grid 模式只在各自的視窗內做非極大值抑制，相鄰 Grid 邊界上的角點可能相鄰，所以以 Grid 為單位計算
+    
+    @param[in] layout 該層影像的 Grid 劃分方式
+    @param[in] nRows Grid 的列數
+    @return 最多可能的角點數量 */
+    int KeyPointExtractor::countMaxCorners(const GridLayout &layout, int nRows) {
+        return nRows * layout.nCols * ((layout.iGridHeight + 1) / 2) * ((layout.iGridWidth + 1) / 2);
+    }
+
+    /*
+    @brief 把每一層影像切成 Tile，每個 Tile 的 Grid 列數以第 0 層平分給所有執行緒為準
+    
+    @param[in] nThreads 執行緒數量 */
+    void KeyPointExtractor::splitTiles(int nThreads) {
+        // 只有一個執行緒時，每一層影像就是一個 Tile
+        int nRowsPerTile = max(1, (mvLevelContexts[0].layout.nRows + nThreads - 1) / nThreads);
+
+        mvTiles.clear();
+        for(int iLevel = 0; iLevel < mnLevels; iLevel++) {
+            int nRows = mvLevelContexts[iLevel].layout.nRows;
+            for(int iRowBegin = 0; iRowBegin < nRows; iRowBegin += nRowsPerTile)
+                mvTiles.push_back(Tile{iLevel, iRowBegin, min(iRowBegin + nRowsPerTile, nRows)});
+        }
+
+        // 每個 Tile 各自的輸出與統計，保留上一張影像配置的空間
+        // 並依 Tile 內最多可能的角點數量預先配置，之後不論影像內容如何，只要影像大小不變就不會再配置記憶體
+        mvvTileKeyPoints.resize(mvTiles.size());
+        for(size_t iTile = 0; iTile < mvTiles.size(); iTile++) {
+            const Tile &tile = mvTiles[iTile];
+            mvvTileKeyPoints[iTile].clear();
+            mvvTileKeyPoints[iTile].reserve(countMaxCorners(mvLevelContexts[tile.iLevel].layout, tile.iRowEnd - tile.iRowBegin));
+        }
+        mvTileStats.assign(mvTiles.size(), LevelStatistics());
+    }
+
     /*
     @brief 提取關鍵點的 function
     
@@ -28,93 +295,721 @@ namespace my_ORB_SLAM2 {
         vector<vector<KeyPoint>> &vvKeyPointsPerLevel, 
         const vector<Mat> &vImagePerLevel
     ) {
-        // 設定 vvKeyPointsPerLevel 大小為影像金字塔層數
+        extractLevels(vvKeyPointsPerLevel, vImagePerLevel, nullptr);
+    }
+
+    /*
+    @brief 建立影像金字塔並提取關鍵點，第 0 層影像完成後就開始提取，較高層的影像同時由其他執行緒建立
+    
+    @param[in, out] vvKeyPointsPerLevel 儲存影像金字塔中，每層影像的關鍵點
+    @param[in, out] imagePyramid 影像金字塔，層數必須與提取器相同
+    @param[in] image 影像金字塔的影像 */
+    void KeyPointExtractor::extract(
+        vector<vector<KeyPoint>> &vvKeyPointsPerLevel,
+        ImagePyramid &imagePyramid,
+        const Mat &image
+    ) {
+        // 先規劃好 atlas，每一層影像的 header 與大小在建立之前就已經確定，可以先準備 Grid 與 Tile
+        imagePyramid.beginImage(image, mpThreadPool->mnThreads);
+        extractLevels(vvKeyPointsPerLevel, imagePyramid.mvImages, &imagePyramid);
+    }
+
+    /*
+    @brief 平行處理所有 Tile，需要同時建立影像金字塔時，每個 Tile 開始前等待該層影像完成
+    
+    @param[in, out] pImagePyramid 需要同時建立的影像金字塔，影像已經建立好時為 nullptr
+    @param[in] tileTask 處理一個 Tile 的工作 */
+    template<typename TileTask>
+    void KeyPointExtractor::runTiles(ImagePyramid *pImagePyramid, TileTask &&tileTask) {
+        int nTiles = mvTiles.size();
+        if(!pImagePyramid) {
+            mpThreadPool->run(nTiles, tileTask);
+            return;
+        }
+
+        // Tile 依層級排序，第 0 層的 Tile 在最前面
+        int nLevel0Tiles = 0;
+        while(nLevel0Tiles < nTiles && mvTiles[nLevel0Tiles].iLevel == 0) { nLevel0Tiles++; }
+
+        // 第 0 層影像只需要複製，先開始提取第 0 層，較高層的影像交給剩下的執行緒建立，藏在第 0 層的 FAST 後面
+        mpThreadPool->run(nTiles + mnLevels, [&](int iTask, int iThread) {
+            if(iTask == 0) {
+                pImagePyramid->buildLevel(0, iThread);
+                return;
+            }
+
+            iTask -= 1;
+            if(iTask >= nLevel0Tiles && iTask < nLevel0Tiles + mnLevels - 1) {
+                pImagePyramid->buildLevel(iTask - nLevel0Tiles + 1, iThread);
+                return;
+            }
+
+            int iTile = iTask < nLevel0Tiles ? iTask : iTask - (mnLevels - 1);
+            pImagePyramid->waitLevel(mvTiles[iTile].iLevel);
+            tileTask(iTile, iThread);
+        });
+    }
+
+    /*
+    @brief 提取關鍵點的主要流程，兩個 extract 共用
+    
+    @param[in, out] vvKeyPointsPerLevel 儲存影像金字塔中，每層影像的關鍵點
+    @param[in] vImagePerLevel 影像金字塔的每一層影像
+    @param[in, out] pImagePyramid 需要同時建立的影像金字塔，影像已經建立好時為 nullptr */
+    void KeyPointExtractor::extractLevels(
+        vector<vector<KeyPoint>> &vvKeyPointsPerLevel,
+        const vector<Mat> &vImagePerLevel,
+        ImagePyramid *pImagePyramid
+    ) {
+        prepareExtraction(vImagePerLevel);
+
+        // 依照提取模式平行提取每個 Tile 的關鍵點，每個 Tile 寫入自己的輸出與統計，不需要上鎖
+        runTiles(pImagePyramid, [&](int iTile, int iThread) {
+            extractTile(iTile, iThread, vImagePerLevel);
+        });
+
+        finishExtraction(vvKeyPointsPerLevel, vImagePerLevel);
+    }
+
+    /*
+    @brief 開始逐列接收影像並提取關鍵點
+    
+    @param[in, out] imagePyramid 影像金字塔，層數必須與提取器相同，提取結束前不可以再設定其他影像
+    @param[in] imageSize 第 0 層影像的大小 */
+    void KeyPointExtractor::beginStream(ImagePyramid &imagePyramid, Size imageSize) {
+        // 先規劃好 atlas，每一層影像的大小在收到任何一列之前就已經確定，可以先準備 Grid 與 Tile
+        imagePyramid.beginStream(imageSize);
+        mpStreamPyramid = &imagePyramid;
+        prepareExtraction(imagePyramid.mvImages);
+
+        // Tile 依層級、Grid 列的順序排列，每一層從該層的第一個 Tile 開始
+        mvnNextTiles.resize(mnLevels);
+        mvnLevelTileEnds.resize(mnLevels);
+        int nTiles = mvTiles.size(), iTile = 0;
+        for(int iLevel = 0; iLevel < mnLevels; iLevel++) {
+            mvnNextTiles[iLevel] = iTile;
+            while(iTile < nTiles && mvTiles[iTile].iLevel == iLevel) { iTile++; }
+            mvnLevelTileEnds[iLevel] = iTile;
+        }
+    }
+
+    /*
+    @brief 傳入第 0 層影像接下來的數列，建立影像金字塔中可以建立的列，並平行提取所需的列都已經建立好的 Tile
+    
+    @param[in] rows 接下來的數列，寬度與影像相同 */
+    void KeyPointExtractor::pushRows(const Mat &rows) {
+        mpStreamPyramid->pushRows(rows);
+        extractReadyTiles();
+    }
+
+    /*
+    @brief 所有列都傳入後，提取剩下的 Tile 並完成提取
+    
+    @param[in, out] vvKeyPointsPerLevel 儲存影像金字塔中，每層影像的關鍵點 */
+    void KeyPointExtractor::endStream(vector<vector<KeyPoint>> &vvKeyPointsPerLevel) {
+        extractReadyTiles();
+
+        // 所有列都必須已經傳入：每一層影像都已經建立完成，每一層的 Tile 也都已經提取，否則輸出會少了影像下方的關鍵點
+        for(int iLevel = 0; iLevel < mnLevels; iLevel++)
+            CV_Assert(mpStreamPyramid->isLevelReady(iLevel) && mvnNextTiles[iLevel] == mvnLevelTileEnds[iLevel]);
+
+        finishExtraction(vvKeyPointsPerLevel, mpStreamPyramid->mvImages);
+        mpStreamPyramid = nullptr;
+    }
+
+    /*
+    @brief 逐列接收影像時，平行提取所需的列都已經建立好、還沒提取的 Tile */
+    void KeyPointExtractor::extractReadyTiles() {
+        mvnReadyTiles.clear();
+        for(int iLevel = 0; iLevel < mnLevels; iLevel++) {
+            int nAvailableRows = mpStreamPyramid->getAvailableRows(iLevel);
+            int &iNextTile = mvnNextTiles[iLevel];
+            while(iNextTile < mvnLevelTileEnds[iLevel] && getTileRowEnd(mvTiles[iNextTile]) <= nAvailableRows)
+                mvnReadyTiles.push_back(iNextTile++);
+        }
+
+        const vector<Mat> &vImagePerLevel = mpStreamPyramid->mvImages;
+        mpThreadPool->run((int)mvnReadyTiles.size(), [&](int iTask, int iThread) {
+            extractTile(mvnReadyTiles[iTask], iThread, vImagePerLevel);
+        });
+    }
+
+    /*
+    @brief 提取一個 Tile 需要的影像列數
+    
+    @param[in] tile 要提取的 Tile */
+    int KeyPointExtractor::getTileRowEnd(const Tile &tile) const {
+        // 每個 Grid 的視窗向下擴增 6 列，分數圖模式的角點範圍向下平移 3 列，計算分數時也剛好讀到最後一列 Grid 下方 6 列，都不會超過 iMaxBorderY
+        const GridLayout &layout = mvLevelContexts[tile.iLevel].layout;
+        return min(layout.iMinBorderY + tile.iRowEnd * layout.iGridHeight + 6, layout.iMaxBorderY);
+    }
+
+    /*
+    @brief 提取前準備好每一層影像的設定、Tile 與每個執行緒的暫存空間
+    
+    @param[in] vImagePerLevel 影像金字塔的每一層影像，只會用到影像的大小 */
+    void KeyPointExtractor::prepareExtraction(const vector<Mat> &vImagePerLevel) {
+        // 在平行提取前準備好每一層影像的設定，之後各個 Tile 只會讀取
+        for(int iLevel = 0; iLevel < mnLevels; iLevel++)
+            prepareLevel(vImagePerLevel[iLevel], iLevel);
+
+        // 第 0 層影像最大，只以層級平行的話其他執行緒很快就會閒置，所以每一層影像再依 Grid 列切成 Tile
+        splitTiles(mpThreadPool->mnThreads);
+
+        // Tile 每次可能由不同的執行緒處理，所以每個執行緒的暫存空間都依最大的 Grid 視窗預先配置
+        // 否則暫存空間會隨著分配到的 Grid 不同而陸續擴增
+        // 嚴格的非極大值抑制下，相鄰的 pixel 不會同時是角點，所以每個 2x2 區塊最多只有一個角點
+        if(meMode == GRID_FAST) {
+            int nMaxRows = 0, nMaxCols = 0;
+            for(const LevelContext &context : mvLevelContexts) {
+                nMaxRows = max(nMaxRows, context.layout.iGridHeight + 6);
+                nMaxCols = max(nMaxCols, context.layout.iGridWidth + 6);
+            }
+            for(int iThread = 0; iThread < mpThreadPool->mnThreads; iThread++) {
+                Mat &gridScoreMap = mvGridScoreMaps[iThread];
+                if(gridScoreMap.rows < nMaxRows || gridScoreMap.cols < nMaxCols)
+                    gridScoreMap.create(max(gridScoreMap.rows, nMaxRows), max(gridScoreMap.cols, nMaxCols), CV_8U);
+                mvvGridKeyPoints[iThread].reserve(((nMaxRows + 1) / 2) * ((nMaxCols + 1) / 2));
+            }
+        }
+    }
+
+    /*
+    @brief 提取一個 Tile：Grid 模式直接提取關鍵點，分數圖模式只計算分數，所有 Tile 都完成後再由 finishExtraction 收集角點
+    
+    @param[in] iTile Tile 的編號
+    @param[in] iThread 執行該 Tile 的執行緒
+    @param[in] vImagePerLevel 影像金字塔的每一層影像 */
+    void KeyPointExtractor::extractTile(int iTile, int iThread, const vector<Mat> &vImagePerLevel) {
+        const Tile &tile = mvTiles[iTile];
+        if(meMode == SCORE_MAP)
+            scoreTile(vImagePerLevel[tile.iLevel], tile, mvFASTDetectors[iThread]);
+        else
+            extractPerGrid(mvvTileKeyPoints[iTile], vImagePerLevel[tile.iLevel], tile, mvTileStats[iTile], iThread);
+    }
+
+    /*
+    @brief 所有 Tile 都提取完後，合併每一層影像的關鍵點並完成非極大值抑制與統計
+    
+    @param[in, out] vvKeyPointsPerLevel 儲存影像金字塔中，每層影像的關鍵點
+    @param[in] vImagePerLevel 影像金字塔的每一層影像 */
+    void KeyPointExtractor::finishExtraction(vector<vector<KeyPoint>> &vvKeyPointsPerLevel, const vector<Mat> &vImagePerLevel) {
+        // 設定 vvKeyPointsPerLevel 大小為影像金字塔層數，每一層同樣依最多可能的角點數量預先配置
         vvKeyPointsPerLevel.resize(mnLevels);
+        for(int iLevel = 0; iLevel < mnLevels; iLevel++) {
+            const GridLayout &layout = mvLevelContexts[iLevel].layout;
+            vvKeyPointsPerLevel[iLevel].reserve(countMaxCorners(layout, layout.nRows));
+        }
+
+        // 非極大值抑制需要讀取相鄰 Tile 邊界上的分數，所以所有 Tile 的分數都計算完後才開始收集角點
+        int nTiles = mvTiles.size();
+        if(meMode == SCORE_MAP) {
+            // 自適應模式下，分數圖的閾值可能高於 miMinTh，沒有角點達到自己閾值的 Grid 要以 miMinTh 重新計算分數
+            // 判斷時同樣要讀取相鄰 Tile 的分數，所以先標記所有 Grid，再重新計算分數
+            // 重新計算只會寫入低於 iScoreTh 的分數，不會改變其他 Grid 的判斷，結果與 Tile 的處理順序無關
+            bool bRescore = any_of(mvLevelContexts.begin(), mvLevelContexts.end(), [](const LevelContext &context) {
+                return context.pWeakCells != nullptr;
+            });
+            if(bRescore) {
+                mpThreadPool->run(nTiles, [&](int iTile, int /*iThread*/) {
+                    if(mvLevelContexts[mvTiles[iTile].iLevel].pWeakCells) { markWeakCells(mvTiles[iTile]); }
+                });
+                mpThreadPool->run(nTiles, [&](int iTile, int iThread) {
+                    const Tile &tile = mvTiles[iTile];
+                    if(mvLevelContexts[tile.iLevel].pWeakCells)
+                        rescoreWeakCells(vImagePerLevel[tile.iLevel], tile, mvFASTDetectors[iThread]);
+                });
+            }
+
+            mpThreadPool->run(nTiles, [&](int iTile, int /*iThread*/) {
+                collectFromScoreMap(mvvTileKeyPoints[iTile], mvTiles[iTile], mvTileStats[iTile]);
+            });
+        }
 
-        // 遍歷每一層影像 #pragma omp parallel for
+        // 依 Tile 順序合併每一層影像的關鍵點與統計，結果與執行緒數量、Tile 的完成順序無關
         for(int iLevel = 0; iLevel < mnLevels; iLevel++) {
-            // 設定可提取關鍵點的邊界
-            int iMinBorderX = mnPaddingPixels - 3;
-            int iMinBorderY = iMinBorderX;
-            int iMaxBorderX = vImagePerLevel[iLevel].cols - mnPaddingPixels + 3;
-            int iMaxBorderY = vImagePerLevel[iLevel].rows - mnPaddingPixels + 3;
-            
-            // keyPoints 用於儲存該層影像的關鍵點，並預留比預計提取之關鍵點數量多 10 倍的空間
-            // 避免動態擴增空間造成的性能消耗
-            vector<KeyPoint> vKeyPoints;
-            vKeyPoints.reserve(mnKeyPoints * 10);
+            vvKeyPointsPerLevel[iLevel].clear();
+            mvStatsPerLevel[iLevel] = LevelStatistics();
+        }
+        for(int iTile = 0; iTile < nTiles; iTile++) {
+            int iLevel = mvTiles[iTile].iLevel;
+            vector<KeyPoint> &vKeyPoints = vvKeyPointsPerLevel[iLevel];
+            vKeyPoints.insert(vKeyPoints.end(), mvvTileKeyPoints[iTile].begin(), mvvTileKeyPoints[iTile].end());
+
+            LevelStatistics &stats = mvStatsPerLevel[iLevel];
+            const LevelStatistics &tileStats = mvTileStats[iTile];
+            stats.nCells += tileStats.nCells;
+            stats.nFallbackCells += tileStats.nFallbackCells;
+            stats.nEmptyCells += tileStats.nEmptyCells;
+            stats.nThresholdSum += tileStats.nThresholdSum;
+        }
+
+        // 每個 Grid 的 FAST 只會在自己的視窗內做非極大值抑制，所以相鄰 Grid 邊界上的局部最大值可能同時保留
+        // 每一層影像有自己的分數圖，可以依層級平行處理
+        // 分數圖模式已經在整層影像上做過非極大值抑制，不需要這一步
+        if(meMode == GRID_FAST) {
+            mpThreadPool->run(mnLevels, [&](int iLevel, int /*iThread*/) {
+                suppressNonMaxima(
+                    vvKeyPointsPerLevel[iLevel], vImagePerLevel[iLevel], mvLevelContexts[iLevel].layout, iLevel, mvStatsPerLevel[iLevel]
+                );
+            });
+        }
+
+        for(int iLevel = 0; iLevel < mnLevels; iLevel++) {
+            const GridLayout &layout = mvLevelContexts[iLevel].layout;
+            vector<KeyPoint> &vKeyPoints = vvKeyPointsPerLevel[iLevel];
+
+            LevelStatistics &stats = mvStatsPerLevel[iLevel];
+            stats.nRawCorners = vKeyPoints.size();
+
+            // 累計該層的提取統計
+            LevelStatistics &totalStats = mvTotalStatsPerLevel[iLevel];
+            totalStats.nCells += stats.nCells;
+            totalStats.nFallbackCells += stats.nFallbackCells;
+            totalStats.nEmptyCells += stats.nEmptyCells;
+            totalStats.nRawCorners += stats.nRawCorners;
+            totalStats.nThresholdSum += stats.nThresholdSum;
+            totalStats.nSuppressedCorners += stats.nSuppressedCorners;
+
+            // 修飾該層最後提取到的關鍵點
+            for(vector<KeyPoint>::iterator vit = vKeyPoints.begin(); vit != vKeyPoints.end(); vit++) {
+                vit->pt.x += layout.iMinBorderX; // 增加 Offset
+                vit->pt.y += layout.iMinBorderY; // 增加 Offset
+                vit->octave = iLevel; // 設定關鍵點所屬的金字塔層級
+            }
+        }
+
+        mnFrames++;
+    }
+
+    /*
+    @brief 清除累計的提取統計 */
+    void KeyPointExtractor::resetStatistics() {
+        mvTotalStatsPerLevel.assign(mnLevels, LevelStatistics());
+        mnFrames = 0;
+    }
+
+    /*
+    @brief 輸出每一層影像平均每張影像的提取統計 */
+    void KeyPointExtractor::printStatistics() const {
+        printf("Key Point Extractor Statistics (%lu frames): \n", mnFrames);
+        if(mnFrames == 0) { return; }
+
+        double dFrames = (double)mnFrames;
+        for(int iLevel = 0; iLevel < mnLevels; iLevel++) {
+            const LevelStatistics &stats = mvTotalStatsPerLevel[iLevel];
+            printf(
+                " - Level %d: cells %.1f, fallback cells %.1f, empty cells %.1f, raw corners %.1f, suppressed corners %.1f, mean threshold %.1f\n",
+                iLevel,
+                stats.nCells / dFrames,
+                stats.nFallbackCells / dFrames,
+                stats.nEmptyCells / dFrames,
+                stats.nRawCorners / dFrames,
+                stats.nSuppressedCorners / dFrames,
+                stats.nCells > 0 ? (double)stats.nThresholdSum / stats.nCells : 0.0
+            );
+        }
+    }
+
+    /*
+    @brief 一個 Tile 內的每個 Grid 各自呼叫 FAST 提取關鍵點，座標相對於 (iMinBorderX, iMinBorderY)
+    
+    @param[in, out] vKeyPoints 該 Tile 的關鍵點
+    @param[in] image 該層影像
+    @param[in] tile 要提取的 Tile
+    @param[in, out] stats 該 Tile 的提取統計
+    @param[in] iThread 執行該 Tile 的執行緒，用來選擇該執行緒專用的 FAST 偵測器與暫存容器 */
+    void KeyPointExtractor::extractPerGrid(vector<KeyPoint> &vKeyPoints, const Mat &image, const Tile &tile, LevelStatistics &stats, int iThread) {
+        FASTDetector &fastDetector = mvFASTDetectors[iThread];
+        vector<KeyPoint> &vGridKeyPoints = mvvGridKeyPoints[iThread];
+        Mat &gridScoreMap = mvGridScoreMaps[iThread];
+
+        // 自適應模式下，每個 Grid 從上一張影像調整後的閾值開始
+        const LevelContext &context = mvLevelContexts[tile.iLevel];
+        const GridLayout &layout = context.layout;
+        uchar* pCellThresholds = context.pCellThresholds;
+        int nTarget = context.nTarget;
+
+        // 收集 Grid 視窗內通過非極大值抑制的角點，座標相對於 Grid 的視窗 (iMinX, iMinY)，並回傳分數達到 iCellTh 的角點數量
+        // 分數 >= iCellTh 的角點若在 miMinTh 下是局部最大值，在 iCellTh 下也一樣，反之亦然
+        // 所以只需要以 miMinTh 計算一次分數，兩種閾值的結果都和直接以該閾值呼叫 FAST 相同
+        // 部分被遮住的 Grid 傳入遮罩，跳過落在被遮住的 pixel 上的角點
+        auto collect = [&vGridKeyPoints](const Mat &scoreMap, int iCellTh, const Mat* pMask, int iMinX, int iMinY) {
+            int nStrong = 0;
+            for(int iY = 3; iY < scoreMap.rows - 3; iY++) {
+                const uchar* pPrev = scoreMap.ptr<uchar>(iY - 1);
+                const uchar* pCurr = scoreMap.ptr<uchar>(iY);
+                const uchar* pNext = scoreMap.ptr<uchar>(iY + 1);
+                const uchar* pMaskRow = pMask ? pMask->ptr<uchar>(iMinY + iY) + iMinX : nullptr;
+                for(int iX = 3; iX < scoreMap.cols - 3; iX++) {
+                    int score = pCurr[iX];
+                    if(score == 0) { continue; }
+                    if(pMaskRow && pMaskRow[iX] == 0) { continue; }
+                    if(!(score > pPrev[iX - 1] && score > pPrev[iX] && score > pPrev[iX + 1] &&
+                         score > pCurr[iX - 1] && score > pCurr[iX + 1] &&
+                         score > pNext[iX - 1] && score > pNext[iX] && score > pNext[iX + 1])) { continue; }
+
+                    if(score >= iCellTh) { nStrong++; }
+                    vGridKeyPoints.emplace_back((float)iX, (float)iY, 7.f, -1, (float)score);
+                }
+            }
+            return nStrong;
+        };
+
+        // 遍歷該 Tile 內的每個 Grid
+        for(int iRow = tile.iRowBegin; iRow < tile.iRowEnd; iRow++) {
+            // 計算 FAST 關鍵點需要半徑為 3 的圓形範圍，FAST 只會在距離視窗邊界 3 pixels 以內的地方找到角點
+            // 所以每個 Grid 的視窗需要向外擴增 6 單位，相鄰 Grid 的偵測範圍才會剛好接在一起
+            // 不會重疊，也不會在 Grid 之間留下沒有被測試的 pixels
+            int iMinY = layout.iMinBorderY + iRow * layout.iGridHeight;
+            int iMaxY = iMinY + layout.iGridHeight + 6;
+
+            // 如果 ymin 超過 maxBorderY - 6，代表沒有足夠的半徑 3 可以計算關鍵點，跳過
+            if(iMinY > layout.iMaxBorderY - 6) { continue; }
             
-            // 計算關鍵點提取範圍的長寬
-            float fWidth = float(iMaxBorderX - iMinBorderX);
-            float fHeight = float(iMaxBorderY - iMinBorderY);
+            // 限制 ymax 不要超過關鍵點的提取範圍
+            if(iMaxY > layout.iMaxBorderY) { iMaxY = layout.iMaxBorderY; }
             
-            // 計算目前的關鍵點提取範圍可以畫分成幾個行、列
-            int nCols = int(fWidth / mfDefaultGridSize);
-            int nRows = int(fHeight / mfDefaultGridSize);
-
-            // 計算每個小格子的寬、高
-            int iGridWidth = ceil(fWidth / nCols);
-            int iGridHeight = ceil(fHeight / nRows);
-
-            // 遍歷每個 Grid
-            for(int iRow = 0; iRow < nRows; iRow++) {
-                // 計算 FAST 關鍵點需要半徑為 3 的圓形範圍
-                // 所以每個 Grid 的邊界需要暫時向外擴增 3 單位
-                // 才可以確保沒丟失邊界的關鍵點訊息
-                int iMinY = iMinBorderY + iRow * iGridHeight;
-                int iMaxY = iMinY + iGridHeight + 3;
-
-                // 如果 ymin 超過 maxBorderY - 6，代表沒有足夠的半徑 3 可以計算關鍵點，跳過
-                if(iMinY > iMaxBorderY - 6) { continue; }
-                
-                // 限制 ymax 不要超過關鍵點的提取範圍
-                if(iMaxY > iMaxBorderY) { iMaxY = iMaxBorderY; }
-                
-                // 前置步驟和上面一樣
-                for(int iCol = 0; iCol < nCols; iCol++) {
-                    int iMinX = iMinBorderX + iCol * iGridWidth;
-                    int iMaxX = iMinX + iGridWidth + 3;
-                    if(iMinX > iMaxBorderX - 6) { continue; }
-                    if(iMaxX > iMaxBorderX) { iMaxX = iMaxBorderX; }
-
-                    // 提取該 Grid 的關鍵點
-                    vector<KeyPoint> vGridKeyPoints;
-                    vGridKeyPoints.reserve(64);
-                    FAST(
-                        vImagePerLevel[iLevel].rowRange(iMinY, iMaxY).colRange(iMinX, iMaxX), 
-                        vGridKeyPoints, 
-                        miMinTh
+            // 前置步驟和上面一樣
+            for(int iCol = 0; iCol < layout.nCols; iCol++) {
+                int iMinX = layout.iMinBorderX + iCol * layout.iGridWidth;
+                int iMaxX = iMinX + layout.iGridWidth + 6;
+                if(iMinX > layout.iMaxBorderX - 6) { continue; }
+                if(iMaxX > layout.iMaxBorderX) { iMaxX = layout.iMaxBorderX; }
+
+                // 完全被遮住的 Grid 直接跳過，部分被遮住的 Grid 只保留落在可以使用的 pixel 上的角點
+                uchar cellState = context.pCellStates ? context.pCellStates[iRow * layout.nCols + iCol] : (uchar)CELL_USABLE;
+                if(cellState == CELL_MASKED) { continue; }
+
+                // 較嚴格的閾值 (miMaxTh 或該 Grid 的自適應閾值)
+                int iCellTh = pCellThresholds ? pCellThresholds[iRow * layout.nCols + iCol] : miMaxTh;
+                stats.nCells++;
+                stats.nThresholdSum += iCellTh;
+
+                // 以 miMinTh 對該 Grid 的視窗計算一次分數，視窗邊緣 3 pixels 不計算，保持為 0
+                vGridKeyPoints.clear();
+                int nStrongCorners = 0;
+                if(iMaxY - iMinY >= 7 && iMaxX - iMinX >= 7) {
+                    Mat window = image.rowRange(iMinY, iMaxY).colRange(iMinX, iMaxX);
+                    Mat scoreMap = gridScoreMap.rowRange(0, window.rows).colRange(0, window.cols);
+                    scoreMap.setTo(Scalar(0));
+                    fastDetector.computeScores(window, scoreMap, Rect(3, 3, window.cols - 6, window.rows - 6), miMinTh);
+
+                    // 在該 Grid 的閾值下找到的角點數量，用來調整下一張影像的閾值
+                    nStrongCorners = collect(scoreMap, iCellTh, cellState == CELL_PARTIAL ? context.pMask : nullptr, iMinX, iMinY);
+                }
+
+                // 如果有角點達到 iCellTh，就只保留這些角點；否則放寬標準，保留 miMinTh 下的所有角點
+                if(nStrongCorners > 0) {
+                    vGridKeyPoints.erase(
+                        remove_if(vGridKeyPoints.begin(), vGridKeyPoints.end(),
+                            [iCellTh](const KeyPoint &keyPoint) { return keyPoint.response < iCellTh; }),
+                        vGridKeyPoints.end()
                     );
+                }
+                else if(iCellTh > miMinTh) { stats.nFallbackCells++; }
 
-                    // 如果沒有檢測到關鍵點，就降低閾值在提取一次
-                    if(vGridKeyPoints.empty()) {
-                        FAST(
-                            vImagePerLevel[iLevel].rowRange(iMinY, iMaxY).colRange(iMinX, iMaxX), 
-                            vGridKeyPoints, 
-                            miMinTh
-                        );
-                    }
+                // 放寬標準後仍然沒有關鍵點
+                if(vGridKeyPoints.empty()) { stats.nEmptyCells++; }
+
+                // 根據在該 Grid 閾值下找到的角點數量，調整下一張影像使用的閾值
+                // 放寬標準的 Grid 視為找不到角點，讓閾值往下調整
+                if(pCellThresholds)
+                    adaptThreshold(pCellThresholds[iRow * layout.nCols + iCol], nStrongCorners, nTarget);
 
-                    // 因為目前提取到的關鍵點座標是相對於該 Grid 的，所以需要恢復到相對於整張影像的座標
-                    if(!vGridKeyPoints.empty()) {
-                        for(vector<KeyPoint>::iterator vit = vGridKeyPoints.begin(); vit != vGridKeyPoints.end(); vit++) {
-                            vit->pt.x += iCol * iGridWidth;
-                            vit->pt.y += iRow * iGridHeight;
-                            vKeyPoints.push_back(*vit);
-                        }
+                // 因為目前提取到的關鍵點座標是相對於該 Grid 的，所以需要恢復到相對於整張影像的座標
+                if(!vGridKeyPoints.empty()) {
+                    for(vector<KeyPoint>::iterator vit = vGridKeyPoints.begin(); vit != vGridKeyPoints.end(); vit++) {
+                        vit->pt.x += iCol * layout.iGridWidth;
+                        vit->pt.y += iRow * layout.iGridHeight;
+                        vKeyPoints.push_back(*vit);
                     }
                 }
             }
+        }
+    }
 
-            // 修飾該層最後提取到的關鍵點
-            for(vector<KeyPoint>::iterator vit = vKeyPoints.begin(); vit != vKeyPoints.end(); vit++) {
-                vit->pt.x += iMinBorderX; // 增加 Offset
-                vit->pt.y += iMinBorderY; // 增加 Offset
-                vit->octave = iLevel; // 設定關鍵點所屬的金字塔層級
+    /*
+    @brief 對整層影像合併後的角點做跨 Grid 的非極大值抑制：先把分數寫入分數圖，
+    再讓每個角點和它的 8 個鄰居比較，只需要線性時間，不需要兩兩比較
+    
+    @param[in, out] vKeyPoints 該層影像的關鍵點，座標相對於 (iMinBorderX, iMinBorderY)
+    @param[in] image 該層影像
+    @param[in] layout 該層影像的 Grid 劃分方式
+    @param[in] iLevel 影像金字塔的層級
+    @param[in, out] stats 該層影像的提取統計 */
+    void KeyPointExtractor::suppressNonMaxima(vector<KeyPoint> &vKeyPoints, const Mat &image, const GridLayout &layout, int iLevel, LevelStatistics &stats) {
+        // 分數圖與該層影像同大小，使用前後都保持全部為 0
+        Mat &scoreMap = mvScoreMaps[iLevel];
+        if(scoreMap.rows != image.rows || scoreMap.cols != image.cols) {
+            scoreMap.create(image.rows, image.cols, CV_8U);
+            scoreMap.setTo(Scalar(0));
+        }
+
+        // 把每個角點的分數寫入分數圖，同一個 pixel 被回報多次時保留最大的分數
+        for(const KeyPoint &keyPoint : vKeyPoints) {
+            uchar &score = scoreMap.at<uchar>(int(keyPoint.pt.y) + layout.iMinBorderY, int(keyPoint.pt.x) + layout.iMinBorderX);
+            score = max(score, (uchar)keyPoint.response);
+        }
+
+        // FAST 的分數最高只有 254，所以用 255 標記要保留的角點
+        // 同一個 pixel 的重複角點之後就不會再通過，而它的鄰居本來就比它小，一樣會被抑制
+        const uchar kept = 255;
+
+        // 標記分數嚴格大於 8 個鄰居的角點
+        for(const KeyPoint &keyPoint : vKeyPoints) {
+            int iX = int(keyPoint.pt.x) + layout.iMinBorderX;
+            int iY = int(keyPoint.pt.y) + layout.iMinBorderY;
+            const uchar* pPrev = scoreMap.ptr<uchar>(iY - 1);
+            uchar* pCurr = scoreMap.ptr<uchar>(iY);
+            const uchar* pNext = scoreMap.ptr<uchar>(iY + 1);
+
+            int score = (int)keyPoint.response;
+            if(score != pCurr[iX]) { continue; }
+            if(score > pPrev[iX - 1] && score > pPrev[iX] && score > pPrev[iX + 1] &&
+               score > pCurr[iX - 1] && score > pCurr[iX + 1] &&
+               score > pNext[iX - 1] && score > pNext[iX] && score > pNext[iX + 1]) { pCurr[iX] = kept; }
+        }
+
+        // 依原本的順序保留被標記的角點，同時把寫入過的 pixel 歸零，留給下一張影像使用
+        size_t nKept = 0;
+        for(size_t i = 0; i < vKeyPoints.size(); i++) {
+            uchar &score = scoreMap.at<uchar>(int(vKeyPoints[i].pt.y) + layout.iMinBorderY, int(vKeyPoints[i].pt.x) + layout.iMinBorderX);
+            if(score == kept) { vKeyPoints[nKept++] = vKeyPoints[i]; }
+            score = 0;
+        }
+
+        stats.nSuppressedCorners += vKeyPoints.size() - nKept;
+        vKeyPoints.resize(nKept);
+    }
+
+    /*
+    @brief 分數圖模式的第一階段：計算一個 Tile 內所有 pixel 的 FAST 分數並寫入分數圖，只會寫入該 Tile 自己的列
+    
+    @param[in] image 該層影像
+    @param[in] tile 要計算分數的 Tile
+    @param[in] fastDetector 該執行緒專用的 FAST 偵測器 */
+    void KeyPointExtractor::scoreTile(const Mat &image, const Tile &tile, FASTDetector &fastDetector) {
+        const LevelContext &context = mvLevelContexts[tile.iLevel];
+        const GridLayout &layout = context.layout;
+        Mat &scoreMap = mvScoreMaps[tile.iLevel];
+
+        // FAST 只會在距離提取範圍邊界 3 pixels 以內的地方找到角點
+        int iMinValidX = layout.iMinBorderX + 3, iMaxValidX = layout.iMaxBorderX - 3;
+        int iMinValidY = layout.iMinBorderY + 3, iMaxValidY = layout.iMaxBorderY - 3;
+
+        // 該 Tile 負責的 pixel 列，最後一個 Tile 一直延伸到提取範圍的底部
+        // 每個 Grid 的角點範圍和 Grid 模式相同，是 Grid 本身向右下平移 3 pixels，兩種模式才會在相同的 pixel 上決定閾值
+        int iMinY = iMinValidY + tile.iRowBegin * layout.iGridHeight;
+        int iMaxY = min(iMinValidY + tile.iRowEnd * layout.iGridHeight, iMaxValidY);
+        if(iMinY >= iMaxY || iMinValidX >= iMaxValidX) { return; }
+
+        // 該 Tile 的每個 pixel 只被測試一次
+        // 分數 >= t 的 pixel 就是閾值 t 下的角點，所以之後每個 Grid 的兩段式閾值只需要比較分數
+        if(!context.pCellStates) {
+            fastDetector.computeScores(image, scoreMap, Rect(iMinValidX, iMinY, iMaxValidX - iMinValidX, iMaxY - iMinY), context.iScoreTh);
+        }
+        else {
+            // 有遮罩時，每一列 Grid 只計算連續沒有被完全遮住的 Grid，被遮住的 Grid 在分數圖中一直保持 0
+            for(int iRow = tile.iRowBegin; iRow < tile.iRowEnd; iRow++) {
+                int iRowMinY = iMinValidY + iRow * layout.iGridHeight;
+                int iRowMaxY = min(iMinValidY + (iRow + 1) * layout.iGridHeight, iMaxValidY);
+                if(iRowMinY >= iRowMaxY) { continue; }
+
+                const uchar* pRowStates = context.pCellStates + iRow * layout.nCols;
+                for(int iCol = 0; iCol < layout.nCols;) {
+                    if(pRowStates[iCol] == CELL_MASKED) { iCol++; continue; }
+                    int iColEnd = iCol + 1;
+                    while(iColEnd < layout.nCols && pRowStates[iColEnd] != CELL_MASKED) { iColEnd++; }
+
+                    int iRunMinX = iMinValidX + iCol * layout.iGridWidth;
+                    int iRunMaxX = min(iMinValidX + iColEnd * layout.iGridWidth, iMaxValidX);
+                    if(iRunMinX < iRunMaxX)
+                        fastDetector.computeScores(image, scoreMap, Rect(iRunMinX, iRowMinY, iRunMaxX - iRunMinX, iRowMaxY - iRowMinY), context.iScoreTh);
+                    iCol = iColEnd;
+                }
+            }
+        }
+    }
+
+    /*
+    @brief 檢查一個 Grid 內是否有分數達到 iCellTh，而且在分數圖上通過非極大值抑制的角點
+    
+    @param[in] scoreMap 該層影像的分數圖
+    @param[in] cell Grid 內可能找到角點的範圍
+    @param[in] iCellTh 該 Grid 的閾值
+    @param[in] pMask 部分被遮住的 Grid 傳入遮罩，跳過落在被遮住的 pixel 上的角點，否則為 nullptr */
+    bool KeyPointExtractor::hasStrongCorner(const Mat &scoreMap, const Rect &cell, int iCellTh, const Mat* pMask) const {
+        for(int iY = cell.y; iY < cell.y + cell.height; iY++) {
+            const uchar* pPrev = scoreMap.ptr<uchar>(iY - 1);
+            const uchar* pCurr = scoreMap.ptr<uchar>(iY);
+            const uchar* pNext = scoreMap.ptr<uchar>(iY + 1);
+            const uchar* pMaskRow = pMask ? pMask->ptr<uchar>(iY) : nullptr;
+            for(int iX = cell.x; iX < cell.x + cell.width; iX++) {
+                int score = pCurr[iX];
+                if(score < iCellTh) { continue; }
+                if(pMaskRow && pMaskRow[iX] == 0) { continue; }
+                if(score > pPrev[iX - 1] && score > pPrev[iX] && score > pPrev[iX + 1] &&
+                   score > pCurr[iX - 1] && score > pCurr[iX + 1] &&
+                   score > pNext[iX - 1] && score > pNext[iX] && score > pNext[iX + 1]) { return true; }
+            }
+        }
+        return false;
+    }
+
+    /*
+    @brief 分數圖模式的第二階段：標記一個 Tile 內沒有角點達到自己閾值的 Grid，只會讀取分數圖
+    
+    @param[in] tile 要檢查的 Tile */
+    void KeyPointExtractor::markWeakCells(const Tile &tile) {
+        const LevelContext &context = mvLevelContexts[tile.iLevel];
+        const GridLayout &layout = context.layout;
+        const Mat &scoreMap = mvScoreMaps[tile.iLevel];
+
+        // FAST 只會在距離提取範圍邊界 3 pixels 以內的地方找到角點
+        int iMinValidX = layout.iMinBorderX + 3, iMaxValidX = layout.iMaxBorderX - 3;
+        int iMinValidY = layout.iMinBorderY + 3, iMaxValidY = layout.iMaxBorderY - 3;
+
+        for(int iRow = tile.iRowBegin; iRow < tile.iRowEnd; iRow++) {
+            int iCellMinY = iMinValidY + iRow * layout.iGridHeight;
+            int iCellMaxY = min(iMinValidY + (iRow + 1) * layout.iGridHeight, iMaxValidY);
+            if(iCellMinY >= iCellMaxY) { continue; }
+
+            for(int iCol = 0; iCol < layout.nCols; iCol++) {
+                int iCellMinX = iMinValidX + iCol * layout.iGridWidth;
+                int iCellMaxX = min(iMinValidX + (iCol + 1) * layout.iGridWidth, iMaxValidX);
+                if(iCellMinX >= iCellMaxX) { continue; }
+
+                uchar cellState = context.pCellStates ? context.pCellStates[iRow * layout.nCols + iCol] : (uchar)CELL_USABLE;
+                if(cellState == CELL_MASKED) { continue; }
+
+                // 和收集角點時使用相同的條件，被標記的 Grid 收集時一定會放寬標準
+                int iCellTh = context.pCellThresholds ? context.pCellThresholds[iRow * layout.nCols + iCol] : miMaxTh;
+                Rect cell(iCellMinX, iCellMinY, iCellMaxX - iCellMinX, iCellMaxY - iCellMinY);
+                context.pWeakCells[iRow * layout.nCols + iCol] =
+                    !hasStrongCorner(scoreMap, cell, iCellTh, cellState == CELL_PARTIAL ? context.pMask : nullptr);
+            }
+        }
+    }
+
+    /*
+    @brief 分數圖模式的第三階段：對一個 Tile 內被標記的 Grid 以 miMinTh 重新計算分數，只會寫入這些 Grid
+    
+    @param[in] image 該層影像
+    @param[in] tile 要重新計算分數的 Tile
+    @param[in] fastDetector 該執行緒專用的 FAST 偵測器 */
+    void KeyPointExtractor::rescoreWeakCells(const Mat &image, const Tile &tile, FASTDetector &fastDetector) {
+        const LevelContext &context = mvLevelContexts[tile.iLevel];
+        const GridLayout &layout = context.layout;
+        Mat &scoreMap = mvScoreMaps[tile.iLevel];
+
+        // FAST 只會在距離提取範圍邊界 3 pixels 以內的地方找到角點
+        int iMinValidX = layout.iMinBorderX + 3, iMaxValidX = layout.iMaxBorderX - 3;
+        int iMinValidY = layout.iMinBorderY + 3, iMaxValidY = layout.iMaxBorderY - 3;
+
+        for(int iRow = tile.iRowBegin; iRow < tile.iRowEnd; iRow++) {
+            int iCellMinY = iMinValidY + iRow * layout.iGridHeight;
+            int iCellMaxY = min(iMinValidY + (iRow + 1) * layout.iGridHeight, iMaxValidY);
+            if(iCellMinY >= iCellMaxY) { continue; }
+
+            for(int iCol = 0; iCol < layout.nCols; iCol++) {
+                int iCellMinX = iMinValidX + iCol * layout.iGridWidth;
+                int iCellMaxX = min(iMinValidX + (iCol + 1) * layout.iGridWidth, iMaxValidX);
+                if(iCellMinX >= iCellMaxX) { continue; }
+                if(!context.pWeakCells[iRow * layout.nCols + iCol]) { continue; }
+
+                fastDetector.computeScores(image, scoreMap, Rect(iCellMinX, iCellMinY, iCellMaxX - iCellMinX, iCellMaxY - iCellMinY), miMinTh);
+            }
+        }
+    }
+
+    /*
+    @brief 分數圖模式的最後階段：從整層的分數圖收集一個 Tile 內通過非極大值抑制的角點並依 Grid 分桶，
+    座標相對於 (iMinBorderX, iMinBorderY)
+    
+    @param[in, out] vKeyPoints 該 Tile 的關鍵點
+    @param[in] tile 要收集角點的 Tile
+    @param[in, out] stats 該 Tile 的提取統計 */
+    void KeyPointExtractor::collectFromScoreMap(vector<KeyPoint> &vKeyPoints, const Tile &tile, LevelStatistics &stats) {
+        const LevelContext &context = mvLevelContexts[tile.iLevel];
+        const GridLayout &layout = context.layout;
+        const Mat &scoreMap = mvScoreMaps[tile.iLevel];
+        uchar* pCellThresholds = context.pCellThresholds;
+
+        // FAST 只會在距離提取範圍邊界 3 pixels 以內的地方找到角點
+        int iMinValidX = layout.iMinBorderX + 3, iMaxValidX = layout.iMaxBorderX - 3;
+        int iMinValidY = layout.iMinBorderY + 3, iMaxValidY = layout.iMaxBorderY - 3;
+
+        // 收集一個 Grid 內通過非極大值抑制的角點，並回傳是否有角點達到 iCellTh
+        // 分數 >= iCellTh 的角點若在較低閾值下是局部最大值，在 iCellTh 下也一樣，反之亦然
+        // 所以兩種閾值都可以直接和分數圖上的 8 個鄰居比較，而且可以跨越 Grid 與 Tile 的邊界
+        // 部分被遮住的 Grid 傳入遮罩，跳過落在被遮住的 pixel 上的角點
+        auto collect = [&](int iMinX, int iMaxX, int iMinY, int iMaxY, int iCellTh, const Mat* pMask) {
+            bool bStrong = false;
+            for(int iY = iMinY; iY < iMaxY; iY++) {
+                const uchar* pPrev = scoreMap.ptr<uchar>(iY - 1);
+                const uchar* pCurr = scoreMap.ptr<uchar>(iY);
+                const uchar* pNext = scoreMap.ptr<uchar>(iY + 1);
+                const uchar* pMaskRow = pMask ? pMask->ptr<uchar>(iY) : nullptr;
+                for(int iX = iMinX; iX < iMaxX; iX++) {
+                    int score = pCurr[iX];
+                    if(score == 0) { continue; }
+                    if(pMaskRow && pMaskRow[iX] == 0) { continue; }
+                    if(!(score > pPrev[iX - 1] && score > pPrev[iX] && score > pPrev[iX + 1] &&
+                         score > pCurr[iX - 1] && score > pCurr[iX + 1] &&
+                         score > pNext[iX - 1] && score > pNext[iX] && score > pNext[iX + 1])) { continue; }
+
+                    bStrong |= (score >= iCellTh);
+                    vKeyPoints.emplace_back(
+                        float(iX - layout.iMinBorderX), float(iY - layout.iMinBorderY), 7.f, -1, (float)score
+                    );
+                }
+            }
+            return bStrong;
+        };
+
+        // 遍歷該 Tile 內的每個 Grid，每個 pixel 只屬於一個 Grid，Grid 之間不重疊
+        for(int iRow = tile.iRowBegin; iRow < tile.iRowEnd; iRow++) {
+            int iMinY = iMinValidY + iRow * layout.iGridHeight;
+            int iMaxY = min(iMinValidY + (iRow + 1) * layout.iGridHeight, iMaxValidY);
+            if(iMinY >= iMaxY) { continue; }
+
+            for(int iCol = 0; iCol < layout.nCols; iCol++) {
+                int iMinX = iMinValidX + iCol * layout.iGridWidth;
+                int iMaxX = min(iMinValidX + (iCol + 1) * layout.iGridWidth, iMaxValidX);
+                if(iMinX >= iMaxX) { continue; }
+
+                // 完全被遮住的 Grid 直接跳過，不計入統計
+                uchar cellState = context.pCellStates ? context.pCellStates[iRow * layout.nCols + iCol] : (uchar)CELL_USABLE;
+                if(cellState == CELL_MASKED) { continue; }
+
+                int iCellTh = pCellThresholds ? pCellThresholds[iRow * layout.nCols + iCol] : miMaxTh;
+                stats.nCells++;
+                stats.nThresholdSum += iCellTh;
+
+                // 收集該 Grid 內的角點，同時記錄是否有角點達到 iCellTh
+                size_t nBegin = vKeyPoints.size();
+                bool bStrong = collect(iMinX, iMaxX, iMinY, iMaxY, iCellTh, cellState == CELL_PARTIAL ? context.pMask : nullptr);
+
+                // 統計該 Grid 是否需要放寬標準，以及放寬後是否仍然沒有角點
+                // iCellTh 等於 miMinTh 時，沒有角點代表本來就找不到，不算放寬標準
+                if(!bStrong && iCellTh > miMinTh) { stats.nFallbackCells++; }
+                if(vKeyPoints.size() == nBegin) { stats.nEmptyCells++; }
+
+                // 如果有角點達到 iCellTh，就只保留這些角點；否則保留放寬標準後的所有角點
+                if(bStrong) {
+                    vKeyPoints.erase(
+                        remove_if(vKeyPoints.begin() + nBegin, vKeyPoints.end(),
+                            [iCellTh](const KeyPoint &keyPoint) { return keyPoint.response < iCellTh; }),
+                        vKeyPoints.end()
+                    );
+                }
+
+                // 根據在該 Grid 閾值下找到的角點數量，調整下一張影像使用的閾值
+                // 放寬標準的 Grid 視為找不到角點，讓閾值往下調整
+                if(pCellThresholds)
+                    adaptThreshold(pCellThresholds[iRow * layout.nCols + iCol], bStrong ? vKeyPoints.size() - nBegin : 0, context.nTarget);
             }
-            
-            // 儲存該層的 KeyPoints
-            vvKeyPointsPerLevel[iLevel] = vKeyPoints;
         }
     }
-}
\ No newline at end of file
+}
@@ -1,12 +1,121 @@
 #include "myORB-SLAM2/OrientationComputer.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ORIENTATION_COMPUTER_X86
+#endif
+
 namespace my_ORB_SLAM2 {
 
+#ifdef ORIENTATION_COMPUTER_X86
+
+/*
+@brief Intensity moments of a circular area, one row pair per iteration on 32 pixels from x = -15 to x = 16.
+Products are at most 255 * 15, so pairs of them fit in 16 bits, and the sums are exact integers.
+The 32nd pixel is read but has weight 0; keypoints stay far enough from the border for it to exist.
+
+@param[in] pCenter: The pointer to the center of the circular area.
+@param[in] nCols: Width of the image.
+@param[in] iRadius: Radius of the circular area.
+@param[in] pRowWeights: x weights of each row, zeroed outside the circle.
+@param[in] pRowMasks: 1 inside the circle on each row, 0 outside.
+@param[in, out] weightedSumX: Sum of intensities weighted by x.
+@param[in, out] weightedSumY: Sum of intensities weighted by y. */
+__attribute__((target("avx2")))
+static void computeMomentsAVX2(
+    const uchar* pCenter, int nCols, int iRadius, 
+    const int8_t (*pRowWeights)[32], const int8_t (*pRowMasks)[32],
+    int &weightedSumX, int &weightedSumY
+) {
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    // Center row: only the x moment.
+    __m256i center = _mm256_loadu_si256((const __m256i*)(pCenter - 15));
+    __m256i sumX = _mm256_madd_epi16(_mm256_maddubs_epi16(center, _mm256_load_si256((const __m256i*)pRowWeights[0])), ones);
+    __m256i sumY = _mm256_setzero_si256();
+
+    for(int iY = 1; iY <= iRadius; ++iY) {
+        int nMove = nCols * iY;
+        __m256i up = _mm256_loadu_si256((const __m256i*)(pCenter + nMove - 15));
+        __m256i down = _mm256_loadu_si256((const __m256i*)(pCenter - nMove - 15));
+        __m256i weights = _mm256_load_si256((const __m256i*)pRowWeights[iY]);
+        __m256i mask = _mm256_load_si256((const __m256i*)pRowMasks[iY]);
+
+        // x * (up + down), summed in pairs into 16 bits, then into 32 bits.
+        __m256i x = _mm256_add_epi16(_mm256_maddubs_epi16(up, weights), _mm256_maddubs_epi16(down, weights));
+        sumX = _mm256_add_epi32(sumX, _mm256_madd_epi16(x, ones));
+
+        // iY * (up - down) over the pixels inside the circle.
+        __m256i y = _mm256_sub_epi16(_mm256_maddubs_epi16(up, mask), _mm256_maddubs_epi16(down, mask));
+        sumY = _mm256_add_epi32(sumY, _mm256_madd_epi16(y, _mm256_set1_epi16((short)iY)));
+    }
+
+    // Horizontal sums of the 8 lanes.
+    __m256i sums = _mm256_hadd_epi32(sumX, sumY);
+    sums = _mm256_hadd_epi32(sums, sums);
+    __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    weightedSumX = _mm_cvtsi128_si32(total);
+    weightedSumY = _mm_extract_epi32(total, 1);
+}
+
+#endif // ORIENTATION_COMPUTER_X86
+
 /*
 @brief Before calculating orientation, it’s important to set a radius.
+The best kernel the CPU supports is used.
 
-@param[in] iRadius: Radius of the circular area. */
-OrientationComputer::OrientationComputer(int iRadius): miRadius(iRadius) {}
+@param[in] iRadius: Radius of the circular area, at most 15. */
+OrientationComputer::OrientationComputer(int iRadius): meInstruction(detectInstruction()), miRadius(iRadius) {
+    initRowWeights();
+}
+
+/*
+@brief Orientation computer forced onto a specific kernel.
+
+@param[in] iRadius: Radius of the circular area, at most 15.
+@param[in] eInstruction: Instruction set to use; it must be supported by this CPU. */
+OrientationComputer::OrientationComputer(int iRadius, Instruction eInstruction): meInstruction(eInstruction), miRadius(iRadius) {
+    CV_Assert(isSupported(eInstruction));
+    initRowWeights();
+}
+
+/*
+@brief Query CPUID once and return the widest supported instruction set. */
+OrientationComputer::Instruction OrientationComputer::detectInstruction() {
+    static const Instruction eInstruction = isSupported(AVX2) ? AVX2 : SCALAR;
+    return eInstruction;
+}
+
+/*
+@brief Check whether this CPU can run a given kernel.
+
+@param[in] eInstruction: Instruction set to check. */
+bool OrientationComputer::isSupported(Instruction eInstruction) {
+#ifdef ORIENTATION_COMPUTER_X86
+    __builtin_cpu_init();
+    switch(eInstruction) {
+        case SCALAR: return true;
+        case AVX2: return __builtin_cpu_supports("avx2");
+    }
+    return false;
+#else
+    return eInstruction == SCALAR;
+#endif
+}
+
+/*
+@brief Fill the per-row x weights and masks of the SIMD kernel from nHalfPointsPerY. */
+void OrientationComputer::initRowWeights() {
+    CV_Assert(miRadius >= 0 && miRadius <= 15);
+    for(int iY = 0; iY <= 15; ++iY) {
+        for(int i = 0; i < 32; ++i) {
+            int iX = i - 15;
+            bool bInside = abs(iX) <= nHalfPointsPerY[iY];
+            mRowWeights[iY][i] = bInside ? (int8_t)iX : 0;
+            mRowMasks[iY][i] = bInside ? 1 : 0;
+        }
+    }
+}
 
 /*
 @brief Compute a keypoint's orientation.
@@ -17,8 +126,8 @@ inline float OrientationComputer::getOrientation(KeyPoint &keyPoint, const Mat &
     // Get the pointer to the center of the circular area.
     const uchar* pCenter = &image.at<uchar>(keyPoint.pt.y, keyPoint.pt.x);
 
-    // Width of the image.
-    int nCols = image.cols;
+    // Bytes per image row, which is larger than the width for the levels of a padded pyramid.
+    int nCols = (int)image.step;
 
     // Sum of weighted coordinates.
     int weightedSumY = 0;
@@ -56,6 +165,31 @@ inline float OrientationComputer::getOrientation(KeyPoint &keyPoint, const Mat &
     return fastAtan2(weightedSumY, weightedSumX);
 }
 
+/*
+@brief Compute a keypoint's orientation with the AVX2 kernel; the moments are exactly those of getOrientation.
+
+@param[in] keyPoint: The target keypoint.
+@param[in] image: The image that contains the keypoint. */
+inline float OrientationComputer::getOrientationAVX2(KeyPoint &keyPoint, const Mat &image) {
+#ifdef ORIENTATION_COMPUTER_X86
+    const uchar* pCenter = &image.at<uchar>(keyPoint.pt.y, keyPoint.pt.x);
+    int weightedSumX, weightedSumY;
+    computeMomentsAVX2(pCenter, (int)image.step, miRadius, mRowWeights, mRowMasks, weightedSumX, weightedSumY);
+    return fastAtan2(weightedSumY, weightedSumX);
+#else
+    return getOrientation(keyPoint, image);
+#endif
+}
+
+/*
+@brief Compute a keypoint's orientation with the kernel of this computer, one keypoint at a time.
+
+@param[in] keyPoint: The target keypoint.
+@param[in] image: The image that contains the keypoint. */
+float OrientationComputer::computeOrientation(KeyPoint &keyPoint, const Mat &image) {
+    return meInstruction == AVX2 ? getOrientationAVX2(keyPoint, image) : getOrientation(keyPoint, image);
+}
+
 /*
 @brief Compute orientation for each keypoint from an image pyramid.
 
@@ -75,8 +209,14 @@ void OrientationComputer::compute(
         int nKeyPoints = vKeyPoints.size();
 
         // Compute the orientation for each keypoint.
-        for(int i = 0; i < nKeyPoints; ++i) 
-            vKeyPoints[i].angle = getOrientation(vKeyPoints[i], image);
+        if(meInstruction == AVX2) {
+            for(int i = 0; i < nKeyPoints; ++i) 
+                vKeyPoints[i].angle = getOrientationAVX2(vKeyPoints[i], image);
+        }
+        else {
+            for(int i = 0; i < nKeyPoints; ++i) 
+                vKeyPoints[i].angle = getOrientation(vKeyPoints[i], image);
+        }
     }
 }
 
@@ -2,126 +2,158 @@
 
 namespace my_ORB_SLAM2 {
     /*
-    @brief 設定關鍵點區域四叉樹 
+    @brief 以一組新的關鍵點重新建立四叉樹，只剩下包含所有關鍵點的根節點
     
-    @param[in] iWidth 影像寬度 
-    @param[in] iHeight 影像高度 
+    @param[in] area 根節點的框框
     @param[in] vKeyPoints 關鍵點 */
-    RegionalQuadTree::RegionalQuadTree(int iWidth, int iHeight, vector<KeyPoint> &vKeyPoints):
-    mvKeyPoints(vKeyPoints) {
+    void RegionalQuadTree::reset(const Rect &area, vector<KeyPoint> &vKeyPoints) {
+        // 清除上一次使用的所有節點，保留記憶體空間
+        mvNodes.clear();
+        miHead = -1;
+        mnNodes = 0;
+
+        // 把所有關鍵點指標儲存到四叉樹，沿用上一次配置的記憶體空間
+        mvpKeyPoints.clear();
+        for (KeyPoint &keyPoint : vKeyPoints) {
+            mvpKeyPoints.push_back(&keyPoint);
+        }
+
         // 取得總體的關鍵點數量
-        int nKeyPoints = mvKeyPoints.size();
+        int nKeyPoints = mvpKeyPoints.size();
         
         // 如果至少有一個關鍵點
         if(nKeyPoints >= 1) {
             // 設定該四叉樹的第一個 Node
-            mlNodes.resize(1);
-            RegionalQuadTreeNode &node = mlNodes.front();
+            RegionalQuadTreeNode node;
 
             // 設定該 Node 的 Box 座標
-            node.miMinX = 0;
-            node.miMinY = 0;
-            node.miMaxX = iWidth;
-            node.miMaxY = iHeight;
-            node.miMidX = int(0.5 * (float)iWidth);
-            node.miMidY = int(0.5 * (float)iHeight);
+            node.miMinX = area.x;
+            node.miMinY = area.y;
+            node.miMaxX = area.x + area.width;
+            node.miMaxY = area.y + area.height;
+            node.miMidX = area.x + int(0.5 * (float)area.width);
+            node.miMidY = area.y + int(0.5 * (float)area.height);
 
-            // 設定該 Node 的關鍵點容量
-            node.mvpKeyPoints.reserve(nKeyPoints);
-
-            // 把所有關鍵點指標儲存到 Node
-            for (KeyPoint &keyPoint : mvKeyPoints) {
-                node.mvpKeyPoints.push_back(&keyPoint);
-            }
+            // 根節點擁有所有關鍵點
+            node.miBegin = 0;
+            node.miEnd = nKeyPoints;
 
             // 檢查關鍵點數是否等於 1，等於 1 的話就封鎖
             node.mbLocked = (nKeyPoints == 1);
+            pushFront(node);
         }
     }
 
     /*
-    @brief 根據指定的迭代器，分裂對應的節點 
+    @brief 在節點串列的最前面加入一個節點
+    
+    @param[in] node 要加入的節點 */
+    void RegionalQuadTree::pushFront(const RegionalQuadTreeNode &node) {
+        int iNode = mvNodes.size();
+        mvNodes.push_back(node);
+        mvNodes[iNode].miPrev = -1;
+        mvNodes[iNode].miNext = miHead;
+        if(miHead != -1) { mvNodes[miHead].miPrev = iNode; }
+        miHead = iNode;
+        mnNodes++;
+    }
+
+    /*
+    @brief 把一個節點從節點串列中移除
+    
+    @param[in] iNode 要移除的節點的索引 */
+    void RegionalQuadTree::unlink(int iNode) {
+        RegionalQuadTreeNode &node = mvNodes[iNode];
+        if(node.miPrev != -1) { mvNodes[node.miPrev].miNext = node.miNext; }
+        else { miHead = node.miNext; }
+        if(node.miNext != -1) { mvNodes[node.miNext].miPrev = node.miPrev; }
+        mnNodes--;
+    }
+
+    /*
+    @brief 根據指定的索引，分裂對應的節點，子節點會加在節點串列的最前面
         
-    @param[in] lNodesIterator 指定要分裂的節點的迭代器 */
-    list<RegionalQuadTreeNode>::iterator 
-    RegionalQuadTree::divide(list<RegionalQuadTreeNode>::iterator &lNodesIterator) {
+    @param[in] iNode 指定要分裂的節點的索引
+    @return 節點串列中原本位於該節點之後的節點索引 */
+    int RegionalQuadTree::divide(int iNode) {
+        // 加入子節點時 mvNodes 可能重新配置，所以先複製父節點
+        const RegionalQuadTreeNode parent = mvNodes[iNode];
+
         // 如果該 Node 只有一個關鍵點，就直接去下一個 Node
-        if(lNodesIterator->mbLocked) { return ++lNodesIterator; }
+        if(parent.mbLocked) { return parent.miNext; }
         
         // 根據父節點座標分割出四個子傑點，並計算它們的 Box 座標
         RegionalQuadTreeNode node00, node01, node10, node11;
-        node00.miMinX = lNodesIterator->miMinX; 
-        node00.miMinY = lNodesIterator->miMinY; 
-        node00.miMaxX = lNodesIterator->miMidX; 
-        node00.miMaxY = lNodesIterator->miMidY; 
+        node00.miMinX = parent.miMinX; 
+        node00.miMinY = parent.miMinY; 
+        node00.miMaxX = parent.miMidX; 
+        node00.miMaxY = parent.miMidY; 
         node00.miMidX = int((float)(node00.miMaxX + node00.miMinX) * 0.5);
         node00.miMidY = int((float)(node00.miMaxY + node00.miMinY) * 0.5);
 
-        node01.miMinX = lNodesIterator->miMidX; 
-        node01.miMinY = lNodesIterator->miMinY; 
-        node01.miMaxX = lNodesIterator->miMaxX; 
-        node01.miMaxY = lNodesIterator->miMidY; 
+        node01.miMinX = parent.miMidX; 
+        node01.miMinY = parent.miMinY; 
+        node01.miMaxX = parent.miMaxX; 
+        node01.miMaxY = parent.miMidY; 
         node01.miMidX = int((float)(node01.miMaxX + node01.miMinX) * 0.5);
         node01.miMidY = int((float)(node01.miMaxY + node01.miMinY) * 0.5);
 
-        node10.miMinX = lNodesIterator->miMinX; 
-        node10.miMinY = lNodesIterator->miMidY; 
-        node10.miMaxX = lNodesIterator->miMidX; 
-        node10.miMaxY = lNodesIterator->miMaxY; 
+        node10.miMinX = parent.miMinX; 
+        node10.miMinY = parent.miMidY; 
+        node10.miMaxX = parent.miMidX; 
+        node10.miMaxY = parent.miMaxY; 
         node10.miMidX = int((float)(node10.miMaxX + node10.miMinX) * 0.5);
         node10.miMidY = int((float)(node10.miMaxY + node10.miMinY) * 0.5);
 
-        node11.miMinX = lNodesIterator->miMidX; 
-        node11.miMinY = lNodesIterator->miMidY; 
-        node11.miMaxX = lNodesIterator->miMaxX; 
-        node11.miMaxY = lNodesIterator->miMaxY; 
+        node11.miMinX = parent.miMidX; 
+        node11.miMinY = parent.miMidY; 
+        node11.miMaxX = parent.miMaxX; 
+        node11.miMaxY = parent.miMaxY; 
         node11.miMidX = int((float)(node11.miMaxX + node11.miMinX) * 0.5);
         node11.miMidY = int((float)(node11.miMaxY + node11.miMinY) * 0.5);
 
-        // 預先分配 4 個子 Node 的關鍵點容量，避免後續動態擴增造成的性能消耗
-        int nKeyPoints = lNodesIterator->mvpKeyPoints.size();
-        node00.mvpKeyPoints.reserve(nKeyPoints);
-        node01.mvpKeyPoints.reserve(nKeyPoints);
-        node10.mvpKeyPoints.reserve(nKeyPoints);
-        node11.mvpKeyPoints.reserve(nKeyPoints);
-        
-        // 把父 Node 的所有關鍵點，依照父 Node 中心點座標，分配給 4 個子 Node
-        int iMidX, iMidY;
-        iMidX = lNodesIterator->miMidX;
-        iMidY = lNodesIterator->miMidY;
-        for(KeyPoint* &keyPoint : lNodesIterator->mvpKeyPoints) {
-            if(keyPoint->pt.x < iMidX && keyPoint->pt.y < iMidY) {
-                node00.mvpKeyPoints.push_back(keyPoint);
-            }
-            else if(keyPoint->pt.x >= iMidX && keyPoint->pt.y < iMidY) {
-                node01.mvpKeyPoints.push_back(keyPoint);
-            }
-            else if(keyPoint->pt.x < iMidX && keyPoint->pt.y >= iMidY) {
-                node10.mvpKeyPoints.push_back(keyPoint);
-            }
-            else { node11.mvpKeyPoints.push_back(keyPoint); }
-        }
+        // 把父 Node 的所有關鍵點，依照父 Node 中心點座標，就地分成上下兩半，再把兩半各自分成左右兩半
+        // 4 個子 Node 各自擁有父 Node 範圍中連續的一段，不需要另外配置記憶體
+        float fMidX = (float)parent.miMidX;
+        float fMidY = (float)parent.miMidY;
+        vector<KeyPoint*>::iterator vitBegin = mvpKeyPoints.begin() + parent.miBegin;
+        vector<KeyPoint*>::iterator vitEnd = mvpKeyPoints.begin() + parent.miEnd;
+        vector<KeyPoint*>::iterator vitMidY = partition(vitBegin, vitEnd, [fMidY](const KeyPoint* pKeyPoint) { return pKeyPoint->pt.y < fMidY; });
+        vector<KeyPoint*>::iterator vitMidX0 = partition(vitBegin, vitMidY, [fMidX](const KeyPoint* pKeyPoint) { return pKeyPoint->pt.x < fMidX; });
+        vector<KeyPoint*>::iterator vitMidX1 = partition(vitMidY, vitEnd, [fMidX](const KeyPoint* pKeyPoint) { return pKeyPoint->pt.x < fMidX; });
+
+        node00.miBegin = parent.miBegin;
+        node00.miEnd = vitMidX0 - mvpKeyPoints.begin();
+        node01.miBegin = node00.miEnd;
+        node01.miEnd = vitMidY - mvpKeyPoints.begin();
+        node10.miBegin = node01.miEnd;
+        node10.miEnd = vitMidX1 - mvpKeyPoints.begin();
+        node11.miBegin = node10.miEnd;
+        node11.miEnd = parent.miEnd;
 
         // 設定，如果 Node 的關鍵點數為 1，則不可分裂 (封鎖)
-        node00.mbLocked = (node00.mvpKeyPoints.size() == 1);
-        node01.mbLocked = (node01.mvpKeyPoints.size() == 1);
-        node10.mbLocked = (node10.mvpKeyPoints.size() == 1);
-        node11.mbLocked = (node11.mvpKeyPoints.size() == 1);
+        node00.mbLocked = (node00.size() == 1);
+        node01.mbLocked = (node01.size() == 1);
+        node10.mbLocked = (node10.size() == 1);
+        node11.mbLocked = (node11.size() == 1);
+
+        // 先把父 Node 從串列中移除，它在陣列中的位置不再使用
+        unlink(iNode);
         
-        // 如果 Node 的關鍵點數大於 0，就儲存到 Node List 中
-        if(node00.mvpKeyPoints.size() > 0)
-            mlNodes.push_front(node00);
+        // 如果 Node 的關鍵點數大於 0，就儲存到 Node 串列中
+        if(node00.size() > 0)
+            pushFront(node00);
         
-        if(node01.mvpKeyPoints.size() > 0)
-            mlNodes.push_front(node01);
+        if(node01.size() > 0)
+            pushFront(node01);
 
-        if(node10.mvpKeyPoints.size() > 0)
-            mlNodes.push_front(node10);
+        if(node10.size() > 0)
+            pushFront(node10);
 
-        if(node11.mvpKeyPoints.size() > 0)
-            mlNodes.push_front(node11);
+        if(node11.size() > 0)
+            pushFront(node11);
 
-        // 返回下一個迭代器
-        return mlNodes.erase(lNodesIterator);
+        // 返回下一個節點
+        return parent.miNext;
     }
-}
\ No newline at end of file
+}
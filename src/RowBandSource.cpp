@@ -0,0 +1,103 @@
+#include "myORB-SLAM2/RowBandSource.h"
+
+#include <cctype>
+
+namespace my_ORB_SLAM2 {
+
+/*
+@brief Read the next number of a PGM header, skipping whitespace and comments.
+
+@param[in] pFile: The PGM file.
+@param[in, out] nValue: The number. */
+static bool readHeaderValue(FILE* pFile, int& nValue) {
+    int c = fgetc(pFile);
+    while(c == '#' || isspace(c)) {
+        if(c == '#')
+            while(c != '\n' && c != EOF) { c = fgetc(pFile); }
+        c = fgetc(pFile);
+    }
+    if(c == EOF) { return false; }
+    ungetc(c, pFile);
+    return fscanf(pFile, "%d", &nValue) == 1;
+}
+
+/*
+@brief Open an image and start the simulated exposure.
+
+@param[in] filePath: The binary PGM file.
+@param[in] nBandRows: The number of rows delivered at once.
+@param[in] dLinePeriod: The time between two lines in microseconds, 0 to deliver the bands as fast as they are read. */
+bool RowBandSource::open(const string& filePath, int nBandRows, double dLinePeriod) {
+    close();
+    mpFile = fopen(filePath.c_str(), "rb");
+    if(!mpFile) { return false; }
+
+    // "P5", width, height and a maximum value below 256, then a single whitespace before the pixels.
+    char magic[3] = {0};
+    int nMaxValue = 0;
+    bool bValid = fread(magic, 1, 2, mpFile) == 2 && magic[0] == 'P' && magic[1] == '5' &&
+                  readHeaderValue(mpFile, mnCols) && readHeaderValue(mpFile, mnRows) && readHeaderValue(mpFile, nMaxValue) &&
+                  mnCols > 0 && mnRows > 0 && nMaxValue > 0 && nMaxValue < 256 && isspace(fgetc(mpFile));
+    if(!bValid) {
+        close();
+        return false;
+    }
+
+    mnBandRows = max(nBandRows, 1);
+    mdLinePeriod = max(dLinePeriod, 0.0);
+    mnDeliveredRows = 0;
+    if(mBuffer.rows < mnBandRows || mBuffer.cols != mnCols)
+        mBuffer.create(mnBandRows, mnCols, CV_8U);
+
+    mStartTime = chrono::steady_clock::now();
+    mBandTime = mStartTime;
+    return true;
+}
+
+/*
+@brief Close the file. */
+void RowBandSource::close() {
+    if(mpFile) { fclose(mpFile); }
+    mpFile = nullptr;
+}
+
+/*
+@brief Read the next band, waiting for its last line to arrive.
+
+@param[in, out] band: The rows of the band, pointing into a buffer of the source that the next band overwrites. */
+bool RowBandSource::nextBand(Mat& band) {
+    if(!mpFile || mnDeliveredRows >= mnRows) { return false; }
+
+    int nRows = min(mnBandRows, mnRows - mnDeliveredRows);
+    for(int iY = 0; iY < nRows; iY++)
+        if(fread(mBuffer.ptr<uchar>(iY), 1, mnCols, mpFile) != (size_t)mnCols) { return false; }
+    mnDeliveredRows += nRows;
+
+    // The band is complete once its last line has arrived.
+    if(mdLinePeriod > 0.0) {
+        chrono::steady_clock::time_point arrival =
+            mStartTime + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, micro>(mnDeliveredRows * mdLinePeriod));
+        this_thread::sleep_until(arrival);
+    }
+    mBandTime = chrono::steady_clock::now();
+
+    band = mBuffer.rowRange(0, nRows);
+    return true;
+}
+
+/*
+@brief Write an 8-bit image as a binary PGM file that open accepts.
+
+@param[in] filePath: The PGM file.
+@param[in] image: The 8-bit image. */
+bool RowBandSource::savePGM(const string& filePath, const Mat& image) {
+    FILE* pFile = fopen(filePath.c_str(), "wb");
+    if(!pFile) { return false; }
+
+    bool bWritten = fprintf(pFile, "P5\n%d %d\n255\n", image.cols, image.rows) > 0;
+    for(int iY = 0; iY < image.rows && bWritten; iY++)
+        bWritten = fwrite(image.ptr<uchar>(iY), 1, image.cols, pFile) == (size_t)image.cols;
+    return fclose(pFile) == 0 && bWritten;
+}
+
+} // my_ORB_SLAM2
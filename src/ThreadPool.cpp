@@ -0,0 +1,92 @@
+#include "myORB-SLAM2/ThreadPool.h"
+
+namespace my_ORB_SLAM2 {
+
+/*
+@brief A fixed set of worker threads that stay alive between calls to run().
+
+@param[in] nWorkers: Number of worker threads. The thread calling run() also takes tasks. */
+ThreadPool::ThreadPool(int nWorkers): mnNextTask(0) {
+    nWorkers = max(nWorkers, 0);
+    mnThreads = nWorkers + 1;
+
+    // Thread 0 is the caller of run(), workers are numbered from 1.
+    mvWorkers.reserve(nWorkers);
+    for(int iThread = 1; iThread <= nWorkers; ++iThread)
+        mvWorkers.emplace_back(&ThreadPool::work, this, iThread);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(mMutex);
+        mbStop = true;
+    }
+    mcvStart.notify_all();
+
+    for(thread &worker : mvWorkers)
+        worker.join();
+}
+
+/*
+@brief Publish a batch of tasks to the workers, take tasks on this thread, and wait for the batch.
+
+@param[in] nTasks: Number of tasks.
+@param[in] pfTask: Function executing one task.
+@param[in] pContext: Callable object passed to pfTask. */
+void ThreadPool::dispatch(int nTasks, void (*pfTask)(void*, int, int), void* pContext) {
+    if(nTasks <= 0) { return; }
+
+    // Publish the batch. Workers only read it after taking the lock, so plain fields are enough.
+    {
+        lock_guard<mutex> lock(mMutex);
+        mpfTask = pfTask;
+        mpContext = pContext;
+        mnTasks = nTasks;
+        mnNextTask.store(0);
+        mnBusyWorkers = mvWorkers.size();
+        ++mnGeneration;
+    }
+    mcvStart.notify_all();
+
+    // The calling thread works too instead of sleeping.
+    drain(0);
+
+    // Every worker has to acknowledge the batch before it can be replaced by the next one.
+    unique_lock<mutex> lock(mMutex);
+    mcvDone.wait(lock, [this]() { return mnBusyWorkers == 0; });
+}
+
+/*
+@brief Take tasks from the current batch until none is left.
+
+@param[in] iThread: Index of the thread taking the tasks. */
+void ThreadPool::drain(int iThread) {
+    int iTask;
+    while((iTask = mnNextTask.fetch_add(1)) < mnTasks)
+        mpfTask(mpContext, iTask, iThread);
+}
+
+/*
+@brief Main loop of a worker thread.
+
+@param[in] iThread: Index of the worker (1 ~ mnThreads-1). */
+void ThreadPool::work(int iThread) {
+    unsigned long nSeenGeneration = 0;
+    while(true) {
+        // Sleep until a new batch is published or the pool is destroyed.
+        {
+            unique_lock<mutex> lock(mMutex);
+            mcvStart.wait(lock, [&]() { return mbStop || mnGeneration != nSeenGeneration; });
+            if(mbStop) { return; }
+            nSeenGeneration = mnGeneration;
+        }
+
+        drain(iThread);
+
+        // The last worker to finish wakes up the caller of run().
+        lock_guard<mutex> lock(mMutex);
+        if(--mnBusyWorkers == 0) { mcvDone.notify_one(); }
+    }
+}
+
+} // my_ORB_SLAM2
@@ -0,0 +1,71 @@
+#ifndef TESTIMAGES_H
+#define TESTIMAGES_H
+
+#include <opencv2/opencv.hpp>
+#include <random>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+/*
+@brief Synthetic textured images: a sine pattern whose phase changes from image to image, plus noise.
+The noise comes from one generator seeded with 0, so every call returns the same images.
+
+@param[in] nImages: The number of images.
+@return The images, 1241 x 376 like a KITTI frame. */
+inline vector<Mat> createSyntheticImages(int nImages) {
+    vector<Mat> vImages;
+    std::mt19937 rng(0);
+    for(int i = 0; i < nImages; i++) {
+        Mat image(376, 1241, CV_8U);
+        for(int iY = 0; iY < image.rows; iY++)
+            for(int iX = 0; iX < image.cols; iX++)
+                image.at<uchar>(iY, iX) = (uchar)(128 + 80 * sin(iX * 0.05 + i) * cos(iY * 0.07) + rng() % 40);
+        vImages.push_back(image);
+    }
+    return vImages;
+}
+
+/*
+@brief Test images: optional frames from an image sequence, otherwise synthetic textured images.
+
+@param[in] argc, argv: The arguments of the test. argv[1], if given, is a directory holding 000000.png, 000001.png, ...
+@param[in] nMaxSequenceImages: The maximum number of frames read from the sequence.
+@param[in] nSyntheticImages: The number of synthetic images used when no frame could be read.
+@return The images. */
+inline vector<Mat> loadTestImages(int argc, char **argv, int nMaxSequenceImages, int nSyntheticImages) {
+    vector<Mat> vImages;
+    if(argc > 1) {
+        string dirPath = argv[1];
+        for(int i = 0; i < nMaxSequenceImages; i++) {
+            std::ostringstream ss;
+            ss << std::setw(6) << std::setfill('0') << i << ".png";
+            Mat image = imread(dirPath + "/" + ss.str(), 0);
+            if(!image.empty()) { vImages.push_back(image); }
+        }
+    }
+    if(vImages.empty()) { vImages = createSyntheticImages(nSyntheticImages); }
+    return vImages;
+}
+
+/*
+@brief Whether two sets of keypoints are the same.
+
+@param[in] vvA, vvB: The keypoints of each level.
+@return The number of keypoints that differ in position or response. A level of a different size counts as a whole. */
+inline long countMismatches(const vector<vector<KeyPoint>>& vvA, const vector<vector<KeyPoint>>& vvB) {
+    long nMismatches = 0;
+    for(size_t iLevel = 0; iLevel < vvA.size(); iLevel++) {
+        const vector<KeyPoint> &vA = vvA[iLevel], &vB = vvB[iLevel];
+        if(vA.size() != vB.size()) { nMismatches += max(vA.size(), vB.size()); continue; }
+        for(size_t i = 0; i < vA.size(); i++)
+            nMismatches += vA[i].pt.x != vB[i].pt.x || vA[i].pt.y != vB[i].pt.y || vA[i].response != vB[i].response;
+    }
+    return nMismatches;
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/FramePool.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+Counting allocator: every heap allocation of the process goes through these functions,
+including operator new (libstdc++) and cv::fastMalloc (posix_memalign), on every thread.
+They forward to the glibc implementation and count calls while counting is enabled. */
+extern "C" {
+    void* __libc_malloc(size_t nSize);
+    void* __libc_calloc(size_t nItems, size_t nSize);
+    void* __libc_realloc(void* p, size_t nSize);
+    void* __libc_memalign(size_t nAlignment, size_t nSize);
+    void* __libc_valloc(size_t nSize);
+    void* __libc_pvalloc(size_t nSize);
+    void __libc_free(void* p);
+}
+
+static atomic<bool> gbCounting(false);
+static atomic<long> gnAllocations(0);
+
+static inline void countAllocation() {
+    if(gbCounting.load(memory_order_relaxed)) { gnAllocations.fetch_add(1, memory_order_relaxed); }
+}
+
+extern "C" {
+    void* malloc(size_t nSize) { countAllocation(); return __libc_malloc(nSize); }
+    void* calloc(size_t nItems, size_t nSize) { countAllocation(); return __libc_calloc(nItems, nSize); }
+    void* realloc(void* p, size_t nSize) { countAllocation(); return __libc_realloc(p, nSize); }
+    void* memalign(size_t nAlignment, size_t nSize) { countAllocation(); return __libc_memalign(nAlignment, nSize); }
+    void* aligned_alloc(size_t nAlignment, size_t nSize) { countAllocation(); return __libc_memalign(nAlignment, nSize); }
+    void* valloc(size_t nSize) { countAllocation(); return __libc_valloc(nSize); }
+    void* pvalloc(size_t nSize) { countAllocation(); return __libc_pvalloc(nSize); }
+    int posix_memalign(void** pp, size_t nAlignment, size_t nSize) {
+        countAllocation();
+        *pp = __libc_memalign(nAlignment, nSize);
+        return *pp ? 0 : 12; // ENOMEM
+    }
+    void free(void* p) { __libc_free(p); }
+}
+
+/*
+@brief Run a stage and return how many heap allocations it made.
+
+@param[in] stage: The stage to run. */
+template<typename Stage>
+long countAllocations(Stage &&stage) {
+    gnAllocations.store(0);
+    gbCounting.store(true);
+    stage();
+    gbCounting.store(false);
+    return gnAllocations.load();
+}
+
+int main(int argc, char **argv) {
+    // Test images: optional frames from an image sequence, otherwise synthetic textured images.
+    // Buffers are sized by the image size and by the most corners an image of that size can have, never by the
+    // content of earlier frames. The first half warms them up and allocations are counted on the second half only,
+    // so a frame with more corners than any warm-up frame must not allocate either.
+    vector<Mat> vImages = loadTestImages(argc, argv, 40, 20);
+    int nWarmUpImages = vImages.size() / 2;
+
+    const char* pStageNames[] = {"ImagePyramid", "KeyPointExtractor", "Distributor", "OrientationComputer", "DescriptorComputer", "DescriptorComputer::describe", "FramePool::acquire"};
+    const char* pModeNames[] = {"GRID_FAST", "SCORE_MAP"};
+    long nTotalAllocations = 0;
+
+    for(KeyPointExtractor::Mode mode : {KeyPointExtractor::GRID_FAST, KeyPointExtractor::SCORE_MAP}) {
+        // Same configuration as testFrame_00, with a worker pool so that worker threads are counted too.
+        ImagePyramid imagePyramid(3, 1.2, 1200);
+        imagePyramid.enableBlurredPyramid();
+        KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7, mode);
+        keyPointExtractor.setThreads(4);
+        Distributor distributor;
+        OrientationComputer orientationComputer(15);
+        DescriptorComputer descriptorComputer;
+
+        // GaussianBlur allocates its own buffers, so both blurs use the fixed-point filter, which does not.
+        imagePyramid.setFixedPointBlur(true);
+        descriptorComputer.setFixedPointBlur(true);
+
+        // Output containers are owned by the caller and reused for every frame.
+        vector<vector<KeyPoint>> vvKeyPointsPerLevel;
+        vector<vector<KeyPoint>> vvDistributedKeyPointsPerLevel;
+        vector<vector<Descriptor>> vvDescriptorsPerLevel;
+
+        // Frames come from a pool and only the last few are kept, as a tracker keeps its recent frames.
+        FramePool framePool;
+        FramePtr recentFrames[5];
+        int iFrame = 0;
+
+        // The warm-up frames grow every buffer to its steady-state size, the other frames must not allocate.
+        long nAllocationsPerStage[7] = {0, 0, 0, 0, 0, 0, 0};
+        for(int iImage = 0; iImage < (int)vImages.size(); iImage++) {
+            const Mat &image = vImages[iImage];
+            long nAllocations[7];
+            nAllocations[0] = countAllocations([&]() { imagePyramid.setImage(image); });
+            nAllocations[1] = countAllocations([&]() { keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages); });
+            nAllocations[2] = countAllocations([&]() {
+                distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+            });
+            nAllocations[3] = countAllocations([&]() { orientationComputer.compute(vvDistributedKeyPointsPerLevel, imagePyramid.mvImages); });
+            nAllocations[4] = countAllocations([&]() { descriptorComputer.computeBlurred(vvDescriptorsPerLevel, vvDistributedKeyPointsPerLevel, imagePyramid.mvBlurredImages); });
+            nAllocations[5] = countAllocations([&]() {
+                descriptorComputer.describe(vvDescriptorsPerLevel, vvDistributedKeyPointsPerLevel, imagePyramid.mvImages, imagePyramid.mvBlurredImages, orientationComputer);
+            });
+            nAllocations[6] = countAllocations([&]() {
+                recentFrames[iFrame++ % 5] = framePool.acquire(image.size(), imagePyramid.mvfScaleFactors, vvDistributedKeyPointsPerLevel, vvDescriptorsPerLevel);
+            });
+
+            if(iImage >= nWarmUpImages) {
+                for(int iStage = 0; iStage < 7; iStage++)
+                    nAllocationsPerStage[iStage] += nAllocations[iStage];
+            }
+        }
+
+        printf("Allocations in steady state (%s, %zu frames after %d warm-up frames): \n", pModeNames[mode], vImages.size() - nWarmUpImages, nWarmUpImages);
+        for(int iStage = 0; iStage < 7; iStage++) {
+            printf(" - %s: %ld\n", pStageNames[iStage], nAllocationsPerStage[iStage]);
+            nTotalAllocations += nAllocationsPerStage[iStage];
+        }
+    }
+
+    if(nTotalAllocations > 0) {
+        printf("FAILED: %ld heap allocations after the warm-up frames.\n", nTotalAllocations);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/Frame.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief The number of different bits between two descriptors.
+
+@param[in] a: The first descriptor.
+@param[in] b: The second descriptor. */
+int computeHammingDistance(const Descriptor& a, const Descriptor& b) {
+    int nBits = 0;
+    for(int i = 0; i < NBPD; ++i)
+        nBits += __builtin_popcount(a[i] ^ b[i]);
+    return nBits;
+}
+
+int main(int argc, char **argv) {
+    // Test images: optional frames from an image sequence, otherwise synthetic textured images.
+    vector<Mat> vImages = loadTestImages(argc, argv, 50, 10);
+
+    // Oriented keypoints of every image, computed once and shared by every configuration.
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+    Distributor distributor;
+    OrientationComputer orientationComputer(15);
+    vector<vector<vector<KeyPoint>>> vvvKeyPointsPerFrame(vImages.size());
+    vector<vector<Mat>> vvImagesPerFrame(vImages.size());
+    for(size_t i = 0; i < vImages.size(); i++) {
+        vector<vector<KeyPoint>> vvKeyPointsPerLevel;
+        imagePyramid.setImage(vImages[i]);
+        keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+        distributor.distribute(vvvKeyPointsPerFrame[i], vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+        orientationComputer.compute(vvvKeyPointsPerFrame[i], imagePyramid.mvImages);
+        for(Mat &image : imagePyramid.mvImages)
+            vvImagesPerFrame[i].push_back(image.clone());
+    }
+
+    // Exact descriptors, the reference for every angle bin configuration.
+    DescriptorComputer exactComputer;
+    vector<vector<vector<Descriptor>>> vvvExactDescriptorsPerFrame(vImages.size());
+    double dExactTime = 0.0;
+    for(size_t i = 0; i < vImages.size(); i++) {
+        TimePoint t1 = chrono::steady_clock::now();
+        exactComputer.compute(vvvExactDescriptorsPerFrame[i], vvvKeyPointsPerFrame[i], vvImagesPerFrame[i]);
+        TimePoint t2 = chrono::steady_clock::now();
+        dExactTime += chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+    }
+    printf("Descriptor computation (%zu frames): \n", vImages.size());
+    printf(" - exact: %.3f ms\n", dExactTime / vImages.size() * 1e3);
+
+    bool bFailed = false;
+    for(int nAngleBins : {30, 64}) {
+        DescriptorComputer descriptorComputer;
+        descriptorComputer.setAngleBins(nAngleBins);
+
+        // Bit difference to the exact descriptors over all keypoints.
+        double dTime = 0.0;
+        long nDescriptors = 0, nIdentical = 0, nDifferentBits = 0;
+        int nMaxDifferentBits = 0;
+        vector<vector<Descriptor>> vvDescriptorsPerLevel;
+        for(size_t i = 0; i < vImages.size(); i++) {
+            TimePoint t1 = chrono::steady_clock::now();
+            descriptorComputer.compute(vvDescriptorsPerLevel, vvvKeyPointsPerFrame[i], vvImagesPerFrame[i]);
+            TimePoint t2 = chrono::steady_clock::now();
+            dTime += chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+
+            for(size_t iLevel = 0; iLevel < vvDescriptorsPerLevel.size(); iLevel++) {
+                for(size_t j = 0; j < vvDescriptorsPerLevel[iLevel].size(); j++) {
+                    int nBits = computeHammingDistance(vvDescriptorsPerLevel[iLevel][j], vvvExactDescriptorsPerFrame[i][iLevel][j]);
+                    nDifferentBits += nBits;
+                    nIdentical += nBits == 0;
+                    nMaxDifferentBits = max(nMaxDifferentBits, nBits);
+                    nDescriptors++;
+                }
+            }
+        }
+
+        // Keypoints whose angle is a bin center must match the exact path bit for bit.
+        long nCenterMismatches = 0;
+        DescriptorComputer centerExactComputer;
+        vector<vector<Descriptor>> vvExactDescriptorsPerLevel;
+        for(size_t i = 0; i < vImages.size(); i++) {
+            vector<vector<KeyPoint>> vvKeyPointsPerLevel = vvvKeyPointsPerFrame[i];
+            int iBin = 0;
+            for(vector<KeyPoint> &vKeyPoints : vvKeyPointsPerLevel)
+                for(KeyPoint &keyPoint : vKeyPoints)
+                    keyPoint.angle = (iBin++ % nAngleBins) * 360.f / nAngleBins;
+
+            descriptorComputer.compute(vvDescriptorsPerLevel, vvKeyPointsPerLevel, vvImagesPerFrame[i]);
+            centerExactComputer.compute(vvExactDescriptorsPerLevel, vvKeyPointsPerLevel, vvImagesPerFrame[i]);
+            for(size_t iLevel = 0; iLevel < vvDescriptorsPerLevel.size(); iLevel++)
+                for(size_t j = 0; j < vvDescriptorsPerLevel[iLevel].size(); j++)
+                    nCenterMismatches += vvDescriptorsPerLevel[iLevel][j] != vvExactDescriptorsPerLevel[iLevel][j];
+        }
+
+        double dMeanBits = nDescriptors ? (double)nDifferentBits / nDescriptors : 0.0;
+        printf(
+            " - %d bins: %.3f ms, different bits %.2f / 256 on average (max %d), identical %.1f%%, bin center mismatches %ld\n",
+            nAngleBins, dTime / vImages.size() * 1e3, dMeanBits, nMaxDifferentBits,
+            nDescriptors ? 100.0 * nIdentical / nDescriptors : 100.0, nCenterMismatches
+        );
+
+        // An angle error of 180 / nAngleBins degrees moves pattern points by at most about a pixel,
+        // which flips only comparisons of nearly equal intensities, so at most 1/8 of the bits may change on average.
+        if(nCenterMismatches > 0 || dMeanBits > 32.0) { bFailed = true; }
+    }
+
+    if(bFailed) {
+        printf("FAILED: angle-binned descriptors differ too much from the exact ones.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/Frame.h"
+
+#include <opencv2/opencv.hpp>
+#include <random>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+int main(int argc, char **argv) {
+    // Test images: optional frames from an image sequence, plus uniform noise.
+    vector<Mat> vImages;
+    if(argc > 1) {
+        string dirPath = argv[1];
+        for(int i = 0; i < 20; i++) {
+            std::ostringstream ss;
+            ss << std::setw(6) << std::setfill('0') << i << ".png";
+            Mat image = imread(dirPath + "/" + ss.str(), 0);
+            if(!image.empty()) { vImages.push_back(image); }
+        }
+    }
+    std::mt19937 rng(0);
+    for(int i = 0; i < 10; i++) {
+        Mat noise(60 + rng() % 300, 60 + rng() % 500, CV_8U);
+        for(int iY = 0; iY < noise.rows; iY++)
+            for(int iX = 0; iX < noise.cols; iX++)
+                noise.at<uchar>(iY, iX) = (uchar)(rng() % 256);
+        vImages.push_back(noise);
+    }
+
+    // Random keypoints 19 pixels inside the border, like the extractor's, at random and at special angles.
+    const float pfSpecialAngles[] = {0.f, 45.f, 90.f, 180.f, 270.f, 359.999f, 12.f, 5.625f};
+    vector<vector<vector<KeyPoint>>> vvvKeyPointsPerImage(vImages.size());
+    for(size_t i = 0; i < vImages.size(); i++) {
+        const Mat& image = vImages[i];
+        vector<KeyPoint> vKeyPoints(2000);
+        for(size_t j = 0; j < vKeyPoints.size(); j++) {
+            vKeyPoints[j].pt.x = 19 + (rng() % ((image.cols - 38) * 4)) * 0.25f;
+            vKeyPoints[j].pt.y = 19 + (rng() % ((image.rows - 38) * 4)) * 0.25f;
+            vKeyPoints[j].angle = j % 4 == 0 ? pfSpecialAngles[j / 4 % 8] : (rng() % 3600000) * 1e-4f;
+        }
+
+        // Keypoints in the bottom right corner, where the gathers would read past these unpadded images.
+        for(int j = 0; j < 64; j++)
+            vKeyPoints.emplace_back(image.cols - 19 - j % 4, image.rows - 19 - j / 16, 7.f, j * 5.625f);
+        vvvKeyPointsPerImage[i].push_back(vKeyPoints);
+    }
+
+    // compute() blurs into its own padded buffer, so the bottom right keypoints only reach the scalar
+    // fallback of the AVX2 kernel through computeBlurred() on an image that ends with its last row.
+    vector<vector<Mat>> vvBlurredImagePerImage(vImages.size());
+    for(size_t i = 0; i < vImages.size(); i++) {
+        Mat blurredImage;
+        GaussianBlur(vImages[i], blurredImage, Size(7, 7), 2, 2, BORDER_REFLECT_101);
+        vvBlurredImagePerImage[i].push_back(blurredImage);
+    }
+
+    if(!DescriptorComputer::isSupported(DescriptorComputer::AVX2)) {
+        printf("AVX2 is not supported by this CPU, only the scalar kernel is used.\n");
+        return 0;
+    }
+
+    // Every kernel must produce the same bits as the scalar one, with exact rotation and with angle bins.
+    bool bFailed = false;
+    for(int nAngleBins : {0, 30, 64}) {
+        DescriptorComputer scalarComputer(DescriptorComputer::SCALAR);
+        DescriptorComputer avx2Computer(DescriptorComputer::AVX2);
+        scalarComputer.setAngleBins(nAngleBins);
+        avx2Computer.setAngleBins(nAngleBins);
+
+        long nMismatches = 0, nBlurredMismatches = 0;
+        double dScalarTime = 0.0, dAVX2Time = 0.0;
+        vector<vector<Descriptor>> vvScalarDescriptors, vvAVX2Descriptors;
+        for(size_t i = 0; i < vImages.size(); i++) {
+            vector<Mat> vImagePerLevel = {vImages[i]};
+
+            TimePoint t1 = chrono::steady_clock::now();
+            scalarComputer.compute(vvScalarDescriptors, vvvKeyPointsPerImage[i], vImagePerLevel);
+            TimePoint t2 = chrono::steady_clock::now();
+            avx2Computer.compute(vvAVX2Descriptors, vvvKeyPointsPerImage[i], vImagePerLevel);
+            TimePoint t3 = chrono::steady_clock::now();
+            dScalarTime += chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+            dAVX2Time += chrono::duration_cast<chrono::duration<double>>(t3 - t2).count();
+
+            for(size_t j = 0; j < vvScalarDescriptors[0].size(); j++)
+                nMismatches += vvScalarDescriptors[0][j] != vvAVX2Descriptors[0][j];
+
+            scalarComputer.computeBlurred(vvScalarDescriptors, vvvKeyPointsPerImage[i], vvBlurredImagePerImage[i]);
+            avx2Computer.computeBlurred(vvAVX2Descriptors, vvvKeyPointsPerImage[i], vvBlurredImagePerImage[i]);
+            for(size_t j = 0; j < vvScalarDescriptors[0].size(); j++)
+                nBlurredMismatches += vvScalarDescriptors[0][j] != vvAVX2Descriptors[0][j];
+        }
+
+        printf(
+            "%d angle bins: scalar %.3f ms, AVX2 %.3f ms, mismatches %ld, mismatches on unpadded blurred images %ld\n",
+            nAngleBins, dScalarTime * 1e3, dAVX2Time * 1e3, nMismatches, nBlurredMismatches
+        );
+        if(nMismatches > 0 || nBlurredMismatches > 0) { bFailed = true; }
+    }
+
+    if(bFailed) {
+        printf("FAILED: the AVX2 kernel differs from the scalar kernel.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/Frame.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+int main(int argc, char **argv) {
+    // Test images: optional frames from an image sequence, otherwise synthetic textured images.
+    vector<Mat> vImages = loadTestImages(argc, argv, 50, 20);
+
+    bool bFailed = false;
+    for(int nFeatures : {300, 1200, 3000}) {
+        ImagePyramid imagePyramid(8, 1.2, nFeatures);
+        KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+        Distributor distributor;
+        OrientationComputer orientationComputer(15);
+        DescriptorComputer fullComputer, localComputer;
+        localComputer.setLocalSmoothing(true);
+
+        // Each level is computed on its own, so that the time of every level can be compared.
+        int nLevels = imagePyramid.mnLevels;
+        vector<double> vdFullTimes(nLevels, 0.0), vdLocalTimes(nLevels, 0.0);
+        vector<long> vnMismatches(nLevels, 0), vnKeyPoints(nLevels, 0);
+        vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel;
+        vector<vector<Descriptor>> vvFullDescriptors, vvLocalDescriptors;
+        for(const Mat &image : vImages) {
+            imagePyramid.setImage(image);
+            keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+            distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+            orientationComputer.compute(vvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+
+            for(int iLevel = 0; iLevel < nLevels; iLevel++) {
+                vector<Mat> vImagePerLevel = {imagePyramid.mvImages[iLevel]};
+                vector<vector<KeyPoint>> vvLevelKeyPoints = {vvDistributedKeyPointsPerLevel[iLevel]};
+
+                TimePoint t1 = chrono::steady_clock::now();
+                fullComputer.compute(vvFullDescriptors, vvLevelKeyPoints, vImagePerLevel);
+                TimePoint t2 = chrono::steady_clock::now();
+                localComputer.compute(vvLocalDescriptors, vvLevelKeyPoints, vImagePerLevel);
+                TimePoint t3 = chrono::steady_clock::now();
+                vdFullTimes[iLevel] += chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+                vdLocalTimes[iLevel] += chrono::duration_cast<chrono::duration<double>>(t3 - t2).count();
+
+                // Descriptors must be identical, so matching quality cannot change.
+                for(size_t i = 0; i < vvFullDescriptors[0].size(); i++)
+                    vnMismatches[iLevel] += vvFullDescriptors[0][i] != vvLocalDescriptors[0][i];
+                vnKeyPoints[iLevel] += vvLevelKeyPoints[0].size();
+            }
+        }
+
+        double dFrames = (double)vImages.size(), dFullTime = 0.0, dLocalTime = 0.0;
+        printf("Whole-level blur vs blur around keypoints (%d features, %zu frames): \n", nFeatures, vImages.size());
+        for(int iLevel = 0; iLevel < nLevels; iLevel++) {
+            printf(
+                " - level %d (%.0f keypoints): full %.3f ms, local %.3f ms, mismatched descriptors %ld\n",
+                iLevel, vnKeyPoints[iLevel] / dFrames, vdFullTimes[iLevel] / dFrames * 1e3, vdLocalTimes[iLevel] / dFrames * 1e3, vnMismatches[iLevel]
+            );
+            dFullTime += vdFullTimes[iLevel];
+            dLocalTime += vdLocalTimes[iLevel];
+            if(vnMismatches[iLevel] > 0) { bFailed = true; }
+        }
+        printf(" - total: full %.3f ms, local %.3f ms\n", dFullTime / dFrames * 1e3, dLocalTime / dFrames * 1e3);
+    }
+
+    if(bFailed) {
+        printf("FAILED: blurring around keypoints changed some descriptors.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/Frame.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+int main(int argc, char **argv) {
+    // Test images: optional frames from an image sequence, otherwise synthetic textured images.
+    vector<Mat> vImages = loadTestImages(argc, argv, 50, 20);
+
+    // The fused stage must give exactly the angles and descriptors of the two separate passes,
+    // with the exact rotation and with angle bins.
+    bool bFailed = false;
+    for(int nAngleBins : {0, 30}) {
+        for(int nFeatures : {1200, 3000}) {
+            ImagePyramid imagePyramid(8, 1.2, nFeatures);
+            imagePyramid.enableBlurredPyramid();
+            KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+            Distributor distributor;
+            OrientationComputer orientationComputer(15);
+            DescriptorComputer descriptorComputer;
+            descriptorComputer.setAngleBins(nAngleBins);
+
+            double dSeparateTime = 0.0, dFusedTime = 0.0;
+            long nMismatches = 0;
+            vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel;
+            vector<vector<Descriptor>> vvSeparateDescriptors, vvFusedDescriptors;
+            for(const Mat &image : vImages) {
+                imagePyramid.setImage(image);
+                keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+                distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+                vector<vector<KeyPoint>> vvSeparateKeyPoints = vvDistributedKeyPointsPerLevel;
+                vector<vector<KeyPoint>> vvFusedKeyPoints = vvDistributedKeyPointsPerLevel;
+
+                TimePoint t1 = chrono::steady_clock::now();
+                orientationComputer.compute(vvSeparateKeyPoints, imagePyramid.mvImages);
+                descriptorComputer.computeBlurred(vvSeparateDescriptors, vvSeparateKeyPoints, imagePyramid.mvBlurredImages);
+                TimePoint t2 = chrono::steady_clock::now();
+                descriptorComputer.describe(vvFusedDescriptors, vvFusedKeyPoints, imagePyramid.mvImages, imagePyramid.mvBlurredImages, orientationComputer);
+                TimePoint t3 = chrono::steady_clock::now();
+                dSeparateTime += chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+                dFusedTime += chrono::duration_cast<chrono::duration<double>>(t3 - t2).count();
+
+                for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+                    for(size_t i = 0; i < vvSeparateKeyPoints[iLevel].size(); i++) {
+                        nMismatches += vvSeparateKeyPoints[iLevel][i].angle != vvFusedKeyPoints[iLevel][i].angle ||
+                                       vvSeparateDescriptors[iLevel][i] != vvFusedDescriptors[iLevel][i];
+                    }
+                }
+            }
+
+            double dFrames = (double)vImages.size();
+            printf(
+                "%d features, %d angle bins: separate passes %.3f ms, fused %.3f ms, mismatches %ld\n",
+                nFeatures, nAngleBins, dSeparateTime / dFrames * 1e3, dFusedTime / dFrames * 1e3, nMismatches
+            );
+            if(nMismatches > 0) { bFailed = true; }
+        }
+    }
+
+    if(bFailed) {
+        printf("FAILED: the fused stage differs from the separate passes.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/Frame.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+int main(int argc, char **argv) {
+    // Test images: optional frames from an image sequence, otherwise synthetic textured images.
+    vector<Mat> vImages = loadTestImages(argc, argv, 50, 20);
+
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    imagePyramid.enableBlurredPyramid();
+    KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+    Distributor distributor;
+    OrientationComputer orientationComputer(15);
+
+    // The extended pattern starts with the ORB pairs, so the first 32 bytes of a 512-bit descriptor must be
+    // the 256-bit descriptor, on every kernel and with angle bins. The kernels must also agree with each other.
+    vector<DescriptorComputer::Instruction> vInstructions = {DescriptorComputer::SCALAR};
+    if(DescriptorComputer::isSupported(DescriptorComputer::AVX2)) { vInstructions.push_back(DescriptorComputer::AVX2); }
+
+    bool bFailed = false;
+    vector<vector<DescriptorComputer512::Descriptor>> vvScalar512Descriptors;
+    for(int nAngleBins : {0, 30}) {
+        for(DescriptorComputer::Instruction eInstruction : vInstructions) {
+            DescriptorComputer computer256(eInstruction);
+            DescriptorComputer512 computer512(eInstruction);
+            computer256.setAngleBins(nAngleBins);
+            computer512.setAngleBins(nAngleBins);
+
+            double d256Time = 0.0, d512Time = 0.0;
+            long nPrefixMismatches = 0, nKernelMismatches = 0;
+            vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel;
+            vector<vector<Descriptor>> vv256Descriptors;
+            vector<vector<Descriptor512>> vv512Descriptors;
+            for(size_t iImage = 0; iImage < vImages.size(); iImage++) {
+                imagePyramid.setImage(vImages[iImage]);
+                keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+                distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+                orientationComputer.compute(vvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+
+                TimePoint t1 = chrono::steady_clock::now();
+                computer256.computeBlurred(vv256Descriptors, vvDistributedKeyPointsPerLevel, imagePyramid.mvBlurredImages);
+                TimePoint t2 = chrono::steady_clock::now();
+                computer512.computeBlurred(vv512Descriptors, vvDistributedKeyPointsPerLevel, imagePyramid.mvBlurredImages);
+                TimePoint t3 = chrono::steady_clock::now();
+                d256Time += chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+                d512Time += chrono::duration_cast<chrono::duration<double>>(t3 - t2).count();
+
+                for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+                    for(size_t i = 0; i < vv256Descriptors[iLevel].size(); i++)
+                        nPrefixMismatches += memcmp(vv256Descriptors[iLevel][i].data(), vv512Descriptors[iLevel][i].data(), NBPD) != 0;
+                }
+
+                // Keep the scalar descriptors of the first image to compare the other kernels with.
+                if(iImage == 0) {
+                    if(eInstruction == DescriptorComputer::SCALAR)
+                        vvScalar512Descriptors = vv512Descriptors;
+                    else {
+                        for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++)
+                            for(size_t i = 0; i < vv512Descriptors[iLevel].size(); i++)
+                                nKernelMismatches += vv512Descriptors[iLevel][i] != vvScalar512Descriptors[iLevel][i];
+                    }
+                }
+            }
+
+            double dFrames = (double)vImages.size();
+            printf(
+                "%s, %d angle bins: 256-bit %.3f ms, 512-bit %.3f ms, prefix mismatches %ld, kernel mismatches %ld\n",
+                eInstruction == DescriptorComputer::AVX2 ? "AVX2" : "scalar", nAngleBins,
+                d256Time / dFrames * 1e3, d512Time / dFrames * 1e3, nPrefixMismatches, nKernelMismatches
+            );
+            if(nPrefixMismatches > 0 || nKernelMismatches > 0) { bFailed = true; }
+        }
+    }
+
+    if(bFailed) {
+        printf("FAILED: 512-bit descriptors do not extend the 256-bit descriptors.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/Frame.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+int main() {
+    // Synthetic textured images.
+    vector<Mat> vImages = createSyntheticImages(5);
+
+    // Pattern files: the ORB pairs, the extended pairs, the ORB pairs in reverse order, and invalid patterns.
+    string orbPath = "testDescriptorComputer_06_orb.bin", extendedPath = "testDescriptorComputer_06_extended.bin";
+    string reversedPath = "testDescriptorComputer_06_reversed.bin", widePath = "testDescriptorComputer_06_wide.bin";
+    vector<int8_t> vORBPattern(ORBPattern::mPattern.begin(), ORBPattern::mPattern.end());
+    vector<int8_t> vExtendedPattern(ExtendedORBPattern::mPattern.begin(), ExtendedORBPattern::mPattern.end());
+    vector<int8_t> vReversedPattern, vWidePattern = vORBPattern;
+    for(int i = ORBPattern::nPairs - 1; i >= 0; i--)
+        vReversedPattern.insert(vReversedPattern.end(), &ORBPattern::mPattern[4 * i], &ORBPattern::mPattern[4 * i + 4]);
+    vWidePattern[0] = 15; vWidePattern[1] = 15; // farther than the ORB radius
+    bool bFailed = !DescriptorComputerBase::savePattern(orbPath, vORBPattern) ||
+                   !DescriptorComputerBase::savePattern(extendedPath, vExtendedPattern) ||
+                   !DescriptorComputerBase::savePattern(reversedPath, vReversedPattern) ||
+                   !DescriptorComputerBase::savePattern(widePath, vWidePattern);
+
+    // Malformed files: the ORB pattern cut short, and a header announcing far more pairs than any descriptor has.
+    string truncatedPath = "testDescriptorComputer_06_truncated.bin", oversizedPath = "testDescriptorComputer_06_oversized.bin";
+    FILE* pTruncated = fopen(truncatedPath.c_str(), "wb");
+    FILE* pOversized = fopen(oversizedPath.c_str(), "wb");
+    int32_t nTruncatedPairs = ORBPattern::nPairs, nOversizedPairs = 0x40000000;
+    if(!pTruncated || !pOversized) { bFailed = true; }
+    if(pTruncated) {
+        fwrite("BPAT", 1, 4, pTruncated);
+        fwrite(&nTruncatedPairs, sizeof(nTruncatedPairs), 1, pTruncated);
+        fwrite(vORBPattern.data(), 1, vORBPattern.size() - 5, pTruncated);
+        fclose(pTruncated);
+    }
+    if(pOversized) {
+        fwrite("BPAT", 1, 4, pOversized);
+        fwrite(&nOversizedPairs, sizeof(nOversizedPairs), 1, pOversized);
+        fwrite(vORBPattern.data(), 1, vORBPattern.size(), pOversized);
+        fclose(pOversized);
+    }
+
+    // Invalid patterns are rejected.
+    DescriptorComputer rejectingComputer;
+    DescriptorComputer512 rejectingComputer512;
+    vector<int8_t> vRejectedPattern;
+    bool bRejected = !rejectingComputer.loadPattern("testDescriptorComputer_06_missing.bin") &&
+                     !rejectingComputer.loadPattern(widePath) &&
+                     !rejectingComputer512.loadPattern(orbPath) && // 256 pairs for 512 bits
+                     !DescriptorComputerBase::readPattern(truncatedPath, vRejectedPattern) &&
+                     !DescriptorComputerBase::readPattern(oversizedPath, vRejectedPattern) &&
+                     !rejectingComputer.loadPattern(truncatedPath) &&
+                     !rejectingComputer.loadPattern(oversizedPath);
+    printf("Invalid patterns rejected: %s\n", bRejected ? "yes" : "no");
+    if(!bRejected) { bFailed = true; }
+
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    imagePyramid.enableBlurredPyramid();
+    KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+    Distributor distributor;
+    OrientationComputer orientationComputer(15);
+
+    vector<DescriptorComputer::Instruction> vInstructions = {DescriptorComputer::SCALAR};
+    if(DescriptorComputer::isSupported(DescriptorComputer::AVX2)) { vInstructions.push_back(DescriptorComputer::AVX2); }
+
+    // A loaded pattern gives exactly the descriptors of the same built-in pairs, on every kernel and with angle bins.
+    // The reversed pattern gives the built-in bits in reverse order.
+    for(int nAngleBins : {0, 30}) {
+        for(DescriptorComputer::Instruction eInstruction : vInstructions) {
+            DescriptorComputer builtInComputer(eInstruction), orbComputer(eInstruction);
+            DescriptorComputer extendedComputer(eInstruction), reversedComputer(eInstruction);
+            builtInComputer.setAngleBins(nAngleBins);
+            orbComputer.setAngleBins(nAngleBins);
+            extendedComputer.setAngleBins(nAngleBins);
+            reversedComputer.setAngleBins(nAngleBins);
+            bool bLoaded = orbComputer.loadPattern(orbPath) && extendedComputer.loadPattern(extendedPath) &&
+                           reversedComputer.loadPattern(reversedPath);
+
+            long nMismatches = 0;
+            vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel;
+            vector<vector<Descriptor>> vvBuiltIn, vvORB, vvExtended, vvReversed;
+            for(const Mat &image : vImages) {
+                imagePyramid.setImage(image);
+                keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+                distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+                orientationComputer.compute(vvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+
+                builtInComputer.computeBlurred(vvBuiltIn, vvDistributedKeyPointsPerLevel, imagePyramid.mvBlurredImages);
+                orbComputer.computeBlurred(vvORB, vvDistributedKeyPointsPerLevel, imagePyramid.mvBlurredImages);
+                extendedComputer.computeBlurred(vvExtended, vvDistributedKeyPointsPerLevel, imagePyramid.mvBlurredImages);
+                reversedComputer.computeBlurred(vvReversed, vvDistributedKeyPointsPerLevel, imagePyramid.mvBlurredImages);
+
+                for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+                    for(size_t i = 0; i < vvBuiltIn[iLevel].size(); i++) {
+                        const Descriptor& builtIn = vvBuiltIn[iLevel][i];
+                        bool bMismatch = vvORB[iLevel][i] != builtIn || vvExtended[iLevel][i] != builtIn;
+                        for(int iBit = 0; iBit < 256; iBit++) {
+                            int iReversedBit = 255 - iBit;
+                            bMismatch |= ((builtIn[iBit / 8] >> (iBit % 8)) & 1) != ((vvReversed[iLevel][i][iReversedBit / 8] >> (iReversedBit % 8)) & 1);
+                        }
+                        nMismatches += bMismatch;
+                    }
+                }
+            }
+
+            printf(
+                "%s, %d angle bins: loaded %s, mismatches %ld\n",
+                eInstruction == DescriptorComputer::AVX2 ? "AVX2" : "scalar", nAngleBins, bLoaded ? "yes" : "no", nMismatches
+            );
+            if(!bLoaded || nMismatches > 0) { bFailed = true; }
+        }
+    }
+
+    for(const string& path : {orbPath, extendedPath, reversedPath, widePath, truncatedPath, oversizedPath}) { remove(path.c_str()); }
+
+    if(bFailed) {
+        printf("FAILED: loaded patterns differ from the built-in patterns.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/Frame.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief Spatial uniformity of a keypoint set: the coefficient of variation (std / mean) of the
+keypoint counts over a grid sized for about 4 keypoints per cell. Lower is more uniform.
+
+@param[in] vKeyPoints: Keypoints of one pyramid level.
+@param[in] iWidth: Width of the level.
+@param[in] iHeight: Height of the level. */
+double computeUniformity(const vector<KeyPoint>& vKeyPoints, int iWidth, int iHeight) {
+    if(vKeyPoints.empty()) { return 0.0; }
+
+    double dCellSize = sqrt(4.0 * iWidth * iHeight / vKeyPoints.size());
+    int nCols = max(1, (int)(iWidth / dCellSize)), nRows = max(1, (int)(iHeight / dCellSize));
+    vector<int> vnCounts(nCols * nRows, 0);
+    for(const KeyPoint& keyPoint : vKeyPoints) {
+        int iCol = min((int)(keyPoint.pt.x * nCols / iWidth), nCols - 1);
+        int iRow = min((int)(keyPoint.pt.y * nRows / iHeight), nRows - 1);
+        vnCounts[iRow * nCols + iCol]++;
+    }
+
+    double dMean = (double)vKeyPoints.size() / vnCounts.size(), dVariance = 0.0;
+    for(int nCount : vnCounts) { dVariance += (nCount - dMean) * (nCount - dMean); }
+    return sqrt(dVariance / vnCounts.size()) / dMean;
+}
+
+int main(int argc, char **argv) {
+    // Test images: optional frames from an image sequence, otherwise synthetic textured images.
+    vector<Mat> vImages = loadTestImages(argc, argv, 100, 20);
+
+    const char* pStrategyNames[] = {"QUADTREE", "GRID_BUCKET", "SSC"};
+    bool bFailed = false;
+
+    for(int nFeatures : {1200, 3000}) {
+        // Extract the keypoints once, every strategy distributes the same candidates.
+        ImagePyramid imagePyramid(8, 1.2, nFeatures);
+        KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+        vector<vector<vector<KeyPoint>>> vvvKeyPointsPerFrame(vImages.size());
+        vector<vector<Mat>> vvImagesPerFrame(vImages.size());
+        for(size_t i = 0; i < vImages.size(); i++) {
+            imagePyramid.setImage(vImages[i]);
+            keyPointExtractor.extract(vvvKeyPointsPerFrame[i], imagePyramid.mvImages);
+            for(Mat &image : imagePyramid.mvImages)
+                vvImagesPerFrame[i].push_back(image.clone());
+        }
+
+        // Four configurations: each strategy on every level, and grid bucketing at level 0 only.
+        printf("Distribution benchmark (%d features, %zu frames): \n", nFeatures, vImages.size());
+        for(int iConfig = 0; iConfig < 4; iConfig++) {
+            Distributor distributor;
+            if(iConfig < 3) { distributor.setStrategy((Distributor::Strategy)iConfig); }
+            else { distributor.setStrategy(0, Distributor::GRID_BUCKET); }
+
+            double dTime = 0.0, dUniformity = 0.0;
+            long nDistributed = 0;
+            vector<vector<KeyPoint>> vvDistributedKeyPointsPerLevel;
+            for(size_t i = 0; i < vImages.size(); i++) {
+                // Distribution does not modify the candidates, so the same ones can be reused.
+                TimePoint t1 = chrono::steady_clock::now();
+                distributor.distribute(vvDistributedKeyPointsPerLevel, vvvKeyPointsPerFrame[i], imagePyramid.mvnFeaturesPerLevel, vvImagesPerFrame[i]);
+                TimePoint t2 = chrono::steady_clock::now();
+                dTime += chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+
+                const Mat &image = vvImagesPerFrame[i][0];
+                dUniformity += computeUniformity(vvDistributedKeyPointsPerLevel[0], image.cols, image.rows);
+                for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+                    nDistributed += vvDistributedKeyPointsPerLevel[iLevel].size();
+
+                    // The quadtree may keep a few extra keypoints, the other strategies must stay within the target
+                    bool bQuadTree = iConfig == 0 || (iConfig == 3 && iLevel > 0);
+                    int nLimit = min(imagePyramid.mvnFeaturesPerLevel[iLevel], (int)vvvKeyPointsPerFrame[i][iLevel].size());
+                    if(!bQuadTree && (int)vvDistributedKeyPointsPerLevel[iLevel].size() > nLimit) { bFailed = true; }
+                }
+            }
+
+            double dFrames = (double)vImages.size();
+            printf(
+                " - %-22s time %.3f ms, keypoints %.1f, level 0 uniformity (CV) %.3f\n",
+                iConfig < 3 ? pStrategyNames[iConfig] : "GRID_BUCKET + QUADTREE",
+                dTime / dFrames * 1e3, nDistributed / dFrames, dUniformity / dFrames
+            );
+        }
+    }
+
+    if(bFailed) {
+        printf("FAILED: a strategy returned more keypoints than requested.\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "myORB-SLAM2/DistributionStrategy.h"
+
+#include <opencv2/opencv.hpp>
+#include <random>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief Sorted responses of a keypoint set, every hand-built keypoint has its own response.
+
+@param[in] vKeyPoints: The keypoints. */
+vector<float> getResponses(const vector<KeyPoint>& vKeyPoints) {
+    vector<float> vfResponses;
+    for(const KeyPoint& keyPoint : vKeyPoints) { vfResponses.push_back(keyPoint.response); }
+    sort(vfResponses.begin(), vfResponses.end());
+    return vfResponses;
+}
+
+int main() {
+    QuadTreeDistribution quadTreeDistribution;
+    vector<KeyPoint> vDistributedKeyPoints;
+    bool bFailed = false;
+
+    // Most populated first: the top-left quadrant holds 10 keypoints, one in each of its quadrants has the best response.
+    // The top-right quadrant holds 3 keypoints, the bottom quadrants 1 each.
+    Rect area(0, 0, 100, 100);
+    vector<KeyPoint> vKeyPoints = {
+        KeyPoint(10, 10, 7.f, -1, 5), KeyPoint(12, 12, 7.f, -1, 9), KeyPoint(10, 12, 7.f, -1, 1),
+        KeyPoint(35, 10, 7.f, -1, 4), KeyPoint(37, 12, 7.f, -1, 8),
+        KeyPoint(10, 35, 7.f, -1, 7), KeyPoint(12, 37, 7.f, -1, 2),
+        KeyPoint(35, 35, 7.f, -1, 3), KeyPoint(37, 37, 7.f, -1, 6), KeyPoint(36, 36, 7.f, -1, 10),
+        KeyPoint(60, 10, 7.f, -1, 20), KeyPoint(80, 10, 7.f, -1, 11), KeyPoint(70, 30, 7.f, -1, 12),
+        KeyPoint(10, 80, 7.f, -1, 13),
+        KeyPoint(80, 80, 7.f, -1, 14)
+    };
+
+    // 5 features: the root is split into 4 nodes, then the top-left quadrant (10 keypoints) before the top-right one (3).
+    quadTreeDistribution.distribute(vDistributedKeyPoints, vKeyPoints, 5, area, area.area());
+    if(getResponses(vDistributedKeyPoints) != vector<float>{7, 8, 9, 10, 13, 14, 20}) {
+        printf("FAILED: the most populated node was not split first.\n");
+        bFailed = true;
+    }
+
+    // 8 features: three nodes are left with 3 keypoints, the one created first (the top-right quadrant) is split next.
+    quadTreeDistribution.distribute(vDistributedKeyPoints, vKeyPoints, 8, area, area.area());
+    if(getResponses(vDistributedKeyPoints) != vector<float>{7, 8, 9, 10, 11, 12, 13, 14, 20}) {
+        printf("FAILED: equally populated nodes were not split in creation order.\n");
+        bFailed = true;
+    }
+
+    // Keypoints on the same position can never be separated: splitting stops once their node shrinks to 1 pixel,
+    // they end up as one keypoint, the best of them.
+    vKeyPoints.clear();
+    for(int i = 0; i < 1000; i++) { vKeyPoints.emplace_back(50.5f, 50.5f, 7.f, -1, (float)(i % 100)); }
+    vKeyPoints.emplace_back(10, 10, 7.f, -1, 200);
+    vKeyPoints.emplace_back(90, 10, 7.f, -1, 201);
+    vKeyPoints.emplace_back(10, 90, 7.f, -1, 202);
+    quadTreeDistribution.distribute(vDistributedKeyPoints, vKeyPoints, 100, area, area.area());
+    if(getResponses(vDistributedKeyPoints) != vector<float>{99, 200, 201, 202}) {
+        printf("FAILED: keypoints on the same position were not merged.\n");
+        bFailed = true;
+    }
+
+    // Every split replaces one node by at most 4 and splitting stops as soon as the target is reached,
+    // so at most nFeatures + 2 keypoints are kept. Keypoints on distinct pixels can always be separated,
+    // so at least nFeatures are kept, or all of them when there are fewer.
+    std::mt19937 rng(0);
+    Rect imageArea(0, 0, 1241, 376);
+    for(int nKeyPoints : {0, 1, 10, 500, 5000, 20000}) {
+        vector<int> viPixels(imageArea.area());
+        for(int i = 0; i < (int)viPixels.size(); i++) { viPixels[i] = i; }
+        shuffle(viPixels.begin(), viPixels.end(), rng);
+
+        vKeyPoints.clear();
+        for(int i = 0; i < nKeyPoints; i++)
+            vKeyPoints.emplace_back((float)(viPixels[i] % imageArea.width), (float)(viPixels[i] / imageArea.width), 7.f, -1, (float)(rng() % 256));
+
+        for(int nFeatures : {1, 2, 5, 100, 1000, 3000}) {
+            quadTreeDistribution.distribute(vDistributedKeyPoints, vKeyPoints, nFeatures, imageArea, imageArea.area());
+            int nDistributed = vDistributedKeyPoints.size();
+            if(nDistributed > nFeatures + 2 || nDistributed < min(nFeatures, nKeyPoints)) {
+                printf("FAILED: %d keypoints kept out of %d for %d features.\n", nDistributed, nKeyPoints, nFeatures);
+                bFailed = true;
+            }
+        }
+    }
+
+    if(bFailed) { return 1; }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "myORB-SLAM2/FASTDetector.h"
+
+#include <opencv2/opencv.hpp>
+#include <random>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief Check that two keypoint sets are bit for bit identical.
+
+@param[in] vExpected: Keypoints from cv::FAST.
+@param[in] vActual: Keypoints from FASTDetector. */
+bool isIdentical(const vector<KeyPoint>& vExpected, const vector<KeyPoint>& vActual) {
+    if(vExpected.size() != vActual.size()) { return false; }
+
+    for(size_t i = 0; i < vExpected.size(); ++i) {
+        const KeyPoint& expected = vExpected[i];
+        const KeyPoint& actual = vActual[i];
+        if(expected.pt.x != actual.pt.x || expected.pt.y != actual.pt.y ||
+           expected.response != actual.response || expected.size != actual.size ||
+           expected.angle != actual.angle || expected.octave != actual.octave) { return false; }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    // Test images: optional frames from an image sequence, plus synthetic ones.
+    vector<Mat> vImages;
+    if(argc > 1) {
+        string dirPath = argv[1];
+        for(int i = 0; i < 50; i++) {
+            std::ostringstream ss;
+            ss << std::setw(6) << std::setfill('0') << i << ".png";
+            Mat image = imread(dirPath + "/" + ss.str(), 0);
+            if(!image.empty()) { vImages.push_back(image); }
+        }
+    }
+
+    // Uniform noise creates corners of every score, odd sizes exercise the kernel tails.
+    std::mt19937 rng(0);
+    for(int i = 0; i < 20; i++) {
+        Mat noise(40 + rng() % 300, 40 + rng() % 500, CV_8U);
+        for(int iY = 0; iY < noise.rows; iY++)
+            for(int iX = 0; iX < noise.cols; iX++)
+                noise.at<uchar>(iY, iX) = (uchar)(rng() % 256);
+        vImages.push_back(noise);
+    }
+
+    // Sub-images check that the row stride is used instead of the width.
+    int nImages = vImages.size();
+    for(int i = 0; i < nImages; i++) {
+        const Mat& image = vImages[i];
+        if(image.rows > 20 && image.cols > 20)
+            vImages.push_back(image.rowRange(5, image.rows - 3).colRange(7, image.cols - 2));
+    }
+
+    // Compare every kernel this CPU can run against cv::FAST.
+    const char* pNames[] = {"Scalar", "SSE2", "AVX2", "AVX512BW"};
+    int nFailures = 0;
+    for(int iInstruction = FASTDetector::SCALAR; iInstruction <= FASTDetector::AVX512BW; iInstruction++) {
+        FASTDetector::Instruction eInstruction = (FASTDetector::Instruction)iInstruction;
+        if(!FASTDetector::isSupported(eInstruction)) {
+            printf("%-9s not supported, skipped.\n", pNames[iInstruction]);
+            continue;
+        }
+
+        FASTDetector detector(eInstruction);
+        int nChecks = 0, nMismatches = 0;
+        for(const Mat& image : vImages) {
+            for(int iThreshold : {1, 7, 20, 50}) {
+                for(bool bNonmax : {true, false}) {
+                    vector<KeyPoint> vExpected, vActual;
+                    FAST(image, vExpected, iThreshold, bNonmax);
+                    detector.detect(image, vActual, iThreshold, bNonmax);
+                    nChecks++;
+                    if(!isIdentical(vExpected, vActual)) { nMismatches++; }
+                }
+            }
+        }
+
+        printf("%-9s %d / %d identical to cv::FAST.\n", pNames[iInstruction], nChecks - nMismatches, nChecks);
+        nFailures += nMismatches;
+    }
+
+    printf("Default kernel: %s\n", pNames[FASTDetector::detectInstruction()]);
+    return nFailures == 0 ? 0 : 1;
+}
@@ -4,6 +4,7 @@
 #include "myORB-SLAM2/OrientationComputer.h"
 #include "myORB-SLAM2/DescriptorComputer.h"
 #include "myORB-SLAM2/Frame.h"
+#include "myORB-SLAM2/FramePool.h"
 
 #include <opencv2/opencv.hpp>
 #include <chrono>
@@ -29,18 +30,25 @@ int main(int argc, char **argv) {
 
     // Initialize Image Pyramid, KeyPoint Extractor, Distributor, and Orientation Computer.
     ImagePyramid imagePyramid(3, 1.2, 1200);
+    imagePyramid.enableBlurredPyramid();
     KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+    keyPointExtractor.setThreads(thread::hardware_concurrency());
     Distributor distributor;
     OrientationComputer orientationComputer(15);
     DescriptorComputer descriptorComputer;
 
-    // vector to store each frame object.
-    vector<Frame*> vpFrames;
+    // vector to store each frame object. The frames come from a pool that reuses their storage once released.
+    FramePool framePool;
+    vector<FramePtr> vpFrames;
     vpFrames.reserve(4071);
 
     // Calculate the average time taken per frame to compute ORB features.
     double avgTimeTaken = 0;
 
+    // Containers reused for every frame; the frame copies their content into its own arrays.
+    vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel;
+    vector<vector<Descriptor>> vvDescriptorsPerLevel;
+
     // Iterate over each image.
     for(string imageFileName : vImageFileNames) {
         Mat image = imread(dirPath + "/" + imageFileName, 0);
@@ -48,33 +56,34 @@ int main(int argc, char **argv) {
         TimePoint t1 = chrono::steady_clock::now();
 
         // Extract keypoints.
-        vector<vector<KeyPoint>> vvKeyPointsPerLevel;
         imagePyramid.setImage(image);
         vector<Mat> &vImagePerLevel = imagePyramid.mvImages;
         keyPointExtractor.extract(vvKeyPointsPerLevel, vImagePerLevel);
 
         // Distribute keypoints.
-        vector<vector<KeyPoint>>* pvvDistributedKeyPointsPerLevel = new vector<vector<KeyPoint>>;
         distributor.distribute(
-            *pvvDistributedKeyPointsPerLevel,
+            vvDistributedKeyPointsPerLevel,
             vvKeyPointsPerLevel,
             imagePyramid.mvnFeaturesPerLevel,
             vImagePerLevel
         );
 
-        // Compute orientations for each keypoint.
-        orientationComputer.compute(*pvvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
-
-        // Compute descriptors for each keypoint.
-        vector<vector<Descriptor>>* pvvDescriptorsPerLevel = new vector<vector<Descriptor>>;
-        descriptorComputer.compute(*pvvDescriptorsPerLevel, *pvvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+        // Compute orientations and descriptors for each keypoint in one pass.
+        descriptorComputer.describe(
+            vvDescriptorsPerLevel,
+            vvDistributedKeyPointsPerLevel,
+            imagePyramid.mvImages,
+            imagePyramid.mvBlurredImages,
+            orientationComputer
+        );
 
         // Create a frame object.
         vpFrames.push_back(
-            new Frame(
+            framePool.acquire(
+                image.size(),
                 imagePyramid.mvfScaleFactors,
-                pvvDistributedKeyPointsPerLevel,
-                pvvDescriptorsPerLevel
+                vvDistributedKeyPointsPerLevel,
+                vvDescriptorsPerLevel
             )
         );
 
@@ -88,6 +97,7 @@ int main(int argc, char **argv) {
     }
 
     cout << "The average time taken per frame to compute ORB features: " << avgTimeTaken/4071.0 << " s." << endl;
+    keyPointExtractor.printStatistics();
 
     // Iterate over each image.
     for(int i = 0; i < 4071; i++) {
@@ -97,18 +107,22 @@ int main(int argc, char **argv) {
 
         // Paint keypoints from each pyramid level
         cvtColor(image, image, COLOR_GRAY2BGR);
-        for(vector<KeyPoint>& vKeyPoints : *frame.mpvvKeyPointsPerLevel)
+        for(int iLevel = 0; iLevel < (int)frame.mvfScaleFactors.size(); iLevel++) {
+            Frame::LevelView level = frame.getLevel(iLevel);
+            vector<KeyPoint> vKeyPoints;
+            for(int i = 0; i < level.nKeyPoints; i++)
+                vKeyPoints.push_back(level.getKeyPoint(i));
             cv::drawKeypoints(image, vKeyPoints, image, cv::Scalar(0,255,0), cv::DrawMatchesFlags::DEFAULT);
+        }
 
         // Display image with keypoints.
         cv::imshow("Image", image);
         if(cv::waitKey(0) == 'q') { break; }
     }
 
-    // Delete remaining data
-    for(Frame* pFrame : vpFrames)
-        delete pFrame;
-    
+    // Release the frames.
+    vpFrames.clear();
+
     // Destroy all windows.
     cv::destroyAllWindows();
 }
\ No newline at end of file
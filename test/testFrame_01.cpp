@@ -0,0 +1,85 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/Frame.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+int main() {
+    // Synthetic textured images.
+    vector<Mat> vImages = createSyntheticImages(5);
+
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    imagePyramid.enableBlurredPyramid();
+    KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+    Distributor distributor;
+    OrientationComputer orientationComputer(15);
+    DescriptorComputer descriptorComputer;
+
+    // The per-level views of a frame must give back the keypoints and descriptors it was built from,
+    // with coordinates mapped to level 0, and the arrays must be aligned.
+    bool bFailed = false;
+    long nMismatches = 0, nKeyPoints = 0;
+    vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel;
+    vector<vector<Descriptor>> vvDescriptorsPerLevel;
+    for(const Mat &image : vImages) {
+        imagePyramid.setImage(image);
+        keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+        distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+        descriptorComputer.describe(
+            vvDescriptorsPerLevel, vvDistributedKeyPointsPerLevel,
+            imagePyramid.mvImages, imagePyramid.mvBlurredImages, orientationComputer
+        );
+        Frame frame(image.size(), imagePyramid.mvfScaleFactors, vvDistributedKeyPointsPerLevel, vvDescriptorsPerLevel);
+
+        bool bAligned = (uintptr_t)frame.mpfX % 64 == 0 && (uintptr_t)frame.mpfY % 32 == 0 &&
+                        (uintptr_t)frame.mpfAngle % 32 == 0 && (uintptr_t)frame.mpfResponse % 32 == 0 &&
+                        (uintptr_t)frame.mpDescriptors % 32 == 0;
+        if(!bAligned) { bFailed = true; }
+
+        for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+            Frame::LevelView level = frame.getLevel(iLevel);
+            const vector<KeyPoint>& vKeyPoints = vvDistributedKeyPointsPerLevel[iLevel];
+            if(level.nKeyPoints != (int)vKeyPoints.size()) { bFailed = true; continue; }
+            float fScaleFactor = imagePyramid.mvfScaleFactors[iLevel];
+            for(int i = 0; i < level.nKeyPoints; i++) {
+                KeyPoint keyPoint = level.getKeyPoint(i);
+                KeyPoint frameKeyPoint = frame.getKeyPoint(frame.mvnLevelOffsets[iLevel] + i);
+                bool bMismatch = keyPoint.pt.x != vKeyPoints[i].pt.x * fScaleFactor ||
+                                 keyPoint.pt.y != vKeyPoints[i].pt.y * fScaleFactor ||
+                                 keyPoint.angle != vKeyPoints[i].angle ||
+                                 keyPoint.response != vKeyPoints[i].response ||
+                                 keyPoint.octave != iLevel ||
+                                 frameKeyPoint.pt.x != keyPoint.pt.x || frameKeyPoint.pt.y != keyPoint.pt.y ||
+                                 frameKeyPoint.octave != iLevel ||
+                                 level.pDescriptors[i] != vvDescriptorsPerLevel[iLevel][i];
+                nMismatches += bMismatch;
+            }
+            nKeyPoints += level.nKeyPoints;
+        }
+        if(frame.mnKeyPoints != frame.mvnLevelOffsets.back()) { bFailed = true; }
+    }
+
+    // Bytes per keypoint: KeyPoint + descriptor in vectors, against the arrays of the frame.
+    size_t nOldBytes = sizeof(KeyPoint) + sizeof(Descriptor);
+    size_t nNewBytes = 4 * sizeof(float) + sizeof(uint8_t) + sizeof(Descriptor);
+    printf(
+        "%ld keypoints, mismatches %ld, bytes per keypoint %zu (vectors of KeyPoint) -> %zu (arrays)\n",
+        nKeyPoints, nMismatches, nOldBytes, nNewBytes
+    );
+    if(nMismatches > 0) { bFailed = true; }
+
+    if(bFailed) {
+        printf("FAILED: the frame does not reproduce its keypoints and descriptors.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/Frame.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+#include <random>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief The reference for Frame::getFeaturesInArea: test every keypoint of the frame. */
+static void getFeaturesInAreaLinear(
+    vector<int>& vnIndices, const Frame& frame,
+    float fX, float fY, float fRadius, int nMinLevel, int nMaxLevel
+) {
+    vnIndices.clear();
+    for(int i = 0; i < frame.mnKeyPoints; i++) {
+        if(nMinLevel >= 0 && frame.mpnOctave[i] < nMinLevel) { continue; }
+        if(nMaxLevel >= 0 && frame.mpnOctave[i] > nMaxLevel) { continue; }
+        if(fabsf(frame.mpfX[i] - fX) < fRadius && fabsf(frame.mpfY[i] - fY) < fRadius)
+            vnIndices.push_back(i);
+    }
+}
+
+int main() {
+    // A synthetic textured image.
+    Mat image = createSyntheticImages(1)[0];
+
+    // A frame with about 2000 keypoints.
+    ImagePyramid imagePyramid(8, 1.2, 2000);
+    imagePyramid.enableBlurredPyramid();
+    KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+    Distributor distributor;
+    OrientationComputer orientationComputer(15);
+    DescriptorComputer descriptorComputer;
+
+    vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel;
+    vector<vector<Descriptor>> vvDescriptorsPerLevel;
+    imagePyramid.setImage(image);
+    keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+    distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+    descriptorComputer.describe(
+        vvDescriptorsPerLevel, vvDistributedKeyPointsPerLevel,
+        imagePyramid.mvImages, imagePyramid.mvBlurredImages, orientationComputer
+    );
+    Frame frame(image.size(), imagePyramid.mvfScaleFactors, vvDistributedKeyPointsPerLevel, vvDescriptorsPerLevel);
+
+    // Every keypoint is in exactly one cell.
+    bool bFailed = frame.mvnGridOffsets.back() != frame.mnKeyPoints;
+
+    // Random windows, some of them across the image border, as guided matching by projection does.
+    const int nQueries = 100000;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> x(-20.f, image.cols + 20.f), y(-20.f, image.rows + 20.f);
+    std::uniform_int_distribution<int> level(-1, imagePyramid.mnLevels - 1);
+    printf("%d keypoints, %d queries per radius\n", frame.mnKeyPoints, nQueries);
+
+    for(float fRadius : {7.5f, 15.f, 50.f, 100.f}) {
+        vector<float> vfX(nQueries), vfY(nQueries);
+        vector<int> vnMinLevel(nQueries), vnMaxLevel(nQueries);
+        for(int i = 0; i < nQueries; i++) {
+            vfX[i] = x(rng); vfY[i] = y(rng);
+            vnMinLevel[i] = level(rng); vnMaxLevel[i] = level(rng);
+            if(vnMaxLevel[i] >= 0 && vnMinLevel[i] > vnMaxLevel[i]) { swap(vnMinLevel[i], vnMaxLevel[i]); }
+        }
+
+        vector<int> vnGrid, vnLinear;
+        long nGridFound = 0, nLinearFound = 0, nMismatches = 0;
+        TimePoint t1 = chrono::steady_clock::now();
+        for(int i = 0; i < nQueries; i++) {
+            frame.getFeaturesInArea(vnGrid, vfX[i], vfY[i], fRadius, vnMinLevel[i], vnMaxLevel[i]);
+            nGridFound += vnGrid.size();
+        }
+        TimePoint t2 = chrono::steady_clock::now();
+        for(int i = 0; i < nQueries; i++) {
+            getFeaturesInAreaLinear(vnLinear, frame, vfX[i], vfY[i], fRadius, vnMinLevel[i], vnMaxLevel[i]);
+            nLinearFound += vnLinear.size();
+        }
+        TimePoint t3 = chrono::steady_clock::now();
+
+        // Same keypoints, in any order.
+        for(int i = 0; i < nQueries; i += 10) {
+            frame.getFeaturesInArea(vnGrid, vfX[i], vfY[i], fRadius, vnMinLevel[i], vnMaxLevel[i]);
+            getFeaturesInAreaLinear(vnLinear, frame, vfX[i], vfY[i], fRadius, vnMinLevel[i], vnMaxLevel[i]);
+            sort(vnGrid.begin(), vnGrid.end());
+            nMismatches += vnGrid != vnLinear;
+        }
+
+        double dGridTime = chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+        double dLinearTime = chrono::duration_cast<chrono::duration<double>>(t3 - t2).count();
+        printf(
+            "radius %5.1f: %.2f keypoints per query, grid %.3f us, linear scan %.3f us, speedup %.1fx, mismatches %ld\n",
+            fRadius, (double)nGridFound / nQueries, dGridTime / nQueries * 1e6, dLinearTime / nQueries * 1e6,
+            dLinearTime / dGridTime, nMismatches
+        );
+        if(nMismatches > 0 || nGridFound != nLinearFound) { bFailed = true; }
+    }
+
+    if(bFailed) {
+        printf("FAILED: the grid does not find the same keypoints as the linear scan.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
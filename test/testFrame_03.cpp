@@ -0,0 +1,171 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/Frame.h"
+#include "myORB-SLAM2/FramePool.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+#include <thread>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief Whether two frames hold the same keypoints, descriptors and grid. */
+static bool isSameFrame(const Frame& first, const Frame& second) {
+    int n = first.mnKeyPoints;
+    return n == second.mnKeyPoints && first.mvnLevelOffsets == second.mvnLevelOffsets &&
+           memcmp(first.mpfX, second.mpfX, n * sizeof(float)) == 0 &&
+           memcmp(first.mpfY, second.mpfY, n * sizeof(float)) == 0 &&
+           memcmp(first.mpfAngle, second.mpfAngle, n * sizeof(float)) == 0 &&
+           memcmp(first.mpfResponse, second.mpfResponse, n * sizeof(float)) == 0 &&
+           memcmp(first.mpnOctave, second.mpnOctave, n) == 0 &&
+           memcmp(first.mpDescriptors, second.mpDescriptors, n * sizeof(Descriptor)) == 0 &&
+           first.mvnGridOffsets == second.mvnGridOffsets && first.mvnGridIndices == second.mvnGridIndices;
+}
+
+int main() {
+    // Synthetic textured images.
+    vector<Mat> vImages = createSyntheticImages(10);
+
+    // Features of every image, computed once.
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    imagePyramid.enableBlurredPyramid();
+    KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+    Distributor distributor;
+    OrientationComputer orientationComputer(15);
+    DescriptorComputer descriptorComputer;
+
+    vector<vector<vector<KeyPoint>>> vvvKeyPointsPerImage(vImages.size());
+    vector<vector<vector<Descriptor>>> vvvDescriptorsPerImage(vImages.size());
+    vector<vector<KeyPoint>> vvKeyPointsPerLevel;
+    for(size_t iImage = 0; iImage < vImages.size(); iImage++) {
+        imagePyramid.setImage(vImages[iImage]);
+        keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+        distributor.distribute(vvvKeyPointsPerImage[iImage], vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+        descriptorComputer.describe(
+            vvvDescriptorsPerImage[iImage], vvvKeyPointsPerImage[iImage],
+            imagePyramid.mvImages, imagePyramid.mvBlurredImages, orientationComputer
+        );
+    }
+    Size imageSize = vImages[0].size();
+    const vector<float>& vfScaleFactors = imagePyramid.mvfScaleFactors;
+    bool bFailed = false;
+
+    // A long sequence where only the last 5 frames are kept: the pool holds 6 frames, and recycled frames
+    // hold exactly what a new frame would.
+    const int nFrames = 4000, nKeptFrames = 5;
+    {
+        FramePool framePool;
+        FramePtr recentFrames[nKeptFrames];
+        long nMismatches = 0;
+        for(int i = 0; i < nFrames; i++) {
+            int iImage = i % vImages.size();
+            recentFrames[i % nKeptFrames] = framePool.acquire(imageSize, vfScaleFactors, vvvKeyPointsPerImage[iImage], vvvDescriptorsPerImage[iImage]);
+            if(i % 97 == 0) {
+                Frame frame(imageSize, vfScaleFactors, vvvKeyPointsPerImage[iImage], vvvDescriptorsPerImage[iImage]);
+                nMismatches += !isSameFrame(*recentFrames[i % nKeptFrames], frame);
+            }
+        }
+        printf(
+            "Sliding window of %d frames over %d frames: %d resident frames, %d free, mismatches %ld\n",
+            nKeptFrames, nFrames, framePool.getResidentFrames(), framePool.getFreeFrames(), nMismatches
+        );
+        if(framePool.getResidentFrames() != nKeptFrames + 1 || nMismatches > 0) { bFailed = true; }
+    }
+
+    // The same sequence with new and delete, and with the pool.
+    {
+        FramePool framePool;
+        FramePtr recentPooledFrames[nKeptFrames];
+        Frame* pRecentFrames[nKeptFrames] = {};
+
+        TimePoint t1 = chrono::steady_clock::now();
+        for(int i = 0; i < nFrames; i++) {
+            int iImage = i % vImages.size();
+            delete pRecentFrames[i % nKeptFrames];
+            pRecentFrames[i % nKeptFrames] = new Frame(imageSize, vfScaleFactors, vvvKeyPointsPerImage[iImage], vvvDescriptorsPerImage[iImage]);
+        }
+        TimePoint t2 = chrono::steady_clock::now();
+        for(int i = 0; i < nFrames; i++) {
+            int iImage = i % vImages.size();
+            recentPooledFrames[i % nKeptFrames] = framePool.acquire(imageSize, vfScaleFactors, vvvKeyPointsPerImage[iImage], vvvDescriptorsPerImage[iImage]);
+        }
+        TimePoint t3 = chrono::steady_clock::now();
+        for(Frame* pFrame : pRecentFrames) { delete pFrame; }
+
+        printf(
+            "Frame creation: new/delete %.3f us, pool %.3f us\n",
+            chrono::duration_cast<chrono::duration<double>>(t2 - t1).count() / nFrames * 1e6,
+            chrono::duration_cast<chrono::duration<double>>(t3 - t2).count() / nFrames * 1e6
+        );
+    }
+
+    // The cap on resident frames.
+    {
+        FramePool framePool(3);
+        vector<FramePtr> vpFrames;
+        for(int i = 0; i < 3; i++)
+            vpFrames.push_back(framePool.acquire(imageSize, vfScaleFactors, vvvKeyPointsPerImage[i], vvvDescriptorsPerImage[i]));
+        FramePtr pOverCap = framePool.acquire(imageSize, vfScaleFactors, vvvKeyPointsPerImage[3], vvvDescriptorsPerImage[3]);
+        bool bCapped = !pOverCap && framePool.getResidentFrames() == 3;
+
+        // Releasing a frame makes room, and its storage is reused.
+        Frame* pReleased = vpFrames[0].get();
+        FramePtr pCopy = vpFrames[0];
+        vpFrames[0].reset();
+        bCapped &= framePool.getFreeFrames() == 0; // still referenced by the copy
+        pCopy.reset();
+        bCapped &= framePool.getFreeFrames() == 1;
+        FramePtr pReused = framePool.acquire(imageSize, vfScaleFactors, vvvKeyPointsPerImage[3], vvvDescriptorsPerImage[3]);
+        bCapped &= pReused.get() == pReleased;
+
+        // Lowering the cap deletes frames as they are released, shrink() deletes the free ones.
+        framePool.setMaxResidentFrames(1);
+        vpFrames.clear();
+        bCapped &= framePool.getResidentFrames() == 1 && framePool.getFreeFrames() == 0;
+        framePool.setMaxResidentFrames(0);
+        pReused.reset();
+        bCapped &= framePool.getFreeFrames() == 1;
+        framePool.shrink();
+        bCapped &= framePool.getResidentFrames() == 0;
+
+        printf("Resident frame cap respected: %s\n", bCapped ? "yes" : "no");
+        if(!bCapped) { bFailed = true; }
+    }
+
+    // A frame can outlive its pool.
+    FramePtr pSurvivor;
+    {
+        FramePool framePool;
+        pSurvivor = framePool.acquire(imageSize, vfScaleFactors, vvvKeyPointsPerImage[0], vvvDescriptorsPerImage[0]);
+    }
+    bFailed |= pSurvivor->mnKeyPoints != pSurvivor->mvnLevelOffsets.back();
+    pSurvivor.reset();
+
+    // Frames released on other threads while their pool is destroyed either go back to the pool first
+    // or are deleted by their last FramePtr (run with a thread or address sanitizer to check it).
+    for(int iRound = 0; iRound < 200; iRound++) {
+        vector<thread> vThreads;
+        {
+            FramePool framePool;
+            for(int i = 0; i < 4; i++) {
+                FramePtr pFrame = framePool.acquire(imageSize, vfScaleFactors, vvvKeyPointsPerImage[i], vvvDescriptorsPerImage[i]);
+                vThreads.emplace_back([pFrame]() mutable { pFrame.reset(); });
+            }
+        }
+        for(thread &t : vThreads)
+            t.join();
+    }
+
+    if(bFailed) {
+        printf("FAILED: the frame pool does not recycle frames correctly.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/GaussianFilter.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+#include <random>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief The reference of GaussianFilter: the 7x7 kernel with weights (54, 49, 34, 18) / 256 in both directions,
+reflect-101 borders, the horizontal sums kept exact and the result rounded once after the vertical pass.
+
+@param[in] image: The 8-bit image to be blurred.
+@param[in, out] blurredImage: The blurred image. */
+void blurReference(const Mat& image, Mat& blurredImage) {
+    const int kernel[7] = {18, 34, 49, 54, 49, 34, 18};
+    auto reflect = [](int i, int n) { return i < 0 ? -i : (i >= n ? 2 * n - 2 - i : i); };
+
+    Mat horizontal(image.size(), CV_32S);
+    for(int iY = 0; iY < image.rows; iY++)
+        for(int iX = 0; iX < image.cols; iX++) {
+            int sum = 0;
+            for(int i = -3; i <= 3; i++)
+                sum += kernel[i + 3] * image.at<uchar>(iY, reflect(iX + i, image.cols));
+            horizontal.at<int>(iY, iX) = sum;
+        }
+
+    blurredImage.create(image.size(), CV_8U);
+    for(int iY = 0; iY < image.rows; iY++)
+        for(int iX = 0; iX < image.cols; iX++) {
+            int sum = 0;
+            for(int i = -3; i <= 3; i++)
+                sum += kernel[i + 3] * horizontal.at<int>(reflect(iY + i, image.rows), iX);
+            blurredImage.at<uchar>(iY, iX) = (uchar)((sum + (1 << 15)) >> 16);
+        }
+}
+
+/*
+@brief The number of different bits between two descriptors.
+
+@param[in] a: The first descriptor.
+@param[in] b: The second descriptor. */
+int computeHammingDistance(const Descriptor& a, const Descriptor& b) {
+    int nBits = 0;
+    for(int i = 0; i < NBPD; ++i)
+        nBits += __builtin_popcount(a[i] ^ b[i]);
+    return nBits;
+}
+
+/*
+@brief The number of pixels that differ between two images of the same size.
+
+@param[in] a: The first image.
+@param[in] b: The second image. */
+long countDifferentPixels(const Mat& a, const Mat& b) {
+    long nPixels = 0;
+    for(int iY = 0; iY < a.rows; iY++)
+        for(int iX = 0; iX < a.cols; iX++)
+            nPixels += a.at<uchar>(iY, iX) != b.at<uchar>(iY, iX);
+    return nPixels;
+}
+
+int main() {
+    vector<Mat> vImages = createSyntheticImages(3);
+    GaussianFilter gaussianFilter, fixedPointFilter(GaussianFilter::FIXED_POINT);
+    bool bFailed = false;
+
+    // Random images, for sizes down to the 4 pixels reflect-101 needs and for the SIMD body and the scalar tail.
+    std::mt19937 rng(0);
+    vector<Mat> vTestImages = vImages;
+    for(int i = 0; i < 40; i++) {
+        int nRows = i < 20 ? 4 + i : 20 + rng() % 200, nCols = i < 20 ? 4 + (i * 7) % 41 : 20 + rng() % 500;
+        Mat image(nRows, nCols, CV_8U);
+        for(int iY = 0; iY < nRows; iY++)
+            for(int iX = 0; iX < nCols; iX++)
+                image.at<uchar>(iY, iX) = (uchar)(rng() % 256);
+        vTestImages.push_back(image);
+    }
+
+    // By default the filter is GaussianBlur, also on a view into a larger image: it reflects at the view's own border.
+    long nOpenCVMismatches = 0;
+    Mat blurredImage, openCVImage, referenceImage;
+    for(const Mat &image : vTestImages) {
+        Mat padded(image.rows + 8, image.cols + 8, CV_8U, Scalar(255));
+        Mat view = padded(Rect(4, 4, image.cols, image.rows));
+        image.copyTo(view);
+
+        gaussianFilter.apply(view, blurredImage);
+        GaussianBlur(image, openCVImage, Size(7, 7), 2, 2, BORDER_REFLECT_101);
+        nOpenCVMismatches += countDifferentPixels(blurredImage, openCVImage);
+    }
+    printf("Pixels that differ from GaussianBlur by default: %ld\n", nOpenCVMismatches);
+    if(nOpenCVMismatches != 0) { bFailed = true; }
+
+    // The fixed-point filter is pinned to its reference.
+    long nReferenceMismatches = 0;
+    for(const Mat &image : vTestImages) {
+        fixedPointFilter.apply(image, blurredImage);
+        blurReference(image, referenceImage);
+        nReferenceMismatches += countDifferentPixels(blurredImage, referenceImage);
+    }
+    printf("Pixels that differ from the fixed-point reference: %ld\n", nReferenceMismatches);
+    if(nReferenceMismatches != 0) { bFailed = true; }
+
+    // Both implementations write exactly the pixels of apply when a region is blurred or the rows are pushed one at a time.
+    long nRegionMismatches = 0, nStreamMismatches = 0;
+    for(GaussianFilter* pFilter : {&gaussianFilter, &fixedPointFilter}) {
+        for(const Mat &image : vTestImages) {
+            pFilter->apply(image, referenceImage);
+
+            Mat regionImage(image.size(), CV_8U, Scalar(0));
+            int iX = rng() % image.cols, iY = rng() % image.rows;
+            Rect roi(iX, iY, 1 + rng() % (image.cols - iX), 1 + rng() % (image.rows - iY));
+            pFilter->applyRegion(image, regionImage, roi);
+            nRegionMismatches += countDifferentPixels(regionImage(roi), referenceImage(roi));
+
+            Mat streamedImage;
+            pFilter->begin(image.size(), streamedImage);
+            for(int iRow = 0; iRow < image.rows; iRow++)
+                pFilter->pushRow(image.ptr<uchar>(iRow));
+            pFilter->end();
+            nStreamMismatches += countDifferentPixels(streamedImage, referenceImage);
+        }
+    }
+    printf("Pixels that differ from apply: regions %ld, pushed rows %ld\n", nRegionMismatches, nStreamMismatches);
+    if(nRegionMismatches != 0 || nStreamMismatches != 0) { bFailed = true; }
+
+    // GaussianBlur rounds its weights differently, so a pixel of the fixed-point filter may differ from it
+    // by one intensity level, never more.
+    long nPixels = 0, nOffByOne = 0;
+    int nMaxDifference = 0;
+    for(const Mat &image : vTestImages) {
+        fixedPointFilter.apply(image, blurredImage);
+        GaussianBlur(image, openCVImage, Size(7, 7), 2, 2, BORDER_REFLECT_101);
+        for(int iY = 0; iY < image.rows; iY++)
+            for(int iX = 0; iX < image.cols; iX++) {
+                int nDifference = abs(blurredImage.at<uchar>(iY, iX) - openCVImage.at<uchar>(iY, iX));
+                nMaxDifference = max(nMaxDifference, nDifference);
+                nOffByOne += nDifference != 0;
+            }
+        nPixels += image.total();
+    }
+    printf("Pixels of the fixed-point filter that differ from GaussianBlur: %.2f%%, largest difference %d\n", 100.0 * nOffByOne / nPixels, nMaxDifference);
+    if(nMaxDifference > 1) { bFailed = true; }
+
+    // By default compute() gives exactly the descriptors of GaussianBlur on each level. With the fixed-point blur
+    // those pixels flip a few intensity comparisons, so only a small share of the bits may change.
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+    Distributor distributor;
+    OrientationComputer orientationComputer(15);
+    DescriptorComputer descriptorComputer, fixedPointComputer;
+    fixedPointComputer.setFixedPointBlur(true);
+
+    vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel;
+    vector<vector<Descriptor>> vvDescriptors, vvFixedPointDescriptors, vvOpenCVDescriptors;
+    vector<Mat> vOpenCVImages;
+    long nBits = 0, nDefaultFlippedBits = 0, nFlippedBits = 0;
+    for(const Mat &image : vImages) {
+        imagePyramid.setImage(image);
+        keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+        distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+        orientationComputer.compute(vvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+
+        // Each level is blurred on its own, as if it were not a view into the pyramid's atlas.
+        vOpenCVImages.resize(imagePyramid.mnLevels);
+        for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++)
+            GaussianBlur(imagePyramid.mvImages[iLevel].clone(), vOpenCVImages[iLevel], Size(7, 7), 2, 2);
+        descriptorComputer.compute(vvDescriptors, vvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+        fixedPointComputer.compute(vvFixedPointDescriptors, vvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+        descriptorComputer.computeBlurred(vvOpenCVDescriptors, vvDistributedKeyPointsPerLevel, vOpenCVImages);
+
+        for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++)
+            for(size_t i = 0; i < vvOpenCVDescriptors[iLevel].size(); i++) {
+                nDefaultFlippedBits += computeHammingDistance(vvDescriptors[iLevel][i], vvOpenCVDescriptors[iLevel][i]);
+                nFlippedBits += computeHammingDistance(vvFixedPointDescriptors[iLevel][i], vvOpenCVDescriptors[iLevel][i]);
+                nBits += 8 * NBPD;
+            }
+    }
+    printf("Descriptor bits that differ from GaussianBlur: default %ld, fixed point %.2f%%\n", nDefaultFlippedBits, 100.0 * nFlippedBits / max(nBits, 1L));
+    if(nBits == 0 || nDefaultFlippedBits != 0 || nFlippedBits > nBits / 20) { bFailed = true; }
+
+    printf("%s\n", bFailed ? "FAILED" : "PASSED");
+    return bFailed ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "myORB-SLAM2/Frame.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief Check that two 8-bit images are bit for bit identical.
+
+@param[in] a: The first image.
+@param[in] b: The second image. */
+bool isIdentical(const Mat& a, const Mat& b) {
+    if(a.size() != b.size()) { return false; }
+    for(int iY = 0; iY < a.rows; iY++)
+        if(memcmp(a.ptr<uchar>(iY), b.ptr<uchar>(iY), a.cols) != 0) { return false; }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    // Test images: optional frames from an image sequence, otherwise synthetic textured images.
+    vector<Mat> vImages = loadTestImages(argc, argv, 50, 20);
+
+    // Same pyramid twice: one blurs each level by itself, the other builds the blurred pyramid in the same pass.
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    ImagePyramid blurredImagePyramid(8, 1.2, 1200);
+    blurredImagePyramid.enableBlurredPyramid();
+
+    KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+    Distributor distributor;
+    OrientationComputer orientationComputer(15);
+    DescriptorComputer descriptorComputer, blurredDescriptorComputer;
+
+    vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel;
+    vector<vector<Descriptor>> vvDescriptorsPerLevel, vvBlurredDescriptorsPerLevel;
+    Mat blurredImage;
+
+    double dSeparateTime = 0.0, dFusedTime = 0.0;
+    long nImageMismatches = 0, nDescriptorMismatches = 0;
+    for(const Mat &image : vImages) {
+        // Separate passes: build the pyramid, then blur every level inside DescriptorComputer::compute.
+        imagePyramid.setImage(image);
+        keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+        distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+        orientationComputer.compute(vvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+
+        TimePoint t1 = chrono::steady_clock::now();
+        imagePyramid.setImage(image);
+        descriptorComputer.compute(vvDescriptorsPerLevel, vvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+        TimePoint t2 = chrono::steady_clock::now();
+
+        // Fused pass: the blurred pyramid is built with the pyramid and used as is.
+        blurredImagePyramid.setImage(image);
+        blurredDescriptorComputer.computeBlurred(vvBlurredDescriptorsPerLevel, vvDistributedKeyPointsPerLevel, blurredImagePyramid.mvBlurredImages);
+        TimePoint t3 = chrono::steady_clock::now();
+
+        dSeparateTime += chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+        dFusedTime += chrono::duration_cast<chrono::duration<double>>(t3 - t2).count();
+
+        // Both pyramids, the blurred levels and the descriptors must be identical.
+        for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+            descriptorComputer.blur(imagePyramid.mvImages[iLevel], blurredImage);
+            nImageMismatches += !isIdentical(imagePyramid.mvImages[iLevel], blurredImagePyramid.mvImages[iLevel]);
+            nImageMismatches += !isIdentical(blurredImage, blurredImagePyramid.mvBlurredImages[iLevel]);
+            nDescriptorMismatches += vvDescriptorsPerLevel[iLevel] != vvBlurredDescriptorsPerLevel[iLevel];
+        }
+    }
+
+    printf("Pyramid and descriptors (%zu frames): \n", vImages.size());
+    printf(" - separate blur: %.3f ms\n", dSeparateTime / vImages.size() * 1e3);
+    printf(" - blurred pyramid: %.3f ms\n", dFusedTime / vImages.size() * 1e3);
+    printf(" - mismatched images: %ld, mismatched descriptor levels: %ld\n", nImageMismatches, nDescriptorMismatches);
+
+    if(nImageMismatches > 0 || nDescriptorMismatches > 0) {
+        printf("FAILED: the blurred pyramid differs from blurring each level.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
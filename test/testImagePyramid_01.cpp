@@ -0,0 +1,145 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief Copy an image into a new buffer with a replicated border and a different row stride, and return the interior.
+
+@param[in] image: The 8-bit image.
+@param[in] nBorder: The width of the border. */
+Mat copyWithBorder(const Mat& image, int nBorder) {
+    Mat padded(image.rows + 2 * nBorder, image.cols + 2 * nBorder + 7, CV_8U);
+    for(int iY = 0; iY < padded.rows; iY++)
+        for(int iX = 0; iX < padded.cols; iX++)
+            padded.at<uchar>(iY, iX) = image.at<uchar>(
+                min(max(iY - nBorder, 0), image.rows - 1), min(max(iX - nBorder, 0), image.cols - 1)
+            );
+    return padded(Rect(nBorder, nBorder, image.cols, image.rows));
+}
+
+/*
+@brief Check that a level and its border in the atlas are exactly the reference image with a replicated border.
+
+@param[in] level: The level in the atlas.
+@param[in] reference: The expected level.
+@param[in] nBorder: The width of the border. */
+bool isReplicated(const Mat& level, const Mat& reference, int nBorder) {
+    if(level.size() != reference.size()) { return false; }
+    for(int iY = -nBorder; iY < level.rows + nBorder; iY++) {
+        const uchar* pRow = level.ptr<uchar>(0) + iY * (ptrdiff_t)level.step;
+        const uchar* pReferenceRow = reference.ptr<uchar>(min(max(iY, 0), reference.rows - 1));
+        for(int iX = -nBorder; iX < level.cols + nBorder; iX++)
+            if(pRow[iX] != pReferenceRow[min(max(iX, 0), reference.cols - 1)]) { return false; }
+    }
+    return true;
+}
+
+int main() {
+    // Synthetic textured images, with strong texture up to the image border.
+    vector<Mat> vImages = createSyntheticImages(5);
+
+    const int nBorder = 19;
+    ImagePyramid imagePyramid(8, 1.2, 1200, nBorder);
+    imagePyramid.enableBlurredPyramid();
+    GaussianFilter gaussianFilter;
+
+    // The levels are headers into one allocation, aligned to 64 bytes, and hold exactly the nearest-neighbour
+    // pyramid with replicated borders. The blurred levels are the blurred pyramid with replicated borders.
+    bool bFailed = false;
+    long nLevelMismatches = 0;
+    for(const Mat &image : vImages) {
+        imagePyramid.setImage(image);
+        const uchar* pDataStart = imagePyramid.mvImages[0].datastart;
+        Mat reference = image, blurredReference;
+        for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+            const Mat &level = imagePyramid.mvImages[iLevel], &blurredLevel = imagePyramid.mvBlurredImages[iLevel];
+            if(iLevel > 0) {
+                Mat resized;
+                resize(reference, resized, level.size(), 0, 0, INTER_NEAREST);
+                reference = resized;
+            }
+            gaussianFilter.apply(reference, blurredReference);
+
+            bool bShared = level.datastart == pDataStart && blurredLevel.datastart == pDataStart;
+            bool bAligned = (level.data - pDataStart) % 64 == 0 && (blurredLevel.data - pDataStart) % 64 == 0 && level.step % 64 == 0;
+            nLevelMismatches += !bShared || !bAligned ||
+                                !isReplicated(level, reference, nBorder) || !isReplicated(blurredLevel, blurredReference, nBorder);
+        }
+    }
+    printf("Levels that are not replicated, aligned headers into the atlas: %ld\n", nLevelMismatches);
+    if(nLevelMismatches > 0) { bFailed = true; }
+
+    // With the border, keypoints may lie next to the image border (3 pixels for FAST instead of 19 for the patches).
+    // Their orientations and descriptors must read the border exactly like a separately padded copy of the levels.
+    KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 3, imagePyramid.mnFeatures, 20, 7);
+    Distributor distributor;
+    OrientationComputer orientationComputer(15);
+    vector<DescriptorComputer::Instruction> vInstructions = {DescriptorComputer::SCALAR};
+    if(DescriptorComputer::isSupported(DescriptorComputer::AVX2)) { vInstructions.push_back(DescriptorComputer::AVX2); }
+
+    long nEdgeKeyPoints = 0, nKeyPointMismatches = 0;
+    vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel, vvCopiedKeyPointsPerLevel;
+    vector<vector<Descriptor>> vvDescriptorsPerLevel, vvCopiedDescriptorsPerLevel;
+    for(const Mat &image : vImages) {
+        imagePyramid.setImage(image);
+        keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+        distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+
+        vector<Mat> vCopiedImages, vCopiedBlurredImages;
+        for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+            vCopiedImages.push_back(copyWithBorder(imagePyramid.mvImages[iLevel], nBorder));
+            vCopiedBlurredImages.push_back(copyWithBorder(imagePyramid.mvBlurredImages[iLevel], nBorder));
+            for(const KeyPoint &keyPoint : vvDistributedKeyPointsPerLevel[iLevel]) {
+                const Mat &level = imagePyramid.mvImages[iLevel];
+                nEdgeKeyPoints += keyPoint.pt.x < 19 || keyPoint.pt.y < 19 || keyPoint.pt.x >= level.cols - 19 || keyPoint.pt.y >= level.rows - 19;
+            }
+        }
+
+        for(DescriptorComputer::Instruction eInstruction : vInstructions) {
+            for(int nAngleBins : {0, 30}) {
+                DescriptorComputer descriptorComputer(eInstruction);
+                descriptorComputer.setAngleBins(nAngleBins);
+                vvCopiedKeyPointsPerLevel = vvDistributedKeyPointsPerLevel;
+                descriptorComputer.describe(
+                    vvDescriptorsPerLevel, vvDistributedKeyPointsPerLevel,
+                    imagePyramid.mvImages, imagePyramid.mvBlurredImages, orientationComputer
+                );
+                descriptorComputer.describe(
+                    vvCopiedDescriptorsPerLevel, vvCopiedKeyPointsPerLevel,
+                    vCopiedImages, vCopiedBlurredImages, orientationComputer
+                );
+                for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++)
+                    for(size_t i = 0; i < vvDescriptorsPerLevel[iLevel].size(); i++)
+                        nKeyPointMismatches += vvDescriptorsPerLevel[iLevel][i] != vvCopiedDescriptorsPerLevel[iLevel][i] ||
+                                               vvDistributedKeyPointsPerLevel[iLevel][i].angle != vvCopiedKeyPointsPerLevel[iLevel][i].angle;
+
+                // compute() blurs into its own buffers, whose border is as wide as the pattern, with or without local smoothing.
+                for(bool bLocalSmoothing : {false, true}) {
+                    descriptorComputer.setLocalSmoothing(bLocalSmoothing);
+                    descriptorComputer.compute(vvCopiedDescriptorsPerLevel, vvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+                    for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++)
+                        for(size_t i = 0; i < vvDescriptorsPerLevel[iLevel].size(); i++)
+                            nKeyPointMismatches += vvDescriptorsPerLevel[iLevel][i] != vvCopiedDescriptorsPerLevel[iLevel][i];
+                }
+            }
+        }
+    }
+    printf("Keypoints within 19 pixels of the border: %ld, mismatches with padded copies and compute(): %ld\n", nEdgeKeyPoints, nKeyPointMismatches);
+    if(nEdgeKeyPoints == 0 || nKeyPointMismatches > 0) { bFailed = true; }
+
+    if(bFailed) {
+        printf("FAILED: the padded pyramid differs from the reference.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
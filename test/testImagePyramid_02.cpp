@@ -0,0 +1,181 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief Area-average an image to a smaller size in double precision, the reference for ImagePyramid::AREA.
+
+@param[in] image: The 8-bit image.
+@param[in] size: The size of the result. */
+Mat resizeAreaReference(const Mat& image, Size size) {
+    double dScaleX = (double)image.cols / size.width, dScaleY = (double)image.rows / size.height;
+    Mat result(size, CV_8U);
+    for(int iY = 0; iY < size.height; iY++) {
+        double dY0 = iY * dScaleY, dY1 = min((iY + 1) * dScaleY, (double)image.rows);
+        for(int iX = 0; iX < size.width; iX++) {
+            double dX0 = iX * dScaleX, dX1 = min((iX + 1) * dScaleX, (double)image.cols);
+            double dSum = 0.0;
+            for(int j = (int)floor(dY0); j < (int)ceil(dY1); j++) {
+                double dWeightY = min(j + 1.0, dY1) - max((double)j, dY0);
+                for(int i = (int)floor(dX0); i < (int)ceil(dX1); i++)
+                    dSum += dWeightY * (min(i + 1.0, dX1) - max((double)i, dX0)) * image.at<uchar>(j, i);
+            }
+            result.at<uchar>(iY, iX) = (uchar)cvRound(dSum / ((dX1 - dX0) * (dY1 - dY0)));
+        }
+    }
+    return result;
+}
+
+/*
+@brief The standard deviation of the pixels of an image.
+
+@param[in] image: The 8-bit image. */
+double standardDeviation(const Mat& image) {
+    double dSum = 0.0, dSquareSum = 0.0;
+    for(int iY = 0; iY < image.rows; iY++)
+        for(int iX = 0; iX < image.cols; iX++) {
+            double dValue = image.at<uchar>(iY, iX);
+            dSum += dValue;
+            dSquareSum += dValue * dValue;
+        }
+    double dCount = (double)image.rows * image.cols;
+    return sqrt(max(dSquareSum / dCount - (dSum / dCount) * (dSum / dCount), 0.0));
+}
+
+/*
+@brief Whether two images hold the same pixels.
+
+@param[in] a, b: The 8-bit images. */
+bool isEqual(const Mat& a, const Mat& b) {
+    if(a.size() != b.size()) { return false; }
+    for(int iY = 0; iY < a.rows; iY++)
+        if(memcmp(a.ptr<uchar>(iY), b.ptr<uchar>(iY), a.cols) != 0) { return false; }
+    return true;
+}
+
+int main() {
+    // Synthetic textured images.
+    vector<Mat> vImages = createSyntheticImages(5);
+
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    imagePyramid.enableBlurredPyramid();
+    bool bFailed = false;
+
+    // The fixed-point area kernel stays within one intensity level of the exact area average, and keeps flat images flat.
+    imagePyramid.setInterpolation(ImagePyramid::AREA);
+    int nMaxError = 0;
+    double dErrorSum = 0.0, dPixels = 0.0;
+    for(const Mat &image : vImages) {
+        imagePyramid.setImage(image);
+        for(int iLevel = 1; iLevel < imagePyramid.mnLevels; iLevel++) {
+            const Mat &level = imagePyramid.mvImages[iLevel];
+            Mat reference = resizeAreaReference(image, level.size());
+            for(int iY = 0; iY < level.rows; iY++)
+                for(int iX = 0; iX < level.cols; iX++) {
+                    int nError = abs((int)level.at<uchar>(iY, iX) - (int)reference.at<uchar>(iY, iX));
+                    nMaxError = max(nMaxError, nError);
+                    dErrorSum += nError;
+                }
+            dPixels += (double)level.rows * level.cols;
+        }
+    }
+    Mat flat(376, 1241, CV_8U, Scalar(173));
+    imagePyramid.setImage(flat);
+    bool bFlat = true;
+    for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++)
+        bFlat &= isEqual(imagePyramid.mvImages[iLevel], Mat(imagePyramid.mvImages[iLevel].size(), CV_8U, Scalar(173)));
+    printf("Area kernel vs double precision: max error %d, mean error %.4f, flat image kept: %s\n", nMaxError, dErrorSum / dPixels, bFlat ? "yes" : "no");
+    if(nMaxError > 1 || !bFlat) { bFailed = true; }
+
+    // Fine stripes (2 pixels wide) alias into coarse patterns with nearest neighbour, and average out with the area kernel.
+    Mat stripes(376, 1241, CV_8U);
+    for(int iY = 0; iY < stripes.rows; iY++)
+        for(int iX = 0; iX < stripes.cols; iX++)
+            stripes.at<uchar>(iY, iX) = ((iX / 2) % 2) ? 208 : 48;
+    double vdDeviations[2][8];
+    for(ImagePyramid::Interpolation eInterpolation : {ImagePyramid::NEAREST, ImagePyramid::AREA}) {
+        imagePyramid.setInterpolation(eInterpolation);
+        imagePyramid.setImage(stripes);
+        for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++)
+            vdDeviations[eInterpolation][iLevel] = standardDeviation(imagePyramid.mvImages[iLevel]);
+    }
+    printf("Standard deviation of the stripes per level (nearest / area):");
+    for(int iLevel = 1; iLevel < imagePyramid.mnLevels; iLevel++) {
+        printf(" %.1f/%.1f", vdDeviations[ImagePyramid::NEAREST][iLevel], vdDeviations[ImagePyramid::AREA][iLevel]);
+        if(vdDeviations[ImagePyramid::AREA][iLevel] >= vdDeviations[ImagePyramid::NEAREST][iLevel]) { bFailed = true; }
+    }
+    printf("\n");
+
+    // Building the pyramid on the extractor's threads gives the same pyramid and keypoints as building it first.
+    const int nThreads = 4, nRepeats = 20;
+    for(ImagePyramid::Interpolation eInterpolation : {ImagePyramid::NEAREST, ImagePyramid::AREA}) {
+        for(KeyPointExtractor::Mode eMode : {KeyPointExtractor::GRID_FAST, KeyPointExtractor::SCORE_MAP}) {
+            ImagePyramid serialPyramid(8, 1.2, 1200), pipelinedPyramid(8, 1.2, 1200);
+            serialPyramid.enableBlurredPyramid();
+            pipelinedPyramid.enableBlurredPyramid();
+            serialPyramid.setInterpolation(eInterpolation);
+            pipelinedPyramid.setInterpolation(eInterpolation);
+            KeyPointExtractor serialExtractor(serialPyramid.mnLevels, 30.0f, 19, serialPyramid.mnFeatures, 20, 7, eMode);
+            KeyPointExtractor pipelinedExtractor(pipelinedPyramid.mnLevels, 30.0f, 19, pipelinedPyramid.mnFeatures, 20, 7, eMode);
+            serialExtractor.setThreads(nThreads);
+            pipelinedExtractor.setThreads(nThreads);
+
+            long nLevelMismatches = 0, nKeyPointMismatches = 0, nKeyPoints = 0;
+            vector<vector<KeyPoint>> vvSerialKeyPoints, vvPipelinedKeyPoints;
+            for(const Mat &image : vImages) {
+                serialPyramid.setImage(image);
+                serialExtractor.extract(vvSerialKeyPoints, serialPyramid.mvImages);
+                pipelinedExtractor.extract(vvPipelinedKeyPoints, pipelinedPyramid, image);
+
+                for(int iLevel = 0; iLevel < serialPyramid.mnLevels; iLevel++) {
+                    nLevelMismatches += !pipelinedPyramid.isLevelReady(iLevel) ||
+                                        !isEqual(serialPyramid.mvImages[iLevel], pipelinedPyramid.mvImages[iLevel]) ||
+                                        !isEqual(serialPyramid.mvBlurredImages[iLevel], pipelinedPyramid.mvBlurredImages[iLevel]);
+                    const vector<KeyPoint> &vSerial = vvSerialKeyPoints[iLevel], &vPipelined = vvPipelinedKeyPoints[iLevel];
+                    nKeyPoints += vSerial.size();
+                    if(vSerial.size() != vPipelined.size()) { nKeyPointMismatches += max(vSerial.size(), vPipelined.size()); continue; }
+                    for(size_t i = 0; i < vSerial.size(); i++)
+                        nKeyPointMismatches += vSerial[i].pt.x != vPipelined[i].pt.x || vSerial[i].pt.y != vPipelined[i].pt.y ||
+                                               vSerial[i].response != vPipelined[i].response;
+                }
+            }
+
+            // Time the pyramid and the extraction, built first and built on the extractor's threads.
+            double dSerialTime = 0.0, dPipelinedTime = 0.0;
+            for(int iRepeat = 0; iRepeat < nRepeats; iRepeat++) {
+                for(const Mat &image : vImages) {
+                    auto start = chrono::steady_clock::now();
+                    serialPyramid.setImage(image);
+                    serialExtractor.extract(vvSerialKeyPoints, serialPyramid.mvImages);
+                    auto middle = chrono::steady_clock::now();
+                    pipelinedExtractor.extract(vvPipelinedKeyPoints, pipelinedPyramid, image);
+                    auto end = chrono::steady_clock::now();
+                    dSerialTime += chrono::duration<double, milli>(middle - start).count();
+                    dPipelinedTime += chrono::duration<double, milli>(end - middle).count();
+                }
+            }
+            int nFrames = nRepeats * vImages.size();
+
+            printf(
+                "%s, %s, %d threads: pyramid then extraction %.3f ms, pipelined %.3f ms, keypoints %ld, level mismatches %ld, keypoint mismatches %ld\n",
+                eInterpolation == ImagePyramid::AREA ? "area" : "nearest", eMode == KeyPointExtractor::SCORE_MAP ? "score map" : "grid FAST",
+                nThreads, dSerialTime / nFrames, dPipelinedTime / nFrames, nKeyPoints, nLevelMismatches, nKeyPointMismatches
+            );
+            if(nKeyPoints == 0 || nLevelMismatches > 0 || nKeyPointMismatches > 0) { bFailed = true; }
+        }
+    }
+
+    if(bFailed) {
+        printf("FAILED: the area pyramid or the pipelined extraction differs from the reference.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/RowBandSource.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief Whether two levels in the atlas hold the same pixels, including their borders.
+
+@param[in] a, b: The levels.
+@param[in] nBorder: The width of the border. */
+bool isEqualWithBorder(const Mat& a, const Mat& b, int nBorder) {
+    if(a.size() != b.size()) { return false; }
+    for(int iY = -nBorder; iY < a.rows + nBorder; iY++) {
+        const uchar* pRowA = a.ptr<uchar>(0) + iY * (ptrdiff_t)a.step - nBorder;
+        const uchar* pRowB = b.ptr<uchar>(0) + iY * (ptrdiff_t)b.step - nBorder;
+        if(memcmp(pRowA, pRowB, a.cols + 2 * nBorder) != 0) { return false; }
+    }
+    return true;
+}
+
+int main() {
+    // Synthetic textured frames, saved as the files the band source reads.
+    vector<Mat> vImages = createSyntheticImages(3);
+    vector<string> vPaths;
+    bool bFailed = false;
+    for(size_t i = 0; i < vImages.size(); i++) {
+        vPaths.push_back("testKeyPointExtractor_00_" + to_string(i) + ".pgm");
+        if(!RowBandSource::savePGM(vPaths.back(), vImages[i])) { bFailed = true; }
+    }
+
+    // Streaming the bands gives the same pyramid (with borders and blurred levels) and the same keypoints
+    // as setting the whole image, for any band height, interpolation and extraction mode.
+    const int nBorder = 19, nThreads = 2;
+    RowBandSource source;
+    Mat band, image;
+    for(ImagePyramid::Interpolation eInterpolation : {ImagePyramid::NEAREST, ImagePyramid::AREA}) {
+        for(KeyPointExtractor::Mode eMode : {KeyPointExtractor::GRID_FAST, KeyPointExtractor::SCORE_MAP}) {
+            ImagePyramid wholePyramid(8, 1.2, 1200, nBorder), streamedPyramid(8, 1.2, 1200, nBorder);
+            for(ImagePyramid* pImagePyramid : {&wholePyramid, &streamedPyramid}) {
+                pImagePyramid->enableBlurredPyramid();
+                pImagePyramid->setInterpolation(eInterpolation);
+            }
+            KeyPointExtractor wholeExtractor(8, 30.0f, 3, 1200, 20, 7, eMode), streamedExtractor(8, 30.0f, 3, 1200, 20, 7, eMode);
+            wholeExtractor.setThreads(nThreads);
+            streamedExtractor.setThreads(nThreads);
+
+            long nLevelMismatches = 0, nKeyPointMismatches = 0, nKeyPoints = 0;
+            vector<vector<KeyPoint>> vvWholeKeyPoints, vvStreamedKeyPoints;
+            for(const string &path : vPaths) {
+                for(int nBandRows : {1, 7, 16, 64}) {
+                    if(!source.open(path, nBandRows)) { bFailed = true; continue; }
+                    image.create(source.mnRows, source.mnCols, CV_8U);
+                    streamedExtractor.beginStream(streamedPyramid, Size(source.mnCols, source.mnRows));
+                    while(source.nextBand(band)) {
+                        Mat rows = image.rowRange(source.mnDeliveredRows - band.rows, source.mnDeliveredRows);
+                        band.copyTo(rows);
+                        streamedExtractor.pushRows(band);
+                    }
+                    streamedExtractor.endStream(vvStreamedKeyPoints);
+
+                    wholePyramid.setImage(image);
+                    wholeExtractor.extract(vvWholeKeyPoints, wholePyramid.mvImages);
+
+                    for(int iLevel = 0; iLevel < wholePyramid.mnLevels; iLevel++) {
+                        nLevelMismatches += !streamedPyramid.isLevelReady(iLevel) ||
+                                            streamedPyramid.getAvailableRows(iLevel) != streamedPyramid.mvImages[iLevel].rows ||
+                                            !isEqualWithBorder(wholePyramid.mvImages[iLevel], streamedPyramid.mvImages[iLevel], nBorder) ||
+                                            !isEqualWithBorder(wholePyramid.mvBlurredImages[iLevel], streamedPyramid.mvBlurredImages[iLevel], nBorder);
+                        nKeyPoints += vvWholeKeyPoints[iLevel].size();
+                    }
+                    nKeyPointMismatches += countMismatches(vvWholeKeyPoints, vvStreamedKeyPoints);
+                }
+            }
+
+            printf(
+                "%s, %s: keypoints %ld, level mismatches %ld, keypoint mismatches %ld\n",
+                eInterpolation == ImagePyramid::AREA ? "area" : "nearest", eMode == KeyPointExtractor::SCORE_MAP ? "score map" : "grid FAST",
+                nKeyPoints, nLevelMismatches, nKeyPointMismatches
+            );
+            if(nKeyPoints == 0 || nLevelMismatches > 0 || nKeyPointMismatches > 0) { bFailed = true; }
+        }
+    }
+
+    // Latency from the arrival of the last line to the keypoints, with lines arriving every 200 us:
+    // waiting for the whole frame, against extracting while the bands arrive. Timings depend on the machine,
+    // so they are only reported.
+    const double dLinePeriod = 200.0;
+    ImagePyramid imagePyramid(8, 1.2, 1200, nBorder);
+    KeyPointExtractor keyPointExtractor(8, 30.0f, 3, 1200, 20, 7);
+    keyPointExtractor.setThreads(nThreads);
+    vector<vector<KeyPoint>> vvKeyPoints;
+    double dWholeLatency = 0.0, dStreamedLatency = 0.0;
+    for(const string &path : vPaths) {
+        if(!source.open(path, 16, dLinePeriod)) { bFailed = true; continue; }
+        while(source.nextBand(band)) {
+            Mat rows = image.rowRange(source.mnDeliveredRows - band.rows, source.mnDeliveredRows);
+            band.copyTo(rows);
+        }
+        imagePyramid.setImage(image);
+        keyPointExtractor.extract(vvKeyPoints, imagePyramid.mvImages);
+        dWholeLatency += chrono::duration<double, milli>(chrono::steady_clock::now() - source.mBandTime).count();
+
+        if(!source.open(path, 16, dLinePeriod)) { bFailed = true; continue; }
+        keyPointExtractor.beginStream(imagePyramid, Size(source.mnCols, source.mnRows));
+        while(source.nextBand(band))
+            keyPointExtractor.pushRows(band);
+        keyPointExtractor.endStream(vvKeyPoints);
+        dStreamedLatency += chrono::duration<double, milli>(chrono::steady_clock::now() - source.mBandTime).count();
+    }
+    printf(
+        "Latency after the last line (frame period %.1f ms): whole frame %.3f ms, streamed %.3f ms\n",
+        376 * dLinePeriod / 1000.0, dWholeLatency / vPaths.size(), dStreamedLatency / vPaths.size()
+    );
+
+    // Files that are not binary 8-bit PGM images are rejected.
+    FILE* pFile = fopen("testKeyPointExtractor_00_invalid.pgm", "wb");
+    if(pFile) { fputs("P2\n4 4\n255\n", pFile); fclose(pFile); }
+    bool bRejected = !source.open("testKeyPointExtractor_00_invalid.pgm", 16) && !source.open("testKeyPointExtractor_00_missing.pgm", 16);
+    printf("Invalid files rejected: %s\n", bRejected ? "yes" : "no");
+    if(!bRejected) { bFailed = true; }
+
+    source.close();
+    remove("testKeyPointExtractor_00_invalid.pgm");
+    for(const string &path : vPaths) { remove(path.c_str()); }
+
+    if(bFailed) {
+        printf("FAILED: streamed extraction differs from extraction on the whole image.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief The number of keypoints that lie on masked pixels, checked at their position in level 0.
+
+@param[in] vvKeyPoints: The keypoints of each level.
+@param[in] mask: The mask of level 0.
+@param[in] vfScaleFactors: The scale factor of each level. */
+long countMaskedKeyPoints(const vector<vector<KeyPoint>>& vvKeyPoints, const Mat& mask, const vector<float>& vfScaleFactors) {
+    long nMasked = 0;
+    for(size_t iLevel = 0; iLevel < vvKeyPoints.size(); iLevel++)
+        for(const KeyPoint &keyPoint : vvKeyPoints[iLevel]) {
+            int iX = min((int)(keyPoint.pt.x * vfScaleFactors[iLevel]), mask.cols - 1);
+            int iY = min((int)(keyPoint.pt.y * vfScaleFactors[iLevel]), mask.rows - 1);
+            nMasked += mask.at<uchar>(iY, iX) == 0;
+        }
+    return nMasked;
+}
+
+int main() {
+    // Synthetic textured images.
+    vector<Mat> vImages = createSyntheticImages(3);
+
+    // A vehicle hood over the bottom quarter, with a curved edge, and a timestamp overlay in the top left corner.
+    Mat mask(376, 1241, CV_8U, Scalar(255));
+    for(int iY = 0; iY < mask.rows; iY++)
+        for(int iX = 0; iX < mask.cols; iX++) {
+            double dX = (iX - mask.cols / 2.0) / (mask.cols / 2.0);
+            bool bHood = iY > mask.rows * 0.75 + 40 * dX * dX;
+            bool bTimestamp = iX < 300 && iY < 40;
+            if(bHood || bTimestamp) { mask.at<uchar>(iY, iX) = 0; }
+        }
+    Mat fullMask(376, 1241, CV_8U, Scalar(255));
+    double dUsableRatio = (double)countNonZero(mask) / mask.total();
+
+    const int nFeatures = 1200, nThreads = 2, nRepeats = 10;
+    bool bFailed = false;
+
+    // The features per level are rebalanced over the usable area and still add up to the total,
+    // and a mask that covers nothing keeps the original allocation.
+    ImagePyramid unmaskedPyramid(8, 1.2, nFeatures), maskedPyramid(8, 1.2, nFeatures);
+    maskedPyramid.setMask(fullMask);
+    bool bSameAllocation = maskedPyramid.mvnFeaturesPerLevel == unmaskedPyramid.mvnFeaturesPerLevel;
+    maskedPyramid.setMask(mask);
+    int nAllocated = 0;
+    printf("Features per level (unmasked / masked):");
+    for(int iLevel = 0; iLevel < maskedPyramid.mnLevels; iLevel++) {
+        printf(" %d/%d", unmaskedPyramid.mvnFeaturesPerLevel[iLevel], maskedPyramid.mvnFeaturesPerLevel[iLevel]);
+        nAllocated += maskedPyramid.mvnFeaturesPerLevel[iLevel];
+    }
+    printf("\nUsable area %.1f%%, allocated features %d, unchanged by a full mask: %s\n", 100.0 * dUsableRatio, nAllocated, bSameAllocation ? "yes" : "no");
+    if(nAllocated != nFeatures || !bSameAllocation) { bFailed = true; }
+
+    for(KeyPointExtractor::Mode eMode : {KeyPointExtractor::GRID_FAST, KeyPointExtractor::SCORE_MAP}) {
+        const char* modeName = eMode == KeyPointExtractor::SCORE_MAP ? "score map" : "grid FAST";
+        KeyPointExtractor unmaskedExtractor(8, 30.0f, 19, nFeatures, 20, 7, eMode), maskedExtractor(8, 30.0f, 19, nFeatures, 20, 7, eMode);
+        unmaskedExtractor.setThreads(nThreads);
+        maskedExtractor.setThreads(nThreads);
+
+        // A mask that covers nothing gives the same keypoints and scans the same cells.
+        vector<vector<KeyPoint>> vvUnmaskedKeyPoints, vvMaskedKeyPoints;
+        ImagePyramid fullPyramid(8, 1.2, nFeatures);
+        fullPyramid.setMask(fullMask);
+        maskedExtractor.setMasks(fullPyramid.mvMasks);
+        long nFullMismatches = 0, nFullCellMismatches = 0;
+        for(const Mat &image : vImages) {
+            unmaskedPyramid.setImage(image);
+            unmaskedExtractor.extract(vvUnmaskedKeyPoints, unmaskedPyramid.mvImages);
+            maskedExtractor.extract(vvMaskedKeyPoints, unmaskedPyramid.mvImages);
+            nFullMismatches += countMismatches(vvUnmaskedKeyPoints, vvMaskedKeyPoints);
+            for(int iLevel = 0; iLevel < unmaskedPyramid.mnLevels; iLevel++)
+                nFullCellMismatches += unmaskedExtractor.mvStatsPerLevel[iLevel].nCells != maskedExtractor.mvStatsPerLevel[iLevel].nCells;
+        }
+
+        // With the real mask, no keypoint lies on a masked pixel, on the whole image or built on the extractor's threads,
+        // masked cells are not scanned, and the keypoints of usable pixels are mostly kept.
+        maskedExtractor.setMasks(maskedPyramid.mvMasks);
+        long nMaskedKeyPoints = 0, nPipelinedMismatches = 0, nKept = 0, nUsable = 0;
+        long nUnmaskedCells = 0, nMaskedCells = 0;
+        vector<vector<KeyPoint>> vvPipelinedKeyPoints;
+        for(const Mat &image : vImages) {
+            unmaskedPyramid.setImage(image);
+            unmaskedExtractor.extract(vvUnmaskedKeyPoints, unmaskedPyramid.mvImages);
+            maskedPyramid.setImage(image);
+            maskedExtractor.extract(vvMaskedKeyPoints, maskedPyramid.mvImages);
+            for(int iLevel = 0; iLevel < maskedPyramid.mnLevels; iLevel++) {
+                nUnmaskedCells += unmaskedExtractor.mvStatsPerLevel[iLevel].nCells;
+                nMaskedCells += maskedExtractor.mvStatsPerLevel[iLevel].nCells;
+            }
+            maskedExtractor.extract(vvPipelinedKeyPoints, maskedPyramid, image);
+            nPipelinedMismatches += countMismatches(vvMaskedKeyPoints, vvPipelinedKeyPoints);
+            nMaskedKeyPoints += countMaskedKeyPoints(vvMaskedKeyPoints, mask, maskedPyramid.mvfScaleFactors);
+
+            for(int iLevel = 0; iLevel < maskedPyramid.mnLevels; iLevel++) {
+                const Mat &levelMask = maskedPyramid.mvMasks[iLevel];
+                const vector<KeyPoint> &vMasked = vvMaskedKeyPoints[iLevel];
+                for(const KeyPoint &keyPoint : vvUnmaskedKeyPoints[iLevel]) {
+                    if(levelMask.at<uchar>((int)keyPoint.pt.y, (int)keyPoint.pt.x) == 0) { continue; }
+                    nUsable++;
+                    for(const KeyPoint &masked : vMasked)
+                        if(masked.pt.x == keyPoint.pt.x && masked.pt.y == keyPoint.pt.y) { nKept++; break; }
+                }
+            }
+        }
+
+        // Time the extraction with and without the mask.
+        double dUnmaskedTime = 0.0, dMaskedTime = 0.0;
+        for(int iRepeat = 0; iRepeat < nRepeats; iRepeat++) {
+            for(const Mat &image : vImages) {
+                maskedPyramid.setImage(image);
+                auto start = chrono::steady_clock::now();
+                unmaskedExtractor.extract(vvUnmaskedKeyPoints, maskedPyramid.mvImages);
+                auto middle = chrono::steady_clock::now();
+                maskedExtractor.extract(vvMaskedKeyPoints, maskedPyramid.mvImages);
+                auto end = chrono::steady_clock::now();
+                dUnmaskedTime += chrono::duration<double, milli>(middle - start).count();
+                dMaskedTime += chrono::duration<double, milli>(end - middle).count();
+            }
+        }
+        int nFrames = nRepeats * vImages.size();
+
+        double dCellRatio = (double)nMaskedCells / max(nUnmaskedCells, 1L);
+        double dKeptRatio = (double)nKept / max(nUsable, 1L);
+        printf(
+            "%s: full mask mismatches %ld (cells %ld), keypoints on masked pixels %ld, pipelined mismatches %ld, "
+            "scanned cells %.1f%%, usable keypoints kept %.1f%%, unmasked %.3f ms, masked %.3f ms\n",
+            modeName, nFullMismatches, nFullCellMismatches, nMaskedKeyPoints, nPipelinedMismatches,
+            100.0 * dCellRatio, 100.0 * dKeptRatio, dUnmaskedTime / nFrames, dMaskedTime / nFrames
+        );
+        if(nFullMismatches > 0 || nFullCellMismatches > 0 || nMaskedKeyPoints > 0 || nPipelinedMismatches > 0 ||
+           dCellRatio > dUsableRatio + 0.15 || dKeptRatio < 0.95) { bFailed = true; }
+    }
+
+    // The distributor keeps close to the rebalanced number of features, and none of them on masked pixels.
+    KeyPointExtractor keyPointExtractor(8, 30.0f, 19, nFeatures, 20, 7);
+    keyPointExtractor.setMasks(maskedPyramid.mvMasks);
+    for(Distributor::Strategy eStrategy : {Distributor::QUADTREE, Distributor::GRID_BUCKET, Distributor::SSC}) {
+        Distributor distributor;
+        distributor.setStrategy(eStrategy);
+        distributor.setMasks(maskedPyramid.mvMasks);
+
+        long nDistributed = 0, nMaskedKeyPoints = 0;
+        vector<vector<KeyPoint>> vvKeyPoints, vvDistributedKeyPoints;
+        for(const Mat &image : vImages) {
+            maskedPyramid.setImage(image);
+            keyPointExtractor.extract(vvKeyPoints, maskedPyramid.mvImages);
+            distributor.distribute(vvDistributedKeyPoints, vvKeyPoints, maskedPyramid.mvnFeaturesPerLevel, maskedPyramid.mvImages);
+            for(const vector<KeyPoint> &vDistributed : vvDistributedKeyPoints) { nDistributed += vDistributed.size(); }
+            nMaskedKeyPoints += countMaskedKeyPoints(vvDistributedKeyPoints, mask, maskedPyramid.mvfScaleFactors);
+        }
+
+        double dDistributed = (double)nDistributed / vImages.size();
+        printf("Distributor %d: %.1f keypoints per image for %d features, keypoints on masked pixels %ld\n", eStrategy, dDistributed, nFeatures, nMaskedKeyPoints);
+        if(dDistributed < 0.85 * nFeatures || dDistributed > 1.1 * nFeatures || nMaskedKeyPoints > 0) { bFailed = true; }
+    }
+
+    // Keypoints of an unmasked extractor outside the box of the usable pixels are dropped before the distribution.
+    vector<Rect> vMaskAreas;
+    for(const Mat &levelMask : maskedPyramid.mvMasks) {
+        int iMinX = levelMask.cols, iMinY = levelMask.rows, iMaxX = -1, iMaxY = -1;
+        for(int iY = 0; iY < levelMask.rows; iY++)
+            for(int iX = 0; iX < levelMask.cols; iX++)
+                if(levelMask.at<uchar>(iY, iX)) {
+                    iMinX = min(iMinX, iX); iMaxX = max(iMaxX, iX);
+                    iMinY = min(iMinY, iY); iMaxY = max(iMaxY, iY);
+                }
+        vMaskAreas.push_back(Rect(iMinX, iMinY, iMaxX - iMinX + 1, iMaxY - iMinY + 1));
+    }
+    KeyPointExtractor unmaskedExtractor(8, 30.0f, 19, nFeatures, 20, 7);
+    for(Distributor::Strategy eStrategy : {Distributor::QUADTREE, Distributor::GRID_BUCKET, Distributor::SSC}) {
+        Distributor distributor;
+        distributor.setStrategy(eStrategy);
+        distributor.setMasks(maskedPyramid.mvMasks);
+
+        long nDistributed = 0, nOutside = 0;
+        vector<vector<KeyPoint>> vvKeyPoints, vvDistributedKeyPoints;
+        for(const Mat &image : vImages) {
+            maskedPyramid.setImage(image);
+            unmaskedExtractor.extract(vvKeyPoints, maskedPyramid.mvImages);
+            distributor.distribute(vvDistributedKeyPoints, vvKeyPoints, maskedPyramid.mvnFeaturesPerLevel, maskedPyramid.mvImages);
+            for(size_t iLevel = 0; iLevel < vvDistributedKeyPoints.size(); iLevel++)
+                for(const KeyPoint &keyPoint : vvDistributedKeyPoints[iLevel]) {
+                    nOutside += !vMaskAreas[iLevel].contains(Point((int)keyPoint.pt.x, (int)keyPoint.pt.y));
+                    nDistributed++;
+                }
+        }
+        printf("Distributor %d without extractor masks: %ld keypoints, outside the usable box %ld\n", eStrategy, nDistributed, nOutside);
+        if(nDistributed == 0 || nOutside > 0) { bFailed = true; }
+    }
+
+    if(bFailed) {
+        printf("FAILED: masked extraction scans or keeps masked areas, or differs from unmasked extraction.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
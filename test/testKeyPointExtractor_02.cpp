@@ -0,0 +1,127 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+#include <tuple>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+typedef tuple<float, float, float> Corner; // (y, x, response)
+
+/*
+@brief The corners of one level, sorted, so that two extractions can be compared as sets.
+
+@param[in] vKeyPoints: The keypoints of the level. */
+vector<Corner> toSortedCorners(const vector<KeyPoint>& vKeyPoints) {
+    vector<Corner> vCorners;
+    for(const KeyPoint &keyPoint : vKeyPoints)
+        vCorners.emplace_back(keyPoint.pt.y, keyPoint.pt.x, keyPoint.response);
+    sort(vCorners.begin(), vCorners.end());
+    return vCorners;
+}
+
+/*
+@brief The FAST corners of one level inside the extractor's detection area, in level coordinates and sorted.
+
+@param[in] level: The level image.
+@param[in] nPaddingPixels: The padding given to the extractor. Its detection area reaches 3 pixels further out.
+@param[in] iThreshold: The FAST threshold. */
+vector<Corner> detectSortedCorners(const Mat &level, int nPaddingPixels, int iThreshold) {
+    int iBorder = nPaddingPixels - 3;
+    vector<KeyPoint> vKeyPoints;
+    FAST(level.rowRange(iBorder, level.rows - iBorder).colRange(iBorder, level.cols - iBorder), vKeyPoints, iThreshold, true);
+    for(KeyPoint &keyPoint : vKeyPoints) {
+        keyPoint.pt.x += iBorder;
+        keyPoint.pt.y += iBorder;
+    }
+    return toSortedCorners(vKeyPoints);
+}
+
+/*
+@brief Whether a corner lies on the first or last pixel row or column of its grid cell.
+Both modes find the corners of a cell in the cell shifted 3 pixels right and down, which starts at the padding.
+
+@param[in] corner: The corner, in level coordinates.
+@param[in] level: The level image.
+@param[in] nPaddingPixels: The padding given to the extractor.
+@param[in] fGridSize: The default grid size given to the extractor. */
+bool isOnCellEdge(const Corner &corner, const Mat &level, int nPaddingPixels, float fGridSize) {
+    float fWidth = float(level.cols - 2 * nPaddingPixels + 6), fHeight = float(level.rows - 2 * nPaddingPixels + 6);
+    int iGridWidth = ceil(fWidth / int(fWidth / fGridSize)), iGridHeight = ceil(fHeight / int(fHeight / fGridSize));
+    int iX = (int(get<1>(corner)) - nPaddingPixels) % iGridWidth;
+    int iY = (int(get<0>(corner)) - nPaddingPixels) % iGridHeight;
+    return iX == 0 || iX == iGridWidth - 1 || iY == 0 || iY == iGridHeight - 1;
+}
+
+int main() {
+    vector<Mat> vImages = createSyntheticImages(3);
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    const int nPaddingPixels = 19, iMaxTh = 20;
+    bool bFailed = false;
+
+    // The score map runs FAST once per level at miMinTh and picks miMaxTh or miMinTh per cell by comparing scores.
+    // A corner that reaches miMaxTh also survives non-maximum suppression at miMaxTh, so the score map keeps every
+    // corner FAST finds on the level at miMaxTh and nothing FAST does not find at miMinTh.
+    // With one threshold both bounds are the same, and the score map must match FAST on the whole level exactly.
+    // Per-grid mode runs on the same pyramids for comparison, see below.
+    for(int iMinTh : {20, 7}) {
+        KeyPointExtractor gridExtractor(imagePyramid.mnLevels, 30.0f, nPaddingPixels, imagePyramid.mnFeatures, iMaxTh, iMinTh, KeyPointExtractor::GRID_FAST);
+        KeyPointExtractor mapExtractor(imagePyramid.mnLevels, 30.0f, nPaddingPixels, imagePyramid.mnFeatures, iMaxTh, iMinTh, KeyPointExtractor::SCORE_MAP);
+
+        long nMap = 0, nMissing = 0, nExtra = 0, nDuplicates = 0, nGrid = 0, nCommon = 0, nInside = 0;
+        long nGridFallbackCells = 0, nMapFallbackCells = 0;
+        vector<vector<KeyPoint>> vvGridKeyPoints, vvMapKeyPoints;
+        for(const Mat &image : vImages) {
+            imagePyramid.setImage(image);
+            gridExtractor.extract(vvGridKeyPoints, imagePyramid.mvImages);
+            mapExtractor.extract(vvMapKeyPoints, imagePyramid.mvImages);
+
+            for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+                const Mat &level = imagePyramid.mvImages[iLevel];
+                vector<Corner> vMap = toSortedCorners(vvMapKeyPoints[iLevel]);
+                vector<Corner> vStrong = detectSortedCorners(level, nPaddingPixels, iMaxTh);
+                vector<Corner> vWeak = detectSortedCorners(level, nPaddingPixels, iMinTh);
+                vector<Corner> vMissing, vExtra;
+                set_difference(vStrong.begin(), vStrong.end(), vMap.begin(), vMap.end(), back_inserter(vMissing));
+                set_difference(vMap.begin(), vMap.end(), vWeak.begin(), vWeak.end(), back_inserter(vExtra));
+                nMap += vMap.size();
+                nMissing += vMissing.size();
+                nExtra += vExtra.size();
+
+                // The score map holds one score per pixel, so a pixel is reported once.
+                for(size_t i = 1; i < vMap.size(); i++)
+                    nDuplicates += get<0>(vMap[i]) == get<0>(vMap[i - 1]) && get<1>(vMap[i]) == get<1>(vMap[i - 1]);
+
+                vector<Corner> vGrid = toSortedCorners(vvGridKeyPoints[iLevel]), vCommon, vDifferent;
+                set_intersection(vGrid.begin(), vGrid.end(), vMap.begin(), vMap.end(), back_inserter(vCommon));
+                set_symmetric_difference(vGrid.begin(), vGrid.end(), vMap.begin(), vMap.end(), back_inserter(vDifferent));
+                nGrid += vGrid.size();
+                nCommon += vCommon.size();
+                for(const Corner &corner : vDifferent)
+                    nInside += !isOnCellEdge(corner, level, nPaddingPixels, 30.0f);
+
+                nGridFallbackCells += gridExtractor.mvStatsPerLevel[iLevel].nFallbackCells;
+                nMapFallbackCells += mapExtractor.mvStatsPerLevel[iLevel].nFallbackCells;
+            }
+        }
+
+        printf("miMinTh %d: score map %ld keypoints, FAST corners at miMaxTh missing %ld, not found by FAST at miMinTh %ld, duplicates %ld\n",
+               iMinTh, nMap, nMissing, nExtra, nDuplicates);
+        printf("miMinTh %d: grid FAST %ld keypoints, common with the score map %ld, different away from cell edges %ld, fallback cells %ld / %ld\n",
+               iMinTh, nGrid, nCommon, nInside, nGridFallbackCells, nMapFallbackCells);
+        if(nMap == 0 || nMissing > 0 || nExtra > 0 || nDuplicates > 0) { bFailed = true; }
+
+        // Both modes look for the corners of a cell in the same pixels and pick the same threshold for it,
+        // so the same cells fall back. The score map suppresses against every corner of the level, the grid
+        // cells only against the corners they reported. A corner on the edge of a cell can therefore survive
+        // in per-grid mode next to a stronger corner of the neighbouring cell that was not reported.
+        // The score map finds a subset of the per-grid keypoints, and the rest lie on the edge of their cell.
+        if(nCommon != nMap || nInside > 0 || nGridFallbackCells != nMapFallbackCells) { bFailed = true; }
+    }
+
+    printf("%s\n", bFailed ? "FAILED" : "PASSED");
+    return bFailed ? 1 : 0;
+}
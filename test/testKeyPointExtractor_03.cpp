@@ -0,0 +1,70 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+int main() {
+    // A static scene: the per-cell thresholds can only settle when consecutive frames look alike.
+    Mat image = createSyntheticImages(1)[0];
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    imagePyramid.setImage(image);
+
+    const int nFrames = 20, nSettledFrames = 5, iMaxTh = 20, iMinTh = 7;
+    bool bFailed = false;
+
+    for(KeyPointExtractor::Mode eMode : {KeyPointExtractor::GRID_FAST, KeyPointExtractor::SCORE_MAP}) {
+        const char* modeName = eMode == KeyPointExtractor::SCORE_MAP ? "score map" : "grid FAST";
+        KeyPointExtractor fixedExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, iMaxTh, iMinTh, eMode);
+        KeyPointExtractor adaptiveExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, iMaxTh, iMinTh, eMode);
+        adaptiveExtractor.enableAdaptiveThresholds(imagePyramid.mvnFeaturesPerLevel);
+
+        // Once the thresholds settle, far fewer candidates reach the distributor, every level still has more
+        // candidates than features, the retry pass is not needed more often than with fixed thresholds,
+        // and the thresholds stay between miMinTh and 4 * miMaxTh.
+        vector<vector<KeyPoint>> vvFixedKeyPoints, vvAdaptiveKeyPoints;
+        long nFixedCorners = 0, nAdaptiveCorners = 0, nFixedFallbacks = 0, nAdaptiveFallbacks = 0;
+        long nShortLevels = 0, nThresholdSum = 0, nCells = 0;
+        for(int iFrame = 0; iFrame < nFrames; iFrame++) {
+            fixedExtractor.extract(vvFixedKeyPoints, imagePyramid.mvImages);
+            adaptiveExtractor.extract(vvAdaptiveKeyPoints, imagePyramid.mvImages);
+            if(iFrame < nFrames - nSettledFrames) { continue; }
+
+            for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+                const KeyPointExtractor::LevelStatistics &fixedStats = fixedExtractor.mvStatsPerLevel[iLevel];
+                const KeyPointExtractor::LevelStatistics &adaptiveStats = adaptiveExtractor.mvStatsPerLevel[iLevel];
+                nFixedCorners += fixedStats.nRawCorners;
+                nAdaptiveCorners += adaptiveStats.nRawCorners;
+                nFixedFallbacks += fixedStats.nFallbackCells;
+                nAdaptiveFallbacks += adaptiveStats.nFallbackCells;
+                nShortLevels += adaptiveStats.nRawCorners < imagePyramid.mvnFeaturesPerLevel[iLevel];
+                nThresholdSum += adaptiveStats.nThresholdSum;
+                nCells += adaptiveStats.nCells;
+            }
+        }
+        double dMeanThreshold = (double)nThresholdSum / max(nCells, 1L);
+        printf(
+            "%s: corners per frame fixed %.1f / adaptive %.1f, fallback cells per frame fixed %.1f / adaptive %.1f, "
+            "levels short of features %ld, mean cell threshold %.1f\n",
+            modeName, (double)nFixedCorners / nSettledFrames, (double)nAdaptiveCorners / nSettledFrames,
+            (double)nFixedFallbacks / nSettledFrames, (double)nAdaptiveFallbacks / nSettledFrames, nShortLevels, dMeanThreshold
+        );
+        if(nAdaptiveCorners > nFixedCorners / 2 || nAdaptiveFallbacks > 2 * nFixedFallbacks + nSettledFrames ||
+           nShortLevels > 0 || dMeanThreshold < iMinTh || dMeanThreshold > 4 * iMaxTh) { bFailed = true; }
+
+        // Disabling the adaptive thresholds goes back to the fixed ones.
+        adaptiveExtractor.disableAdaptiveThresholds();
+        fixedExtractor.extract(vvFixedKeyPoints, imagePyramid.mvImages);
+        adaptiveExtractor.extract(vvAdaptiveKeyPoints, imagePyramid.mvImages);
+        long nMismatches = countMismatches(vvFixedKeyPoints, vvAdaptiveKeyPoints);
+        printf("%s: mismatches after disabling %ld\n", modeName, nMismatches);
+        if(nMismatches > 0) { bFailed = true; }
+    }
+
+    printf("%s\n", bFailed ? "FAILED" : "PASSED");
+    return bFailed ? 1 : 0;
+}
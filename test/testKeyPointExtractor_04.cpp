@@ -0,0 +1,56 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+int main() {
+    vector<Mat> vImages = createSyntheticImages(3);
+    ImagePyramid imagePyramid(8, 1.2, 1200);
+    bool bFailed = false;
+
+    // With and without the fallback to miMinTh: after the level-wide suppression no pixel is reported twice
+    // and no two keypoints are neighbours, even across the borders of the cells.
+    for(int iMinTh : {20, 7}) {
+        KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, iMinTh, KeyPointExtractor::GRID_FAST);
+
+        long nKeyPoints = 0, nDuplicates = 0, nNeighbours = 0, nSuppressed = 0;
+        vector<vector<KeyPoint>> vvKeyPoints;
+        Mat marks;
+        for(const Mat &image : vImages) {
+            imagePyramid.setImage(image);
+            keyPointExtractor.extract(vvKeyPoints, imagePyramid.mvImages);
+
+            for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++) {
+                // Keypoints are at least 3 pixels inside the level, so their neighbours are too.
+                const Mat &level = imagePyramid.mvImages[iLevel];
+                marks.create(level.rows, level.cols, CV_8U);
+                marks.setTo(Scalar(0));
+                for(const KeyPoint &keyPoint : vvKeyPoints[iLevel]) {
+                    uchar &mark = marks.at<uchar>((int)keyPoint.pt.y, (int)keyPoint.pt.x);
+                    nDuplicates += mark != 0;
+                    mark = 1;
+                }
+                for(const KeyPoint &keyPoint : vvKeyPoints[iLevel]) {
+                    int iX = (int)keyPoint.pt.x, iY = (int)keyPoint.pt.y;
+                    for(int iDY = -1; iDY <= 1; iDY++)
+                        for(int iDX = -1; iDX <= 1; iDX++)
+                            if((iDX != 0 || iDY != 0) && marks.at<uchar>(iY + iDY, iX + iDX)) { nNeighbours++; }
+                }
+                nKeyPoints += vvKeyPoints[iLevel].size();
+                nSuppressed += keyPointExtractor.mvStatsPerLevel[iLevel].nSuppressedCorners;
+            }
+        }
+
+        printf("miMinTh %d: %ld keypoints, %ld suppressed across cells, duplicates %ld, neighbouring keypoints %ld\n",
+               iMinTh, nKeyPoints, nSuppressed, nDuplicates, nNeighbours);
+        if(nKeyPoints == 0 || nSuppressed == 0 || nDuplicates > 0 || nNeighbours > 0) { bFailed = true; }
+    }
+
+    printf("%s\n", bFailed ? "FAILED" : "PASSED");
+    return bFailed ? 1 : 0;
+}
@@ -0,0 +1,78 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "TestImages.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief The number of levels whose statistics differ between two extractors.
+
+@param[in] a, b: The extractors. */
+long countStatisticsMismatches(const KeyPointExtractor& a, const KeyPointExtractor& b) {
+    long nMismatches = 0;
+    for(size_t iLevel = 0; iLevel < a.mvStatsPerLevel.size(); iLevel++) {
+        const KeyPointExtractor::LevelStatistics &statsA = a.mvStatsPerLevel[iLevel], &statsB = b.mvStatsPerLevel[iLevel];
+        nMismatches += statsA.nCells != statsB.nCells || statsA.nFallbackCells != statsB.nFallbackCells ||
+                       statsA.nEmptyCells != statsB.nEmptyCells || statsA.nRawCorners != statsB.nRawCorners ||
+                       statsA.nThresholdSum != statsB.nThresholdSum || statsA.nSuppressedCorners != statsB.nSuppressedCorners;
+    }
+    return nMismatches;
+}
+
+int main() {
+    vector<Mat> vImages = createSyntheticImages(5);
+    const vector<int> vnThreads = {2, 3, 4, 8};
+    bool bFailed = false;
+
+    // Any number of threads gives exactly the keypoints and statistics of a single thread,
+    // with fixed or adaptive thresholds and with the pyramid built before or during the extraction.
+    for(KeyPointExtractor::Mode eMode : {KeyPointExtractor::GRID_FAST, KeyPointExtractor::SCORE_MAP}) {
+        for(bool bAdaptive : {false, true}) {
+            ImagePyramid singlePyramid(8, 1.2, 1200), multiPyramid(8, 1.2, 1200);
+            KeyPointExtractor singleExtractor(singlePyramid.mnLevels, 30.0f, 19, singlePyramid.mnFeatures, 20, 7, eMode);
+            vector<unique_ptr<KeyPointExtractor>> vpMultiExtractors;
+            for(int nThreads : vnThreads) {
+                vpMultiExtractors.emplace_back(new KeyPointExtractor(multiPyramid.mnLevels, 30.0f, 19, multiPyramid.mnFeatures, 20, 7, eMode));
+                vpMultiExtractors.back()->setThreads(nThreads);
+            }
+            if(bAdaptive) {
+                singleExtractor.enableAdaptiveThresholds(singlePyramid.mvnFeaturesPerLevel);
+                for(unique_ptr<KeyPointExtractor> &pExtractor : vpMultiExtractors)
+                    pExtractor->enableAdaptiveThresholds(multiPyramid.mvnFeaturesPerLevel);
+            }
+
+            long nMismatches = 0, nStatisticsMismatches = 0;
+            vector<vector<KeyPoint>> vvSingleKeyPoints, vvMultiKeyPoints;
+            for(int iPass = 0; iPass < 2; iPass++) {
+                for(const Mat &image : vImages) {
+                    singlePyramid.setImage(image);
+                    singleExtractor.extract(vvSingleKeyPoints, singlePyramid.mvImages);
+                    for(size_t i = 0; i < vpMultiExtractors.size(); i++) {
+                        // The first pass builds the pyramid first, the second one builds it on the extractor's threads.
+                        if(iPass == 0) {
+                            multiPyramid.setImage(image);
+                            vpMultiExtractors[i]->extract(vvMultiKeyPoints, multiPyramid.mvImages);
+                        }
+                        else {
+                            vpMultiExtractors[i]->extract(vvMultiKeyPoints, multiPyramid, image);
+                        }
+                        nMismatches += countMismatches(vvSingleKeyPoints, vvMultiKeyPoints);
+                        nStatisticsMismatches += countStatisticsMismatches(singleExtractor, *vpMultiExtractors[i]);
+                    }
+                }
+            }
+
+            printf("%s, %s thresholds: mismatches with 2 to 8 threads %ld, statistics mismatches %ld\n",
+                   eMode == KeyPointExtractor::SCORE_MAP ? "score map" : "grid FAST", bAdaptive ? "adaptive" : "fixed",
+                   nMismatches, nStatisticsMismatches);
+            if(nMismatches > 0 || nStatisticsMismatches > 0) { bFailed = true; }
+        }
+    }
+
+    printf("%s\n", bFailed ? "FAILED" : "PASSED");
+    return bFailed ? 1 : 0;
+}
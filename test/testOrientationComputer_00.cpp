@@ -0,0 +1,87 @@
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/Frame.h"
+
+#include <opencv2/opencv.hpp>
+#include <random>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+int main(int argc, char **argv) {
+    // Test images: optional frames from an image sequence, plus uniform noise.
+    vector<Mat> vImages;
+    if(argc > 1) {
+        string dirPath = argv[1];
+        for(int i = 0; i < 20; i++) {
+            std::ostringstream ss;
+            ss << std::setw(6) << std::setfill('0') << i << ".png";
+            Mat image = imread(dirPath + "/" + ss.str(), 0);
+            if(!image.empty()) { vImages.push_back(image); }
+        }
+    }
+    std::mt19937 rng(0);
+    for(int i = 0; i < 10; i++) {
+        Mat noise(60 + rng() % 300, 60 + rng() % 500, CV_8U);
+        for(int iY = 0; iY < noise.rows; iY++)
+            for(int iX = 0; iX < noise.cols; iX++)
+                noise.at<uchar>(iY, iX) = (uchar)(i == 0 ? 255 : rng() % 256); // a flat image gives zero moments
+        vImages.push_back(noise);
+    }
+
+    // Random keypoints 19 pixels inside the border, like the extractor's, at sub-pixel positions.
+    vector<vector<vector<KeyPoint>>> vvvKeyPointsPerImage(vImages.size());
+    for(size_t i = 0; i < vImages.size(); i++) {
+        const Mat& image = vImages[i];
+        vector<KeyPoint> vKeyPoints(2000);
+        for(KeyPoint& keyPoint : vKeyPoints) {
+            keyPoint.pt.x = 19 + (rng() % ((image.cols - 38) * 4)) * 0.25f;
+            keyPoint.pt.y = 19 + (rng() % ((image.rows - 38) * 4)) * 0.25f;
+        }
+        vvvKeyPointsPerImage[i].push_back(vKeyPoints);
+    }
+
+    if(!OrientationComputer::isSupported(OrientationComputer::AVX2)) {
+        printf("AVX2 is not supported by this CPU, only the scalar kernel is used.\n");
+        return 0;
+    }
+
+    // The AVX2 moments must be exactly the scalar ones, so the angles must be identical, for every radius.
+    bool bFailed = false;
+    for(int iRadius : {15, 12, 7}) {
+        OrientationComputer scalarComputer(iRadius, OrientationComputer::SCALAR);
+        OrientationComputer avx2Computer(iRadius, OrientationComputer::AVX2);
+
+        long nMismatches = 0;
+        double dScalarTime = 0.0, dAVX2Time = 0.0;
+        for(size_t i = 0; i < vImages.size(); i++) {
+            vector<Mat> vImagePerLevel = {vImages[i]};
+            vector<vector<KeyPoint>> vvScalarKeyPoints = vvvKeyPointsPerImage[i];
+            vector<vector<KeyPoint>> vvAVX2KeyPoints = vvvKeyPointsPerImage[i];
+
+            TimePoint t1 = chrono::steady_clock::now();
+            scalarComputer.compute(vvScalarKeyPoints, vImagePerLevel);
+            TimePoint t2 = chrono::steady_clock::now();
+            avx2Computer.compute(vvAVX2KeyPoints, vImagePerLevel);
+            TimePoint t3 = chrono::steady_clock::now();
+            dScalarTime += chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+            dAVX2Time += chrono::duration_cast<chrono::duration<double>>(t3 - t2).count();
+
+            for(size_t j = 0; j < vvScalarKeyPoints[0].size(); j++)
+                nMismatches += vvScalarKeyPoints[0][j].angle != vvAVX2KeyPoints[0][j].angle;
+        }
+
+        printf(
+            "Radius %d: scalar %.3f ms, AVX2 %.3f ms, mismatches %ld\n",
+            iRadius, dScalarTime * 1e3, dAVX2Time * 1e3, nMismatches
+        );
+        if(nMismatches > 0) { bFailed = true; }
+    }
+
+    if(bFailed) {
+        printf("FAILED: the AVX2 kernel differs from the scalar kernel.\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
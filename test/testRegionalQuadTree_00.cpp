@@ -0,0 +1,113 @@
+#include "myORB-SLAM2/RegionalQuadTree.h"
+
+#include <opencv2/opencv.hpp>
+#include <random>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+@brief Check the node list of a quadtree: it is linked both ways, holds mnNodes nodes, every node owns
+the keypoints inside its box, and the nodes together own every keypoint exactly once.
+
+@param[in] quadTree: The quadtree to check.
+@param[in] vKeyPoints: The keypoints the quadtree was reset with. */
+bool isConsistent(const RegionalQuadTree& quadTree, const vector<KeyPoint>& vKeyPoints) {
+    vector<int> vnOwners(vKeyPoints.size(), 0);
+    int nNodes = 0, iPrev = -1;
+    for(int iNode = quadTree.miHead; iNode != -1; iNode = quadTree.mvNodes[iNode].miNext) {
+        const RegionalQuadTreeNode& node = quadTree.mvNodes[iNode];
+        if(node.miPrev != iPrev || node.size() <= 0 || node.mbLocked != (node.size() == 1)) { return false; }
+
+        for(int i = node.miBegin; i < node.miEnd; i++) {
+            const KeyPoint* pKeyPoint = quadTree.mvpKeyPoints[i];
+            if(pKeyPoint->pt.x < node.miMinX || pKeyPoint->pt.x >= node.miMaxX ||
+               pKeyPoint->pt.y < node.miMinY || pKeyPoint->pt.y >= node.miMaxY) { return false; }
+            vnOwners[pKeyPoint - vKeyPoints.data()]++;
+        }
+        iPrev = iNode;
+        nNodes++;
+    }
+
+    if(nNodes != quadTree.mnNodes) { return false; }
+    return all_of(vnOwners.begin(), vnOwners.end(), [](int nOwners) { return nOwners == 1; });
+}
+
+int main() {
+    std::mt19937 rng(0);
+    RegionalQuadTree quadTree;
+    bool bFailed = false;
+
+    // Divide the most populated node over and over, as the distribution does, on sets of different sizes.
+    // The arena is reused across resets: once it has grown for the largest set, it must not be reallocated.
+    const RegionalQuadTreeNode* pNodes = nullptr;
+    const KeyPoint* const* ppKeyPoints = nullptr;
+    for(int iRound = 0; iRound < 2; iRound++) {
+        rng.seed(0);
+        for(int nKeyPoints : {0, 1, 2, 50, 2000, 300}) {
+            Rect area(7, 5, 640, 480);
+            vector<KeyPoint> vKeyPoints;
+            for(int i = 0; i < nKeyPoints; i++) {
+                // Every tenth keypoint lands on the position of an earlier one.
+                if(i % 10 == 9) { vKeyPoints.push_back(vKeyPoints[rng() % i]); continue; }
+                float fX = area.x + (rng() % (area.width * 4)) / 4.f, fY = area.y + (rng() % (area.height * 4)) / 4.f;
+                vKeyPoints.emplace_back(fX, fY, 7.f, -1, (float)(rng() % 100));
+            }
+
+            quadTree.reset(area, vKeyPoints);
+            if(!isConsistent(quadTree, vKeyPoints) || quadTree.mnNodes != min(nKeyPoints, 1)) {
+                printf("FAILED: reset with %d keypoints.\n", nKeyPoints);
+                bFailed = true;
+                continue;
+            }
+
+            for(int iSplit = 0; iSplit < 500; iSplit++) {
+                int iLargest = -1;
+                for(int iNode = quadTree.miHead; iNode != -1; iNode = quadTree.mvNodes[iNode].miNext) {
+                    const RegionalQuadTreeNode& node = quadTree.mvNodes[iNode];
+                    if(node.mbLocked || (node.miMaxX - node.miMinX <= 1 && node.miMaxY - node.miMinY <= 1)) { continue; }
+                    if(iLargest == -1 || node.size() > quadTree.mvNodes[iLargest].size()) { iLargest = iNode; }
+                }
+                if(iLargest == -1) { break; }
+
+                // The children are linked in front of the list, the returned index is the node after the parent.
+                int iNext = quadTree.mvNodes[iLargest].miNext;
+                int nNodes = quadTree.mnNodes;
+                size_t nArena = quadTree.mvNodes.size();
+                if(quadTree.divide(iLargest) != iNext || quadTree.mnNodes != nNodes - 1 + (int)(quadTree.mvNodes.size() - nArena) ||
+                   quadTree.mvNodes.size() - nArena > 4 || !isConsistent(quadTree, vKeyPoints)) {
+                    printf("FAILED: split %d of a quadtree with %d keypoints.\n", iSplit, nKeyPoints);
+                    bFailed = true;
+                    break;
+                }
+            }
+
+            // A locked node has a single keypoint: dividing it changes nothing.
+            for(int iNode = quadTree.miHead; iNode != -1; iNode = quadTree.mvNodes[iNode].miNext) {
+                if(!quadTree.mvNodes[iNode].mbLocked) { continue; }
+                int iNext = quadTree.mvNodes[iNode].miNext;
+                size_t nArena = quadTree.mvNodes.size();
+                int nNodes = quadTree.mnNodes;
+                if(quadTree.divide(iNode) != iNext || quadTree.mvNodes.size() != nArena || quadTree.mnNodes != nNodes) {
+                    printf("FAILED: dividing a locked node of a quadtree with %d keypoints.\n", nKeyPoints);
+                    bFailed = true;
+                }
+                break;
+            }
+
+            if(iRound == 1 && (quadTree.mvNodes.data() != pNodes || (nKeyPoints > 0 && quadTree.mvpKeyPoints.data() != ppKeyPoints))) {
+                printf("FAILED: the arena was reallocated for a quadtree with %d keypoints.\n", nKeyPoints);
+                bFailed = true;
+            }
+        }
+
+        // The first round grows the arena, the second round must reuse it.
+        pNodes = quadTree.mvNodes.data();
+        ppKeyPoints = quadTree.mvpKeyPoints.data();
+    }
+
+    if(bFailed) { return 1; }
+    printf("PASSED\n");
+    return 0;
+}
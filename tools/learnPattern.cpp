@@ -0,0 +1,226 @@
+#include "myORB-SLAM2/ImagePyramid.h"
+#include "myORB-SLAM2/KeyPointExtractor.h"
+#include "myORB-SLAM2/Distributor.h"
+#include "myORB-SLAM2/OrientationComputer.h"
+#include "myORB-SLAM2/DescriptorComputer.h"
+
+#include <opencv2/opencv.hpp>
+#include <random>
+
+using namespace my_ORB_SLAM2;
+using namespace std;
+using namespace cv;
+
+/*
+Learn a decorrelated test pattern from our own footage, as ORB learned its pattern:
+1. Run the pipeline (pyramid, extractor, distributor, orientation) on the image sequence and sample
+   oriented patches from the blurred pyramid, rotated exactly as DescriptorComputer rotates its pattern.
+2. Evaluate every candidate test (a pair of points in the [-13, 13] square, the ORB pairs included) on every patch.
+3. Sort the tests by how far their mean is from 0.5, then greedily keep a test only if its correlation with
+   every kept test stays below a threshold; the threshold is raised until enough tests are kept.
+The pattern is written with DescriptorComputerBase::savePattern and loaded with DescriptorComputer::loadPattern.
+
+Usage: learnPattern <image directory> <pattern file> [bits = 256] [candidates = 10000] [patches = 30000] */
+
+// Half size of the square that pattern points are drawn from, as the ORB pairs.
+static const int HALF_SIZE = 13;
+static const int GRID_SIZE = 2 * HALF_SIZE + 1;
+
+/*
+@brief Read the intensity at every grid point of a patch, rotated by the keypoint's angle like the descriptor's pattern.
+
+@param[in] keyPoint: The keypoint at the patch center.
+@param[in] blurredImage: The blurred image that contains the keypoint.
+@param[in, out] pIntensities: The GRID_SIZE * GRID_SIZE intensities. */
+static void samplePatch(const KeyPoint& keyPoint, const Mat& blurredImage, uchar* pIntensities) {
+    float fRadian = keyPoint.angle * (float)(CV_PI / 180.f);
+    float fCos = cosf(fRadian), fSin = sinf(fRadian);
+    const uchar* pCenter = &blurredImage.at<uchar>(cvRound(keyPoint.pt.y), cvRound(keyPoint.pt.x));
+    int nCols = (int)blurredImage.step;
+
+    for(int iY = -HALF_SIZE; iY <= HALF_SIZE; iY++) {
+        for(int iX = -HALF_SIZE; iX <= HALF_SIZE; iX++) {
+            float fX = (float)iX, fY = (float)iY;
+            int nOffset = cvRound(fX * fSin + fY * fCos) * nCols + cvRound(fX * fCos - fY * fSin);
+            *pIntensities++ = pCenter[nOffset];
+        }
+    }
+}
+
+/*
+@brief Correlation of two binary tests from their bits over all patches.
+
+@param[in] vnFirst, vnSecond: The bits of the tests, 64 patches per word.
+@param[in] fFirstMean, fSecondMean: The fraction of patches where each test is 1.
+@param[in] nPatches: The number of patches. */
+static float computeCorrelation(
+    const vector<uint64_t>& vnFirst, const vector<uint64_t>& vnSecond,
+    float fFirstMean, float fSecondMean, int nPatches
+) {
+    long nBoth = 0;
+    for(size_t i = 0; i < vnFirst.size(); i++) { nBoth += __builtin_popcountll(vnFirst[i] & vnSecond[i]); }
+
+    float fDeviation = sqrtf(fFirstMean * (1 - fFirstMean) * fSecondMean * (1 - fSecondMean));
+    if(fDeviation == 0.f) { return 1.f; } // a constant test carries no information
+    return ((float)nBoth / nPatches - fFirstMean * fSecondMean) / fDeviation;
+}
+
+int main(int argc, char **argv) {
+    if(argc < 3) {
+        printf("Usage: %s <image directory> <pattern file> [bits = 256] [candidates = 10000] [patches = 30000]\n", argv[0]);
+        return 1;
+    }
+    string dirPath = argv[1], patternPath = argv[2];
+    int nBits = argc > 3 ? atoi(argv[3]) : 256;
+    int nCandidates = argc > 4 ? atoi(argv[4]) : 10000;
+    int nMaxPatches = argc > 5 ? atoi(argv[5]) : 30000;
+    if(nBits <= 0 || nBits % 8 != 0) {
+        printf("The number of bits must be a positive multiple of 8.\n");
+        return 1;
+    }
+
+    // Image sequence, named like the test sequences.
+    vector<string> vImagePaths;
+    for(int i = 0; ; i++) {
+        std::ostringstream ss;
+        ss << dirPath << "/" << std::setw(6) << std::setfill('0') << i << ".png";
+        FILE* pFile = fopen(ss.str().c_str(), "rb");
+        if(!pFile) { break; }
+        fclose(pFile);
+        vImagePaths.push_back(ss.str());
+    }
+    if(vImagePaths.empty()) {
+        printf("No image found in %s.\n", dirPath.c_str());
+        return 1;
+    }
+
+    // 1. Sample oriented patches from the pipeline output, spread evenly over the sequence.
+    ImagePyramid imagePyramid(8, 1.2, 1000);
+    imagePyramid.enableBlurredPyramid();
+    KeyPointExtractor keyPointExtractor(imagePyramid.mnLevels, 30.0f, 19, imagePyramid.mnFeatures, 20, 7);
+    Distributor distributor;
+    OrientationComputer orientationComputer(15);
+
+    std::mt19937 rng(0);
+    int nPatchesPerImage = max(1, nMaxPatches / (int)vImagePaths.size());
+    vector<uchar> vPatches;
+    vector<vector<KeyPoint>> vvKeyPointsPerLevel, vvDistributedKeyPointsPerLevel;
+    for(const string& imagePath : vImagePaths) {
+        Mat image = imread(imagePath, 0);
+        if(image.empty()) { continue; }
+        imagePyramid.setImage(image);
+        keyPointExtractor.extract(vvKeyPointsPerLevel, imagePyramid.mvImages);
+        distributor.distribute(vvDistributedKeyPointsPerLevel, vvKeyPointsPerLevel, imagePyramid.mvnFeaturesPerLevel, imagePyramid.mvImages);
+        orientationComputer.compute(vvDistributedKeyPointsPerLevel, imagePyramid.mvImages);
+
+        vector<pair<int, int>> vKeyPointIndices; // (level, index)
+        for(int iLevel = 0; iLevel < imagePyramid.mnLevels; iLevel++)
+            for(int i = 0; i < (int)vvDistributedKeyPointsPerLevel[iLevel].size(); i++)
+                vKeyPointIndices.push_back({iLevel, i});
+        shuffle(vKeyPointIndices.begin(), vKeyPointIndices.end(), rng);
+        vKeyPointIndices.resize(min((int)vKeyPointIndices.size(), nPatchesPerImage));
+
+        for(const pair<int, int>& index : vKeyPointIndices) {
+            vPatches.resize(vPatches.size() + GRID_SIZE * GRID_SIZE);
+            samplePatch(
+                vvDistributedKeyPointsPerLevel[index.first][index.second], imagePyramid.mvBlurredImages[index.first],
+                &vPatches[vPatches.size() - GRID_SIZE * GRID_SIZE]
+            );
+        }
+    }
+    int nPatches = vPatches.size() / (GRID_SIZE * GRID_SIZE);
+    printf("%d patches from %zu images\n", nPatches, vImagePaths.size());
+    if(nPatches < 64) {
+        printf("Too few patches to learn a pattern.\n");
+        return 1;
+    }
+
+    // 2. Candidate tests: the ORB pairs, then random distinct pairs of grid points.
+    vector<array<int8_t, 4>> vCandidates;
+    for(int i = 0; i < ORBPattern::nPairs; i++) {
+        const int8_t* p = &ORBPattern::mPattern[4 * i];
+        vCandidates.push_back({p[0], p[1], p[2], p[3]});
+    }
+    std::uniform_int_distribution<int> coordinate(-HALF_SIZE, HALF_SIZE);
+    while((int)vCandidates.size() < max(nCandidates, nBits)) {
+        array<int8_t, 4> candidate = {(int8_t)coordinate(rng), (int8_t)coordinate(rng), (int8_t)coordinate(rng), (int8_t)coordinate(rng)};
+        if(candidate[0] != candidate[2] || candidate[1] != candidate[3]) { vCandidates.push_back(candidate); }
+    }
+    int nTests = vCandidates.size();
+
+    // Bits of every test over all patches, and their means.
+    int nWords = (nPatches + 63) / 64;
+    vector<vector<uint64_t>> vvnBits(nTests, vector<uint64_t>(nWords, 0));
+    vector<float> vfMeans(nTests);
+    for(int iTest = 0; iTest < nTests; iTest++) {
+        const array<int8_t, 4>& test = vCandidates[iTest];
+        int iFirst = (test[1] + HALF_SIZE) * GRID_SIZE + test[0] + HALF_SIZE;
+        int iSecond = (test[3] + HALF_SIZE) * GRID_SIZE + test[2] + HALF_SIZE;
+        long nOnes = 0;
+        for(int iPatch = 0; iPatch < nPatches; iPatch++) {
+            const uchar* pPatch = &vPatches[iPatch * GRID_SIZE * GRID_SIZE];
+            if(pPatch[iFirst] < pPatch[iSecond]) { // the same comparison as the descriptor
+                vvnBits[iTest][iPatch / 64] |= 1ull << (iPatch % 64);
+                nOnes++;
+            }
+        }
+        vfMeans[iTest] = (float)nOnes / nPatches;
+    }
+
+    // 3. Greedy selection of uncorrelated tests, the most balanced first.
+    vector<int> vnOrder(nTests);
+    for(int i = 0; i < nTests; i++) { vnOrder[i] = i; }
+    stable_sort(vnOrder.begin(), vnOrder.end(), [&vfMeans](int i, int j) {
+        return fabsf(vfMeans[i] - 0.5f) < fabsf(vfMeans[j] - 0.5f);
+    });
+
+    vector<int> vnSelected;
+    float fThreshold = 0.2f;
+    for(; fThreshold <= 1.f; fThreshold += 0.05f) {
+        vnSelected.clear();
+        for(int iTest : vnOrder) {
+            bool bCorrelated = false;
+            for(int iSelected : vnSelected) {
+                float fCorrelation = computeCorrelation(vvnBits[iTest], vvnBits[iSelected], vfMeans[iTest], vfMeans[iSelected], nPatches);
+                if(fabsf(fCorrelation) >= fThreshold) { bCorrelated = true; break; }
+            }
+            if(!bCorrelated) { vnSelected.push_back(iTest); }
+            if((int)vnSelected.size() == nBits) { break; }
+        }
+        if((int)vnSelected.size() == nBits) { break; }
+    }
+    if((int)vnSelected.size() < nBits) {
+        printf("Only %zu uncorrelated tests found, more candidates are needed.\n", vnSelected.size());
+        return 1;
+    }
+
+    // Compare the learned pattern with the ORB pairs on the same patches.
+    auto describeTests = [&](const char* pName, const vector<int>& vnTests) {
+        double dMeanDeviation = 0.0, dCorrelation = 0.0;
+        long nPairs = 0;
+        for(size_t i = 0; i < vnTests.size(); i++) {
+            dMeanDeviation += fabsf(vfMeans[vnTests[i]] - 0.5f);
+            for(size_t j = 0; j < i; j++, nPairs++)
+                dCorrelation += fabsf(computeCorrelation(vvnBits[vnTests[i]], vvnBits[vnTests[j]], vfMeans[vnTests[i]], vfMeans[vnTests[j]], nPatches));
+        }
+        printf(
+            " - %s: mean |mean - 0.5| %.4f, mean |correlation| %.4f\n",
+            pName, dMeanDeviation / vnTests.size(), dCorrelation / max(nPairs, 1L)
+        );
+    };
+    vector<int> vnORBTests;
+    for(int i = 0; i < min(nBits, ORBPattern::nPairs); i++) { vnORBTests.push_back(i); }
+    printf("%d tests kept at correlation threshold %.2f from %d candidates: \n", nBits, fThreshold, nTests);
+    describeTests("ORB pattern", vnORBTests);
+    describeTests("learned pattern", vnSelected);
+
+    vector<int8_t> vPattern;
+    for(int iTest : vnSelected)
+        vPattern.insert(vPattern.end(), vCandidates[iTest].begin(), vCandidates[iTest].end());
+    if(!DescriptorComputerBase::savePattern(patternPath, vPattern)) {
+        printf("Cannot write %s.\n", patternPath.c_str());
+        return 1;
+    }
+    printf("Pattern written to %s\n", patternPath.c_str());
+    return 0;
+}